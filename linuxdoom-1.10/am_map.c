@@ -213,7 +213,7 @@ mline_t thintriangle_guy[] = {
 
 
 
-static int 	cheating = 0;
+static VIEWLOCAL int 	cheating = 0;
 static int 	grid = 0;
 
 static int 	leveljuststarted = 1; 	// kluge until AM_LevelInit() is called
@@ -223,46 +223,46 @@ static int 	finit_width = SCREENWIDTH;
 static int 	finit_height = SCREENHEIGHT - 32;
 
 // location of window on screen
-static int 	f_x;
-static int	f_y;
+static VIEWLOCAL int 	f_x;
+static VIEWLOCAL int	f_y;
 
 // size of window on screen
-static int 	f_w;
-static int	f_h;
+static VIEWLOCAL int 	f_w;
+static VIEWLOCAL int	f_h;
 
-static int 	lightlev; 		// used for funky strobing effect
-static byte*	fb; 			// pseudo-frame buffer
+static VIEWLOCAL int 	lightlev; 		// used for funky strobing effect
+static VIEWLOCAL byte*	fb; 			// pseudo-frame buffer
 static int 	amclock;
 
 static mpoint_t m_paninc; // how far the window pans each tic (map coords)
 static fixed_t 	mtof_zoommul; // how far the window zooms in each tic (map coords)
 static fixed_t 	ftom_zoommul; // how far the window zooms in each tic (fb coords)
 
-static fixed_t 	m_x, m_y;   // LL x,y where the window is on the map (map coords)
-static fixed_t 	m_x2, m_y2; // UR x,y where the window is on the map (map coords)
+static VIEWLOCAL fixed_t 	m_x, m_y;   // LL x,y where the window is on the map (map coords)
+static VIEWLOCAL fixed_t 	m_x2, m_y2; // UR x,y where the window is on the map (map coords)
 
 //
 // width/height of window on map (map coords)
 //
-static fixed_t 	m_w;
-static fixed_t	m_h;
+static VIEWLOCAL fixed_t 	m_w;
+static VIEWLOCAL fixed_t	m_h;
 
 // based on level size
-static fixed_t 	min_x;
-static fixed_t	min_y; 
-static fixed_t 	max_x;
-static fixed_t  max_y;
+static VIEWLOCAL fixed_t 	min_x;
+static VIEWLOCAL fixed_t	min_y; 
+static VIEWLOCAL fixed_t 	max_x;
+static VIEWLOCAL fixed_t  max_y;
 
-static fixed_t 	max_w; // max_x-min_x,
-static fixed_t  max_h; // max_y-min_y
+static VIEWLOCAL fixed_t 	max_w; // max_x-min_x,
+static VIEWLOCAL fixed_t  max_h; // max_y-min_y
 
 // based on player size
-static fixed_t 	min_w;
-static fixed_t  min_h;
+static VIEWLOCAL fixed_t 	min_w;
+static VIEWLOCAL fixed_t  min_h;
 
 
-static fixed_t 	min_scale_mtof; // used to tell when to stop zooming out
-static fixed_t 	max_scale_mtof; // used to tell when to stop zooming in
+static VIEWLOCAL fixed_t 	min_scale_mtof; // used to tell when to stop zooming out
+static VIEWLOCAL fixed_t 	max_scale_mtof; // used to tell when to stop zooming in
 
 // old stuff for recovery later
 static fixed_t old_m_w, old_m_h;
@@ -272,11 +272,11 @@ static fixed_t old_m_x, old_m_y;
 static mpoint_t f_oldloc;
 
 // used by MTOF to scale from map-to-frame-buffer coords
-static fixed_t scale_mtof = INITSCALEMTOF;
+static VIEWLOCAL fixed_t scale_mtof = INITSCALEMTOF;
 // used by FTOM to scale from frame-buffer-to-map coords (=1/scale_mtof)
-static fixed_t scale_ftom;
+static VIEWLOCAL fixed_t scale_ftom;
 
-static player_t *plr; // the player represented by an arrow
+static VIEWLOCAL player_t *plr; // the player represented by an arrow
 
 static patch_t *marknums[10]; // numbers used for marking by the automap
 static mpoint_t markpoints[AM_NUMMARKPOINTS]; // where the points are
@@ -1057,7 +1057,7 @@ AM_drawMline
 ( mline_t*	ml,
   int		color )
 {
-    static fline_t fl;
+    static VIEWLOCAL fline_t fl;
 
     if (AM_clipMline(ml, &fl))
 	AM_drawFline(&fl, color); // draws it on frame buffer using fb coords
@@ -1117,7 +1117,7 @@ void AM_drawGrid(int color)
 void AM_drawWalls(void)
 {
     int i;
-    static mline_t l;
+    static VIEWLOCAL mline_t l;
 
     for (i=0;i<numlines;i++)
     {
@@ -1347,3 +1347,51 @@ void AM_Drawer (void)
     V_MarkRect(f_x, f_y, f_w, f_h);
 
 }
+
+
+//
+// AM_DrawThumbnail
+// The automap around x,y at scale (pixels per map unit,
+//  0 fits the whole level) into a width*height buffer.
+// All lines are shown, as with the map cheat.
+// Uses only this thread's automap state, so any thread
+//  can draw one while the playsim is stopped.
+//
+void
+AM_DrawThumbnail
+( byte*		buffer,
+  int		width,
+  int		height,
+  fixed_t	x,
+  fixed_t	y,
+  fixed_t	scale )
+{
+    fb = buffer;
+    f_x = f_y = 0;
+    f_w = width;
+    f_h = height;
+    cheating = 1;
+    plr = &players[consoleplayer];
+
+    if (!scale)
+    {
+	AM_findMinMaxBoundaries();
+	scale = min_scale_mtof;
+	x = min_x + max_w/2;
+	y = min_y + max_h/2;
+    }
+
+    scale_mtof = scale;
+    scale_ftom = FixedDiv(FRACUNIT, scale_mtof);
+    m_w = FTOM(f_w);
+    m_h = FTOM(f_h);
+    m_x = x - m_w/2;
+    m_y = y - m_h/2;
+    m_x2 = m_x + m_w;
+    m_y2 = m_y + m_h;
+
+    AM_clearFB(BACKGROUND);
+    AM_drawWalls();
+    AM_drawPlayers();
+    AM_drawCrosshair(XHAIRCOLORS);
+}
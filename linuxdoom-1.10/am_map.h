@@ -42,6 +42,16 @@ void AM_Drawer (void);
 // if the level is completed while it is up.
 void AM_Stop (void);
 
+// Draws the map into a buffer of its own, see G_QueueThumbnail.
+void
+AM_DrawThumbnail
+( byte*		buffer,
+  int		width,
+  int		height,
+  fixed_t	x,
+  fixed_t	y,
+  fixed_t	scale );
+
 
 
 #endif
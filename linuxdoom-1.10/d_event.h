@@ -108,6 +108,7 @@ typedef enum
 #define MAXEVENTS		64
 
 extern  event_t		events[MAXEVENTS];
+extern  int		eventtime[MAXEVENTS];
 extern  int             eventhead;
 extern	int		eventtail;
 
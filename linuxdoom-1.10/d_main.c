@@ -63,8 +63,16 @@ static const char rcsid[] = "$Id: d_main.c,v 1.8 1997/02/03 22:45:09 b1 Exp $";
 #include "i_system.h"
 #include "i_sound.h"
 #include "i_video.h"
+#include "i_perf.h"
 
 #include "g_game.h"
+#include "g_rewind.h"
+#include "m_capture.h"
+#include "g_stats.h"
+#include "g_render.h"
+#include "r_view.h"
+#include "p_query.h"
+#include "g_thumb.h"
 
 #include "hu_stuff.h"
 #include "wi_stuff.h"
@@ -138,10 +146,22 @@ void D_DoAdvanceDemo (void);
 // Events are asynchronous inputs generally generated by the game user.
 // Events can be discarded if no responder claims them
 //
+// The ring has one producer, D_PostEvent, which may run on the
+//  input thread, and one consumer, D_GetEvent, on the game thread.
+// Only the producer writes eventhead and only the consumer eventtail,
+//  so no lock is needed, just ordered loads and stores.
+//
 event_t         events[MAXEVENTS];
+int		eventtime[MAXEVENTS];	// I_GetTimeUS when posted
 int             eventhead;
 int 		eventtail;
 
+// input to tic latency, see D_EventReport
+static int	eventcount;
+static int	eventlatency;
+static int	eventmaxlatency;
+static int	eventdropped;
+
 
 //
 // D_PostEvent
@@ -149,8 +169,65 @@ int 		eventtail;
 //
 void D_PostEvent (event_t* ev)
 {
-    events[eventhead] = *ev;
-    eventhead = (++eventhead)&(MAXEVENTS-1);
+    int		head;
+    int		next;
+
+    head = eventhead;
+    next = (head+1)&(MAXEVENTS-1);
+
+    // full, the game has stopped reading
+    if (next == __atomic_load_n (&eventtail, __ATOMIC_ACQUIRE))
+    {
+	eventdropped++;
+	return;
+    }
+
+    events[head] = *ev;
+    eventtime[head] = I_GetTimeUS ();
+    __atomic_store_n (&eventhead, next, __ATOMIC_RELEASE);
+}
+
+
+//
+// D_GetEvent
+// Takes the oldest event, false if there is none.
+// Called just before G_BuildTiccmd, so the time since
+//  D_PostEvent is how old the input is when it goes in a tic.
+//
+boolean D_GetEvent (event_t* ev)
+{
+    int		tail;
+    int		latency;
+
+    tail = eventtail;
+    if (tail == __atomic_load_n (&eventhead, __ATOMIC_ACQUIRE))
+	return false;
+
+    *ev = events[tail];
+    latency = I_GetTimeUS () - eventtime[tail];
+    __atomic_store_n (&eventtail, (tail+1)&(MAXEVENTS-1), __ATOMIC_RELEASE);
+
+    eventcount++;
+    eventlatency += latency;
+    if (latency > eventmaxlatency)
+	eventmaxlatency = latency;
+    return true;
+}
+
+
+//
+// D_EventReport
+// Called by I_Quit.
+//
+void D_EventReport (void)
+{
+    if (!eventcount)
+	return;
+
+    printf ("D_GetEvent: %i events, input to tic %i us average, "
+	    "%i us max, %i dropped\n",
+	    eventcount, eventlatency/eventcount, eventmaxlatency,
+	    eventdropped);
 }
 
 
@@ -160,19 +237,18 @@ void D_PostEvent (event_t* ev)
 //
 void D_ProcessEvents (void)
 {
-    event_t*	ev;
+    event_t	ev;
 	
     // IF STORE DEMO, DO NOT ACCEPT INPUT
     if ( ( gamemode == commercial )
 	 && (W_CheckNumForName("map01")<0) )
       return;
 	
-    for ( ; eventtail != eventhead ; eventtail = (++eventtail)&(MAXEVENTS-1) )
+    while (D_GetEvent (&ev))
     {
-	ev = &events[eventtail];
-	if (M_Responder (ev))
+	if (M_Responder (&ev))
 	    continue;               // menu ate the event
-	G_Responder (ev);
+	G_Responder (&ev);
     }
 }
 
@@ -265,7 +341,11 @@ void D_Display (void)
     
     // draw the view directly
     if (gamestate == GS_LEVEL && !automapactive && gametic)
+    {
+	I_BeginPerf (perf_frame);
 	R_RenderPlayerView (&players[displayplayer]);
+	I_EndPerf (perf_frame);
+    }
 
     if (gamestate == GS_LEVEL && gametic)
 	HU_Drawer ();
@@ -370,6 +450,8 @@ void D_DoomLoop (void)
     {
 	// frame syncronous IO operations
 	I_StartFrame ();                
+	Z_LogStats ();
+	M_PollDefaults ();
 	
 	// process one or more tics
 	if (singletics)
@@ -393,6 +475,8 @@ void D_DoomLoop (void)
 
 	// Update display, next frame, with current state.
 	D_Display ();
+	M_CaptureTicker ();
+	G_ThumbnailTicker ();
 
 #ifndef SNDSERV
 	// Sound mixing for the buffer is snychronous.
@@ -1097,6 +1181,11 @@ void D_DoomMain (void)
     printf ("\nP_Init: Init Playloop state.\n");
     P_Init ();
 
+    // headless modes run without an audio device
+    if (M_CheckParm ("-analyze") || M_CheckParm ("-render")
+	|| M_CheckParm ("-viewbench") || M_CheckParm ("-querytest"))
+	nosounddevice = true;
+
     printf ("I_Init: Setting up machine state.\n");
     I_Init ();
 
@@ -1112,6 +1201,30 @@ void D_DoomMain (void)
     printf ("ST_Init: Init status bar.\n");
     ST_Init ();
 
+    G_InitRewind ();
+
+    // headless demo analysis
+    p = M_CheckParm ("-analyze");
+    if (p && p < myargc-1)
+	G_AnalyzeDemos (p);	// never returns
+
+    // demo to video, faster than real time
+    p = M_CheckParm ("-render");
+    if (p && p < myargc-2)
+	G_RenderDemo (p);	// never returns
+
+    // several views at once, timed
+    p = M_CheckParm ("-viewbench");
+    if (p && p < myargc-1)
+	R_ViewBenchmark (p);	// never returns
+
+    // map queries on threads, checked
+    p = M_CheckParm ("-querytest");
+    if (p && p < myargc-1)
+	P_QueryTest (p);	// never returns
+
+    M_InitCapture ();
+
     // check for a driver that wants intermission stats
     p = M_CheckParm ("-statcopy");
     if (p && p<myargc-1)
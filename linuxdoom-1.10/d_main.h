@@ -51,6 +51,12 @@ void D_DoomMain (void);
 // Called by IO functions when input is detected.
 void D_PostEvent (event_t* ev);
 
+// Next event for the responders, false if none.
+boolean D_GetEvent (event_t* ev);
+
+// Prints input to tic latency.
+void D_EventReport (void);
+
 	
 
 //
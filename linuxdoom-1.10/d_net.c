@@ -27,6 +27,7 @@ static const char rcsid[] = "$Id: d_net.c,v 1.3 1997/02/03 22:01:47 b1 Exp $";
 
 
 #include "m_menu.h"
+#include "d_main.h"
 #include "i_system.h"
 #include "i_video.h"
 #include "i_net.h"
@@ -452,7 +453,7 @@ void NetUpdate (void)
 //
 void CheckAbort (void)
 {
-    event_t *ev;
+    event_t	ev;
     int		stoptic;
 	
     stoptic = I_GetTime () + 2; 
@@ -460,11 +461,9 @@ void CheckAbort (void)
 	I_StartTic (); 
 	
     I_StartTic ();
-    for ( ; eventtail != eventhead 
-	      ; eventtail = (++eventtail)&(MAXEVENTS-1) ) 
+    while (D_GetEvent (&ev))
     { 
-	ev = &events[eventtail]; 
-	if (ev->type == ev_keydown && ev->data1 == KEY_ESCAPE)
+	if (ev.type == ev_keydown && ev.data1 == KEY_ESCAPE)
 	    I_Error ("Network game synchronization aborted.");
     } 
 }
@@ -112,6 +112,11 @@ typedef enum
 #define SCREENHEIGHT 200
 //(int)(SCREEN_MUL*BASE_WIDTH*INV_ASPECT_RATIO) //200
 
+// Refresh state that belongs to one view.
+// Every thread that renders has its own copy,
+//  see R_RenderViews.
+#define VIEWLOCAL	__thread
+
 
 
 
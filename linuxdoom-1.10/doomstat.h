@@ -139,11 +139,11 @@ extern  boolean		viewactive;
 extern  boolean		nodrawers;
 extern  boolean		noblit;
 
-extern	int		viewwindowx;
-extern	int		viewwindowy;
-extern	int		viewheight;
-extern	int		viewwidth;
-extern	int		scaledviewwidth;
+extern VIEWLOCAL int		viewwindowx;
+extern VIEWLOCAL int		viewwindowy;
+extern VIEWLOCAL int		viewheight;
+extern VIEWLOCAL int		viewwidth;
+extern VIEWLOCAL int		scaledviewwidth;
 
 
 
@@ -37,6 +37,7 @@ rcsid[] = "$Id: g_game.c,v 1.8 1997/02/03 22:45:09 b1 Exp $";
 #include "m_menu.h"
 #include "m_random.h"
 #include "i_system.h"
+#include "i_perf.h"
 
 #include "p_setup.h"
 #include "p_saveg.h"
@@ -69,6 +70,8 @@ rcsid[] = "$Id: g_game.c,v 1.8 1997/02/03 22:45:09 b1 Exp $";
 
 
 #include "g_game.h"
+#include "g_rewind.h"
+#include "g_stats.h"
 
 
 #define SAVEGAMESIZE	0x2c000
@@ -207,8 +210,6 @@ int		savegameslot;
 char		savedescription[32]; 
  
  
-#define	BODYQUESIZE	32
-
 mobj_t*		bodyque[BODYQUESIZE]; 
 int		bodyqueslot; 
  
@@ -481,6 +482,7 @@ void G_DoLoadLevel (void)
 	memset (players[i].frags,0,sizeof(players[i].frags)); 
     } 
 		 
+    G_RewindClear ();
     P_SetupLevel (gameepisode, gamemap, 0, gameskill);    
     displayplayer = consoleplayer;		// view the guy you are playing    
     starttime = I_GetTime (); 
@@ -517,6 +519,10 @@ boolean G_Responder (event_t* ev)
 	return true; 
     }
     
+    // arrow keys scrub a demo when rewind is on
+    if (gamestate == GS_LEVEL && demoplayback && G_RewindResponder (ev))
+	return true;
+
     // any other key pops up menu if in demos
     if (gameaction == ga_nothing && !singledemo && 
 	(demoplayback || gamestate == GS_DEMOSCREEN) 
@@ -602,11 +608,51 @@ boolean G_Responder (event_t* ev)
 // G_Ticker
 // Make ticcmd_ts for the players.
 //
+//
+// G_HotReload
+// Lumps of the reloadable file are picked up as they are
+//  saved. Textures, sprites and flats are redone in place,
+//  and so are sector, side and line properties; any other
+//  change to the level in play loads it again.
+//
+void G_HotReload (void)
+{
+    int*	changed;
+    int		count;
+    int		start;
+    boolean	reload;
+    int		i;
+
+    count = W_PollReload (&changed);
+    if (!count)
+	return;
+
+    start = I_GetTimeUS ();
+    reload = false;
+    for (i=0 ; i<count ; i++)
+    {
+	R_ReloadLump (changed[i]);
+	if (gamestate == GS_LEVEL && !P_ReloadMapLump (changed[i]))
+	    reload = true;
+    }
+
+    if (reload)
+	gameaction = ga_loadlevel;
+    printf ("G_HotReload: %i lumps changed, %s in %i us\n", count,
+	    reload ? "loading the level again" : "updated",
+	    I_GetTimeUS () - start);
+}
+
+
 void G_Ticker (void) 
 { 
     int		i;
     int		buf; 
     ticcmd_t*	cmd;
+
+    // pick up edits to a -file ~map.wad
+    if (!netgame && !demoplayback && !demorecording)
+	G_HotReload ();
     
     // do player reborns if needed
     for (i=0 ; i<MAXPLAYERS ; i++) 
@@ -727,10 +773,14 @@ void G_Ticker (void)
     switch (gamestate) 
     { 
       case GS_LEVEL: 
+	I_BeginPerf (perf_tic);
 	P_Ticker (); 
+	I_EndPerf (perf_tic);
 	ST_Ticker (); 
 	AM_Ticker (); 
 	HU_Ticker ();            
+	G_RewindTicker ();
+	G_StatsTicker ();
 	break; 
 	 
       case GS_INTERMISSION: 
@@ -1197,6 +1247,10 @@ void G_LoadGame (char* name)
  
 #define VERSIONSIZE		16 
 
+// Savegames hold raw mobj_t, so their layout moves on
+//  apart from the demo VERSION. 111 added the type links.
+#define SAVEVERSION		111
+
 
 void G_DoLoadGame (void) 
 { 
@@ -1204,15 +1258,17 @@ void G_DoLoadGame (void)
     int		i; 
     int		a,b,c; 
     char	vcheck[VERSIONSIZE]; 
+    int		start;
 	 
     gameaction = ga_nothing; 
+    start = I_GetTimeUS ();
 	 
     length = M_ReadFile (savename, &savebuffer); 
     save_p = savebuffer + SAVESTRINGSIZE;
     
     // skip the description field 
     memset (vcheck,0,sizeof(vcheck)); 
-    sprintf (vcheck,"version %i",VERSION); 
+    sprintf (vcheck,"version %i",SAVEVERSION); 
     if (strcmp (save_p, vcheck)) 
 	return;				// bad version 
     save_p += VERSIONSIZE; 
@@ -1223,7 +1279,8 @@ void G_DoLoadGame (void)
     for (i=0 ; i<MAXPLAYERS ; i++) 
 	playeringame[i] = *save_p++; 
 
-    // load a base level 
+    // load a base level, keeping the map if it is still in memory
+    reuselevel = gamestate == GS_LEVEL && !M_CheckParm ("-noquickload");
     G_InitNew (gameskill, gameepisode, gamemap); 
  
     // get the times 
@@ -1243,6 +1300,10 @@ void G_DoLoadGame (void)
     
     // done 
     Z_Free (savebuffer); 
+
+    printf ("G_DoLoadGame: %s in %i us (level %s)\n", savename,
+	    I_GetTimeUS () - start, reuselevel ? "kept" : "reloaded");
+    reuselevel = false;
  
     if (setsizeneeded)
 	R_ExecuteSetViewSize ();
@@ -1286,7 +1347,7 @@ void G_DoSaveGame (void)
     memcpy (save_p, description, SAVESTRINGSIZE); 
     save_p += SAVESTRINGSIZE; 
     memset (name2,0,sizeof(name2)); 
-    sprintf (name2,"version %i",VERSION); 
+    sprintf (name2,"version %i",SAVEVERSION); 
     memcpy (save_p, name2, VERSIONSIZE); 
     save_p += VERSIONSIZE; 
 	 
@@ -1485,8 +1546,6 @@ G_InitNew
 //
 // DEMO RECORDING 
 // 
-#define DEMOMARKER		0x80
-
 
 void G_ReadDemoTiccmd (ticcmd_t* cmd) 
 { 
@@ -1580,17 +1639,26 @@ void G_DeferedPlayDemo (char* name)
 } 
  
 void G_DoPlayDemo (void) 
+{ 
+    gameaction = ga_nothing; 
+    G_PlayDemoBuffer (W_CacheLumpName (defdemoname, PU_STATIC));
+} 
+
+//
+// G_PlayDemoBuffer
+// Starts playback of a demo already in memory.
+//
+boolean G_PlayDemoBuffer (byte* buffer) 
 { 
     skill_t skill; 
     int             i, episode, map; 
 	 
-    gameaction = ga_nothing; 
-    demobuffer = demo_p = W_CacheLumpName (defdemoname, PU_STATIC); 
+    demobuffer = demo_p = buffer; 
     if ( *demo_p++ != VERSION)
     {
       fprintf( stderr, "Demo is from a different game version!\n");
       gameaction = ga_nothing;
-      return;
+      return false;
     }
     
     skill = *demo_p++; 
@@ -1617,6 +1685,7 @@ void G_DoPlayDemo (void)
 
     usergame = false; 
     demoplayback = true; 
+    return true;
 } 
 
 //
@@ -1651,12 +1720,16 @@ boolean G_CheckDemoStatus (void)
     if (timingdemo) 
     { 
 	endtime = I_GetTime (); 
+	I_PerfReport ();
+	I_MemoryReport ();
+	W_ReadReport ();
 	I_Error ("timed %i gametics in %i realtics",gametic 
 		 , endtime-starttime); 
     } 
 	 
     if (demoplayback) 
     { 
+	G_RewindClear ();
 	if (singledemo) 
 	    I_Quit (); 
 			 
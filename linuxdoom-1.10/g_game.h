@@ -25,6 +25,7 @@
 
 #include "doomdef.h"
 #include "d_event.h"
+#include "d_ticcmd.h"
 
 
 
@@ -60,12 +61,22 @@ void G_PlayDemo (char* name);
 void G_TimeDemo (char* name);
 boolean G_CheckDemoStatus (void);
 
+// Demo stream, also walked by the rewind code.
+#define DEMOMARKER		0x80
+
+extern byte*	demobuffer;
+extern byte*	demo_p;
+
+void G_ReadDemoTiccmd (ticcmd_t* cmd);
+boolean G_PlayDemoBuffer (byte* buffer);
+
 void G_ExitLevel (void);
 void G_SecretExitLevel (void);
 
 void G_WorldDone (void);
 
 void G_Ticker (void);
+void G_HotReload (void);
 boolean G_Responder (event_t*	ev);
 
 void G_ScreenShot (void);
@@ -0,0 +1,113 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Demo to video, faster than real time.
+//	  doom -render demo.lmp out.avi [-jobs n]
+//	The demo is replayed without a window, every tic is drawn
+//	into screens[0] and mixed into one tic of sound, and both
+//	go to the encoder threads of m_capture.c, -jobs of them
+//	(all but one processor by default).
+//	The video is an uncompressed AVI, 320x200 at 35 fps with
+//	11025 Hz stereo sound; nothing is shown or played.
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "i_sound.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "m_capture.h"
+
+#include "s_sound.h"
+
+#include "g_game.h"
+#include "g_render.h"
+
+
+extern	gamestate_t	wipegamestate;
+extern	byte*		demo_p;
+
+void D_Display (void);
+
+
+//
+// G_RenderDemo
+//
+void G_RenderDemo (int arg)
+{
+    short	audio[CAPTURESAMPLES*2];
+    byte*	buffer;
+    int		length;
+    int		jobs;
+    int		frames;
+    int		start;
+    int		time;
+    int		p;
+
+    jobs = sysconf (_SC_NPROCESSORS_ONLN) - 1;
+    p = M_CheckParm ("-jobs");
+    if (p && p < myargc-1)
+	jobs = atoi (myargv[p+1]);
+    if (jobs < 1)
+	jobs = 1;
+
+    length = M_ReadFile (myargv[arg+1], &buffer);
+    I_MixLocal ();
+    M_StartRender (myargv[arg+2], jobs);
+
+    if (!G_PlayDemoBuffer (buffer))
+	I_Error ("G_RenderDemo: can't play %s", myargv[arg+1]);
+
+    start = I_GetTimeUS ();
+    frames = 0;
+    while (demo_p < buffer+length && *demo_p != DEMOMARKER)
+    {
+	G_Ticker ();
+	gametic++;
+
+	S_UpdateSounds (players[consoleplayer].mo);
+
+	// a wipe runs on the real clock, cut straight over
+	wipegamestate = gamestate;
+	D_Display ();
+
+	I_MixSound (audio, CAPTURESAMPLES);
+	M_CaptureFrame (audio, CAPTURESAMPLES);
+	frames++;
+    }
+
+    M_FinishCapture ();
+
+    time = (I_GetTimeUS () - start)/1000;
+    if (!time)
+	time = 1;
+    printf ("G_RenderDemo: %i frames in %i ms, %i fps\n",
+	    frames, time, frames*1000/time);
+    exit (0);
+}
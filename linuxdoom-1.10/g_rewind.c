@@ -0,0 +1,363 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Demo rewind. Every few tics of demo playback the level
+//	is snapshotted into a ring (P_ArchiveSnapshot). To show
+//	an earlier tic, the nearest snapshot before it is restored
+//	and the demo ticcmds in between are run again, so any tic
+//	is at most one snapshot interval of playsim away.
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "m_argv.h"
+
+#include "p_local.h"
+#include "p_saveg.h"
+#include "p_tick.h"
+
+#include "g_game.h"
+#include "g_rewind.h"
+
+
+#define MAXREWINDSLOTS	256
+
+// arrow keys jump this far
+#define REWINDSTEP	(5*TICRATE)
+
+typedef struct
+{
+    int		leveltic;	// leveltime when taken
+    int		gametic;	// gametic of the tic just run
+    int		demooffset;	// demo_p - demobuffer
+    int		length;		// bytes used
+    int		alloced;	// bytes malloced
+    byte*	data;
+    
+} rewindslot_t;
+
+
+boolean		rewindactive;
+
+static int		rewindinterval = TICRATE;
+static int		rewindnumslots = 64;
+static int		rewindmaxbytes = 32*1024*1024;
+
+static rewindslot_t	rewindslots[MAXREWINDSLOTS];
+static int		rewindhead;	// oldest snapshot
+static int		rewindcount;
+static int		rewindbytes;	// malloced over all slots
+
+// for G_RewindReport
+static int		snapcount;
+static int		snapskipped;
+static int		snaptime;
+static int		snapmaxtime;
+static int		snappeakbytes;
+static int		restorecount;
+static int		restoretime;
+static int		resimtics;
+
+
+void G_DoReborn (int playernum);
+
+
+//
+// G_InitRewind
+//
+void G_InitRewind (void)
+{
+    int		p;
+
+    p = M_CheckParm ("-rewind");
+    if (!p)
+	return;
+
+    rewindactive = true;
+    if (p < myargc-1 && atoi (myargv[p+1]) > 0)
+	rewindinterval = atoi (myargv[p+1]);
+
+    p = M_CheckParm ("-rewindslots");
+    if (p && p < myargc-1)
+	rewindnumslots = atoi (myargv[p+1]);
+    if (rewindnumslots < 2)
+	rewindnumslots = 2;
+    if (rewindnumslots > MAXREWINDSLOTS)
+	rewindnumslots = MAXREWINDSLOTS;
+
+    p = M_CheckParm ("-rewindmem");
+    if (p && p < myargc-1)
+	rewindmaxbytes = atoi (myargv[p+1])*1024;
+
+    printf ("G_InitRewind: snapshot every %i tics, %i slots, %i KB cap.\n",
+	    rewindinterval, rewindnumslots, rewindmaxbytes/1024);
+}
+
+
+//
+// G_RewindReport
+//
+void G_RewindReport (void)
+{
+    if (!rewindactive || !snapcount)
+	return;
+
+    printf ("G_Rewind: %i snapshots (%i skipped), avg %i us, max %i us, "
+	    "%i KB held, peak %i KB of %i KB\n",
+	    snapcount, snapskipped, snaptime/snapcount, snapmaxtime,
+	    rewindbytes/1024, snappeakbytes/1024, rewindmaxbytes/1024);
+
+    if (restorecount)
+	printf ("G_Rewind: %i rewinds, avg %i us, %i tics resimulated\n",
+		restorecount, restoretime/restorecount, resimtics);
+}
+
+
+//
+// G_RewindClear
+// Snapshots are only valid on the level they were taken on.
+// The slot buffers are kept for the next level.
+//
+void G_RewindClear (void)
+{
+    if (!rewindactive)
+	return;
+
+    G_RewindReport ();
+    rewindhead = rewindcount = 0;
+}
+
+
+//
+// G_RewindSnapshot
+// Appends a snapshot of the current tic to the ring,
+//  evicting the oldest ones when the memory cap is hit.
+//
+static void G_RewindSnapshot (void)
+{
+    rewindslot_t*	slot;
+    int			need;
+    int			start;
+    int			time;
+
+    start = I_GetTimeUS ();
+
+    if (rewindcount == rewindnumslots)
+    {
+	rewindhead = (rewindhead+1)%rewindnumslots;
+	rewindcount--;
+    }
+    slot = &rewindslots[(rewindhead+rewindcount)%rewindnumslots];
+
+    need = P_SnapshotSize ();
+    if (need > slot->alloced)
+    {
+	// leave some slack so the buffer is not regrown every time
+	need += need>>3;
+
+	while (rewindcount
+	       && rewindbytes - slot->alloced + need > rewindmaxbytes)
+	{
+	    free (rewindslots[rewindhead].data);
+	    rewindbytes -= rewindslots[rewindhead].alloced;
+	    rewindslots[rewindhead].data = NULL;
+	    rewindslots[rewindhead].alloced = 0;
+	    rewindhead = (rewindhead+1)%rewindnumslots;
+	    rewindcount--;
+	}
+
+	if (rewindbytes - slot->alloced + need > rewindmaxbytes)
+	{
+	    snapskipped++;
+	    return;
+	}
+
+	free (slot->data);
+	rewindbytes -= slot->alloced;
+	slot->data = malloc (need);
+	if (!slot->data)
+	    I_Error ("G_RewindSnapshot: failed on allocation of %i bytes",
+		     need);
+	slot->alloced = need;
+	rewindbytes += need;
+	if (rewindbytes > snappeakbytes)
+	    snappeakbytes = rewindbytes;
+    }
+
+    save_p = slot->data;
+    P_ArchiveSnapshot ();
+    slot->length = save_p - slot->data;
+    slot->leveltic = leveltime;
+    slot->gametic = gametic;
+    slot->demooffset = demo_p - demobuffer;
+    rewindcount++;
+
+    time = I_GetTimeUS () - start;
+    snapcount++;
+    snaptime += time;
+    if (time > snapmaxtime)
+	snapmaxtime = time;
+}
+
+
+//
+// G_RewindTicker
+// Snapshots are taken on interval boundaries the ring has
+//  not seen yet, so after a rewind the later snapshots stay
+//  valid and scrubbing forward is just as cheap.
+//
+void G_RewindTicker (void)
+{
+    int		newest;
+
+    if (!rewindactive || !demoplayback || paused)
+	return;
+
+    if (leveltime % rewindinterval)
+	return;
+
+    if (rewindcount)
+    {
+	newest = (rewindhead+rewindcount-1)%rewindnumslots;
+	if (rewindslots[newest].leveltic >= leveltime)
+	    return;
+    }
+
+    G_RewindSnapshot ();
+}
+
+
+//
+// G_RewindToTic
+// The gametic the playsim sees is kept in step (A_Tracer
+//  looks at it), so the jump may land up to three tics past
+//  the requested one.
+//
+boolean G_RewindToTic (int tic)
+{
+    rewindslot_t*	slot;
+    int			i;
+    int			s;
+    int			start;
+    int			realgametic;
+    int			simgametic;
+    boolean		waspaused;
+
+    if (!rewindactive || !demoplayback || gamestate != GS_LEVEL)
+	return false;
+
+    if (tic < 0)
+	tic = 0;
+
+    start = I_GetTimeUS ();
+    realgametic = gametic;
+
+    // newest snapshot at or before the target
+    slot = NULL;
+    for (i=rewindcount-1 ; i>=0 ; i--)
+    {
+	s = (rewindhead+i)%rewindnumslots;
+	if (rewindslots[s].leveltic <= tic)
+	{
+	    slot = &rewindslots[s];
+	    break;
+	}
+    }
+
+    if (slot && (tic < leveltime || slot->leveltic > leveltime))
+    {
+	save_p = slot->data;
+	P_UnArchiveSnapshot ();
+	demo_p = demobuffer + slot->demooffset;
+	simgametic = slot->gametic;
+    }
+    else if (tic >= leveltime)
+    {
+	// nothing better than carrying on from here
+	simgametic = gametic-1;
+    }
+    else
+	return false;
+
+    // line up with the gametic of the next real tic
+    while ( ((simgametic + tic - leveltime + 1) & 3) != (realgametic & 3) )
+	tic++;
+
+    waspaused = paused;
+    paused = false;
+    while (leveltime < tic)
+    {
+	if (*demo_p == DEMOMARKER || gameaction != ga_nothing)
+	    break;
+
+	for (i=0 ; i<MAXPLAYERS ; i++)
+	    if (playeringame[i] && players[i].playerstate == PST_REBORN)
+		G_DoReborn (i);
+
+	gametic = ++simgametic;
+	for (i=0 ; i<MAXPLAYERS ; i++)
+	    if (playeringame[i])
+		G_ReadDemoTiccmd (&players[i].cmd);
+
+	P_Ticker ();
+	resimtics++;
+	G_RewindTicker ();
+    }
+    paused = waspaused;
+    gametic = realgametic;
+
+    restorecount++;
+    restoretime += I_GetTimeUS () - start;
+
+    printf ("G_Rewind: at tic %i, %i us\n",
+	    leveltime, I_GetTimeUS () - start);
+    return true;
+}
+
+
+//
+// G_RewindResponder
+//
+boolean G_RewindResponder (event_t* ev)
+{
+    if (!rewindactive || ev->type != ev_keydown)
+	return false;
+
+    switch (ev->data1)
+    {
+      case KEY_LEFTARROW:
+	G_RewindToTic (leveltime - REWINDSTEP);
+	return true;
+
+      case KEY_RIGHTARROW:
+	G_RewindToTic (leveltime + REWINDSTEP);
+	return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,58 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Demo rewind: a ring of level snapshots and re-simulation.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __G_REWIND__
+#define __G_REWIND__
+
+#include "doomtype.h"
+#include "d_event.h"
+
+
+// True when -rewind was given.
+extern boolean	rewindactive;
+
+// Called by startup code, reads -rewind, -rewindslots, -rewindmem.
+void G_InitRewind (void);
+
+// Called at level start, drops all snapshots of the old level.
+void G_RewindClear (void);
+
+// Called by G_Ticker after each playsim tic of a demo.
+void G_RewindTicker (void);
+
+// Jump to any leveltime of the current level in the demo.
+// Restores the nearest earlier snapshot and re-simulates.
+boolean G_RewindToTic (int tic);
+
+// Arrow keys scrub the demo.
+boolean G_RewindResponder (event_t* ev);
+
+// Prints snapshot cost and memory use.
+void G_RewindReport (void);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
@@ -0,0 +1,349 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Headless demo analysis.
+//	  doom -analyze demo1.lmp demo2.lmp ... [-jobs n] [-statsdir dir]
+//	Each demo is replayed as fast as the playsim runs, in its
+//	own process so runs are independent and several go at once.
+//	Every demo gives three CSV tables in the stats directory:
+//	  <demo>.players.csv	one row per player per tic
+//	  <demo>.damage.csv	one row per hit taken
+//	  <demo>.sectors.csv	sectors whose floor, ceiling or
+//				light changed on that tic
+//	Positions and momentums are raw 16.16 fixed point.
+//	Memory per run is the zone plus the demo and a copy of
+//	the sector heights; rows go straight to disk.
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "z_zone.h"
+
+#include "r_state.h"
+#include "s_sound.h"
+
+#include "g_game.h"
+#include "g_stats.h"
+
+
+#define MAXSTATDEMOS	4096
+#define STATBUFSIZE	(64*1024)
+
+typedef struct
+{
+    fixed_t	floorheight;
+    fixed_t	ceilingheight;
+    short	lightlevel;
+    
+} statsector_t;
+
+
+boolean			statsactive;
+
+static FILE*		playerfile;
+static FILE*		damagefile;
+static FILE*		sectorfile;
+
+static statsector_t*	statsectors;
+static int		statnumsectors;
+static int		statlevelstart = -1;
+
+
+//
+// G_StatsOpen
+//
+static FILE* G_StatsOpen (char* dir, char* base, char* table, char* header)
+{
+    char	name[1024];
+    FILE*	f;
+
+    sprintf (name, "%s/%s.%s.csv", dir, base, table);
+    f = fopen (name, "w");
+    if (!f)
+	I_Error ("G_StatsOpen: couldn't write %s", name);
+
+    setvbuf (f, NULL, _IOFBF, STATBUFSIZE);
+    fprintf (f, "%s\n", header);
+    return f;
+}
+
+
+//
+// G_StatsPlayer
+// Player number of an avatar, -1 for monsters and things.
+//
+static int G_StatsPlayer (mobj_t* mo)
+{
+    if (!mo || !mo->player)
+	return -1;
+    return mo->player - players;
+}
+
+
+//
+// G_StatsDamage
+//
+void
+G_StatsDamage
+( mobj_t*	target,
+  mobj_t*	source,
+  int		damage )
+{
+    fprintf (damagefile, "%i,%i,%i,%i,%i,%i,%i,%i,%i,%i\n",
+	     gametic, gameepisode, gamemap, leveltime,
+	     target->type, G_StatsPlayer (target),
+	     source ? source->type : -1, G_StatsPlayer (source),
+	     damage, target->health);
+}
+
+
+//
+// G_StatsSectors
+// Only changes are written, all sectors at level start.
+//
+static void G_StatsSectors (void)
+{
+    statsector_t*	ss;
+    sector_t*		sec;
+    boolean		newlevel;
+    int			i;
+
+    newlevel = statlevelstart != levelstarttic;
+    if (newlevel)
+    {
+	statlevelstart = levelstarttic;
+	if (numsectors > statnumsectors)
+	{
+	    free (statsectors);
+	    statsectors = malloc (numsectors*sizeof(*statsectors));
+	    if (!statsectors)
+		I_Error ("G_StatsSectors: out of memory");
+	    statnumsectors = numsectors;
+	}
+    }
+
+    for (i=0, sec = sectors, ss = statsectors ;
+	 i<numsectors ;
+	 i++, sec++, ss++)
+    {
+	if (!newlevel
+	    && ss->floorheight == sec->floorheight
+	    && ss->ceilingheight == sec->ceilingheight
+	    && ss->lightlevel == sec->lightlevel)
+	    continue;
+
+	ss->floorheight = sec->floorheight;
+	ss->ceilingheight = sec->ceilingheight;
+	ss->lightlevel = sec->lightlevel;
+	fprintf (sectorfile, "%i,%i,%i,%i,%i,%i,%i,%i\n",
+		 gametic, gameepisode, gamemap, leveltime, i,
+		 sec->floorheight, sec->ceilingheight, sec->lightlevel);
+    }
+}
+
+
+//
+// G_StatsTicker
+//
+void G_StatsTicker (void)
+{
+    player_t*	p;
+    mobj_t*	mo;
+    int		frags;
+    int		i;
+    int		j;
+
+    if (!statsactive)
+	return;
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i] || !players[i].mo)
+	    continue;
+
+	p = &players[i];
+	mo = p->mo;
+	frags = 0;
+	for (j=0 ; j<MAXPLAYERS ; j++)
+	    if (j != i)
+		frags += p->frags[j];
+	    else
+		frags -= p->frags[j];
+
+	fprintf (playerfile,
+		 "%i,%i,%i,%i,%i,%i,%i,%i,%u,%i,%i,%i,%i,%i,%i,%i,%i,%i\n",
+		 gametic, gameepisode, gamemap, leveltime, i,
+		 mo->x, mo->y, mo->z, mo->angle, mo->momx, mo->momy,
+		 mo->health, p->armorpoints, p->readyweapon,
+		 p->killcount, p->itemcount, p->secretcount, frags);
+    }
+
+    G_StatsSectors ();
+}
+
+
+//
+// G_StatsRun
+// Replays one demo, in a child process.
+//
+static void G_StatsRun (char* name, char* dir)
+{
+    byte*	buffer;
+    int		length;
+    char	base[256];
+    char*	s;
+    int		tics;
+    int		start;
+
+    start = I_GetTimeUS ();
+    length = M_ReadFile (name, &buffer);
+
+    // output is named after the demo file
+    s = strrchr (name, '/');
+    strncpy (base, s ? s+1 : name, sizeof(base)-1);
+    base[sizeof(base)-1] = 0;
+    s = strrchr (base, '.');
+    if (s)
+	*s = 0;
+
+    playerfile = G_StatsOpen (dir, base, "players",
+			      "gametic,episode,map,leveltime,player,"
+			      "x,y,z,angle,momx,momy,health,armor,weapon,"
+			      "kills,items,secrets,frags");
+    damagefile = G_StatsOpen (dir, base, "damage",
+			      "gametic,episode,map,leveltime,"
+			      "targettype,targetplayer,sourcetype,"
+			      "sourceplayer,damage,health");
+    sectorfile = G_StatsOpen (dir, base, "sectors",
+			      "gametic,episode,map,leveltime,sector,"
+			      "floor,ceiling,light");
+
+    if (!G_PlayDemoBuffer (buffer))
+	exit (1);
+
+    statsactive = true;
+    tics = 0;
+    while (demo_p < buffer+length && *demo_p != DEMOMARKER)
+    {
+	G_Ticker ();
+	gametic++;
+	tics++;
+    }
+    statsactive = false;
+
+    fclose (playerfile);
+    fclose (damagefile);
+    fclose (sectorfile);
+
+    printf ("G_Stats: %s: %i tics in %i ms\n",
+	    name, tics, (I_GetTimeUS () - start)/1000);
+}
+
+
+//
+// G_AnalyzeDemos
+//
+void G_AnalyzeDemos (int arg)
+{
+    char*	demos[MAXSTATDEMOS];
+    int		numdemos;
+    char*	dir;
+    int		jobs;
+    int		running;
+    int		failed;
+    int		status;
+    int		start;
+    int		p;
+    int		i;
+    pid_t	pid;
+
+    numdemos = 0;
+    for (i=arg+1 ; i<myargc && myargv[i][0] != '-' ; i++)
+    {
+	if (numdemos == MAXSTATDEMOS)
+	    I_Error ("G_AnalyzeDemos: more than %i demos", MAXSTATDEMOS);
+	demos[numdemos++] = myargv[i];
+    }
+
+    dir = ".";
+    p = M_CheckParm ("-statsdir");
+    if (p && p < myargc-1)
+	dir = myargv[p+1];
+
+    jobs = sysconf (_SC_NPROCESSORS_ONLN);
+    p = M_CheckParm ("-jobs");
+    if (p && p < myargc-1)
+	jobs = atoi (myargv[p+1]);
+    if (jobs < 1)
+	jobs = 1;
+
+    printf ("G_AnalyzeDemos: %i demos, %i at a time.\n", numdemos, jobs);
+
+    // nothing is shown or heard
+    nosfxparm = true;
+    precache = false;
+    fflush (stdout);
+
+    start = I_GetTime ();
+    running = failed = 0;
+    for (i=0 ; i<numdemos || running ; )
+    {
+	if (i == numdemos || running == jobs)
+	{
+	    if (wait (&status) < 0)
+		break;
+	    running--;
+	    if (!WIFEXITED (status) || WEXITSTATUS (status))
+		failed++;
+	    continue;
+	}
+
+	pid = fork ();
+	if (pid < 0)
+	    I_Error ("G_AnalyzeDemos: fork failed");
+
+	if (!pid)
+	{
+	    G_StatsRun (demos[i], dir);
+	    fflush (stdout);
+	    exit (0);
+	}
+	running++;
+	i++;
+    }
+
+    printf ("G_AnalyzeDemos: %i demos (%i failed) in %i seconds.\n",
+	    numdemos, failed, (I_GetTime () - start)/TICRATE);
+    exit (failed != 0);
+}
@@ -0,0 +1,49 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Headless demo analysis, per tic tables of the play.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __G_STATS__
+#define __G_STATS__
+
+#include "p_mobj.h"
+
+
+// True while a demo is being analyzed.
+extern boolean	statsactive;
+
+// Called by startup code when -analyze is given.
+// Replays every demo named after it, -jobs at a time,
+//  and exits.
+void G_AnalyzeDemos (int arg);
+
+// Called by G_Ticker after each playsim tic.
+void G_StatsTicker (void);
+
+// Called by P_DamageMobj with the damage actually taken.
+void G_StatsDamage (mobj_t* target, mobj_t* source, int damage);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
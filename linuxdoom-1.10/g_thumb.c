@@ -0,0 +1,348 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Thumbnails of the running level, e.g. for a match browser.
+//	Requests are queued from any thread. After each frame the
+//	game stops for the thumbnail thread, which draws automaps
+//	itself and hands views to R_RenderViews, so nothing of the
+//	console view or automap is touched. A view is rendered in
+//	the smallest window that covers the thumbnail, in low
+//	detail where that is enough, then sampled down.
+//	  -thumbbudget us	time per frame, default 4000; a batch
+//				started in time is always finished
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "m_argv.h"
+
+#include "p_local.h"
+#include "r_local.h"
+#include "r_view.h"
+#include "am_map.h"
+
+#include "g_thumb.h"
+
+
+// views rendered at once
+#define MAXTHUMBBATCH	8
+
+
+static pthread_once_t	thumbonce = PTHREAD_ONCE_INIT;
+static pthread_t	thumbthread;
+static pthread_mutex_t	thumblock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	thumbcond = PTHREAD_COND_INITIALIZER;
+
+// FIFO of requests
+static thumbnail_t*	thumbhead;
+static thumbnail_t*	thumbtail;
+
+// set by G_ThumbnailTicker, cleared by the thread
+static boolean		thumbrun;
+static int		thumbbudget = 4000;
+
+static viewcontext_t	thumbviews[MAXTHUMBBATCH];
+static player_t		thumbplayers[MAXTHUMBBATCH];
+static mobj_t		thumbcameras[MAXTHUMBBATCH];
+static thumbnail_t*	thumbbatch[MAXTHUMBBATCH];
+
+// statistics
+static int		thumbcount;
+static int		thumbtotal;
+static int		thumbmax;
+static int		thumbframes;
+static int		thumbdeferred;
+
+
+
+//
+// G_FinishThumbnail
+//
+static void
+G_FinishThumbnail
+( thumbnail_t*	thumb,
+  int		time )
+{
+    thumb->time = time;
+    thumbcount++;
+    thumbtotal += time;
+    if (time > thumbmax)
+	thumbmax = time;
+
+    __atomic_store_n (&thumb->done, 1, __ATOMIC_RELEASE);
+}
+
+
+//
+// G_SetupThumbView
+// A camera with no weapon up.
+//
+static void
+G_SetupThumbView
+( thumbnail_t*	thumb,
+  int		n )
+{
+    viewcontext_t*	view;
+    player_t*		player;
+    mobj_t*		camera;
+    int			blocks;
+
+    camera = &thumbcameras[n];
+    memset (camera, 0, sizeof(*camera));
+    camera->x = thumb->x;
+    camera->y = thumb->y;
+    camera->angle = thumb->angle;
+    camera->subsector = R_PointInSubsector (thumb->x, thumb->y);
+
+    player = &thumbplayers[n];
+    memset (player, 0, sizeof(*player));
+    player->mo = camera;
+    player->viewz = thumb->z;
+    if (!player->viewz)
+	player->viewz = camera->subsector->sector->floorheight + VIEWHEIGHT;
+
+    // smallest window at least as big as the thumbnail
+    for (blocks=3 ; blocks<11 ; blocks++)
+	if (blocks*32 >= thumb->width
+	    && ((blocks*168/10)&~7) >= thumb->height)
+	    break;
+
+    view = &thumbviews[n];
+    view->player = player;
+    view->blocks = blocks;
+    view->detail = (blocks == 11 ? SCREENWIDTH : blocks*32)
+	>= thumb->width*2;
+}
+
+
+//
+// G_SampleThumbView
+//
+static void
+G_SampleThumbView
+( thumbnail_t*		thumb,
+  viewcontext_t*	view )
+{
+    byte*	dest;
+    byte*	src;
+    int		x;
+    int		y;
+
+    dest = thumb->buffer;
+    for (y=0 ; y<thumb->height ; y++)
+    {
+	src = view->screen
+	    + (view->windowy + y*view->windowheight/thumb->height)*SCREENWIDTH
+	    + view->windowx;
+	for (x=0 ; x<thumb->width ; x++)
+	    *dest++ = src[x*view->windowwidth/thumb->width];
+    }
+}
+
+
+//
+// G_DrawThumbnails
+// Batches until the queue is empty or the budget is spent.
+//
+static void G_DrawThumbnails (void)
+{
+    thumbnail_t*	thumb;
+    int			start;
+    int			time;
+    int			count;
+    int			views;
+    int			i;
+
+    thumbframes++;
+    start = I_GetTimeUS ();
+    while (1)
+    {
+	if (I_GetTimeUS () - start >= thumbbudget)
+	{
+	    pthread_mutex_lock (&thumblock);
+	    if (thumbhead)
+		thumbdeferred++;
+	    pthread_mutex_unlock (&thumblock);
+	    break;
+	}
+
+	pthread_mutex_lock (&thumblock);
+	for (count=0 ; count<MAXTHUMBBATCH && thumbhead ; count++)
+	{
+	    thumbbatch[count] = thumbhead;
+	    thumbhead = thumbhead->next;
+	}
+	if (!thumbhead)
+	    thumbtail = NULL;
+	pthread_mutex_unlock (&thumblock);
+
+	if (!count)
+	    break;
+
+	// maps here, views on the view threads
+	views = 0;
+	for (i=0 ; i<count ; i++)
+	{
+	    thumb = thumbbatch[i];
+	    if (thumb->kind == th_map)
+	    {
+		time = I_GetTimeUS ();
+		AM_DrawThumbnail (thumb->buffer, thumb->width, thumb->height,
+				  thumb->x, thumb->y, thumb->scale);
+		G_FinishThumbnail (thumb, I_GetTimeUS () - time);
+	    }
+	    else
+	    {
+		G_SetupThumbView (thumb, views);
+		thumbbatch[views++] = thumb;
+	    }
+	}
+
+	if (!views)
+	    continue;
+
+	R_RenderViews (thumbviews, views);
+
+	for (i=0 ; i<views ; i++)
+	{
+	    time = I_GetTimeUS ();
+	    G_SampleThumbView (thumbbatch[i], &thumbviews[i]);
+	    G_FinishThumbnail (thumbbatch[i],
+			       thumbviews[i].time + I_GetTimeUS () - time);
+	}
+    }
+}
+
+
+//
+// G_ThumbnailThread
+//
+static void* G_ThumbnailThread (void* unused)
+{
+    pthread_mutex_lock (&thumblock);
+    while (1)
+    {
+	while (!thumbrun)
+	    pthread_cond_wait (&thumbcond, &thumblock);
+	pthread_mutex_unlock (&thumblock);
+
+	G_DrawThumbnails ();
+
+	pthread_mutex_lock (&thumblock);
+	thumbrun = false;
+	pthread_cond_broadcast (&thumbcond);
+    }
+    return NULL;
+}
+
+
+//
+// G_InitThumbnails
+//
+static void G_InitThumbnails (void)
+{
+    int		p;
+    int		i;
+
+    p = M_CheckParm ("-thumbbudget");
+    if (p && p < myargc-1)
+	thumbbudget = atoi (myargv[p+1]);
+
+    for (i=0 ; i<MAXTHUMBBATCH ; i++)
+    {
+	thumbviews[i].screen = malloc (SCREENWIDTH*SCREENHEIGHT);
+	if (!thumbviews[i].screen)
+	    I_Error ("G_InitThumbnails: no memory for the views");
+    }
+
+    if (pthread_create (&thumbthread, NULL, G_ThumbnailThread, NULL))
+	I_Error ("G_InitThumbnails: can't start the thumbnail thread");
+}
+
+
+
+//
+// G_QueueThumbnail
+//
+void G_QueueThumbnail (thumbnail_t* thumb)
+{
+    if (thumb->width < 1 || thumb->width > SCREENWIDTH
+	|| thumb->height < 1 || thumb->height > SCREENHEIGHT)
+	I_Error ("G_QueueThumbnail: bad size %ix%i",
+		 thumb->width, thumb->height);
+
+    pthread_once (&thumbonce, G_InitThumbnails);
+
+    thumb->done = 0;
+    thumb->next = NULL;
+
+    pthread_mutex_lock (&thumblock);
+    if (thumbtail)
+	thumbtail->next = thumb;
+    else
+	thumbhead = thumb;
+    thumbtail = thumb;
+    pthread_mutex_unlock (&thumblock);
+}
+
+
+//
+// G_ThumbnailTicker
+//
+void G_ThumbnailTicker (void)
+{
+    if (gamestate != GS_LEVEL)
+	return;
+
+    pthread_mutex_lock (&thumblock);
+    if (thumbhead)
+    {
+	thumbrun = true;
+	pthread_cond_broadcast (&thumbcond);
+	while (thumbrun)
+	    pthread_cond_wait (&thumbcond, &thumblock);
+    }
+    pthread_mutex_unlock (&thumblock);
+}
+
+
+//
+// G_ThumbnailReport
+//
+void G_ThumbnailReport (void)
+{
+    if (!thumbcount)
+	return;
+
+    printf ("G_Thumbnail: %i thumbnails in %i frames, "
+	    "%i us average, %i us max, %i frames over budget\n",
+	    thumbcount, thumbframes, thumbtotal/thumbcount,
+	    thumbmax, thumbdeferred);
+}
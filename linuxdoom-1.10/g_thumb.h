@@ -0,0 +1,88 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Thumbnails of the running level, e.g. for a match browser.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __G_THUMB__
+#define __G_THUMB__
+
+#include "doomtype.h"
+#include "m_fixed.h"
+#include "tables.h"
+
+
+typedef enum
+{
+    th_view,		// what a player at x,y,z looking at angle sees
+    th_map		// the automap around x,y
+
+} thumbkind_t;
+
+
+//
+// A thumbnail request. The caller owns it and the buffer
+//  and must leave both alone until done is set.
+// The buffer gets width*height PLAYPAL indices,
+//  at most SCREENWIDTH by SCREENHEIGHT.
+//
+typedef struct thumbnail_s
+{
+    thumbkind_t		kind;
+
+    fixed_t		x;
+    fixed_t		y;
+    fixed_t		z;	// th_view, 0 is eye height over the floor
+    angle_t		angle;	// th_view
+    fixed_t		scale;	// th_map, pixels per map unit, 0 fits the level
+
+    byte*		buffer;
+    int			width;
+    int			height;
+
+    // set once the buffer is filled in
+    int			done;
+
+    // microseconds it took
+    int			time;
+
+    struct thumbnail_s*	next;
+
+} thumbnail_t;
+
+
+// Can be called from any thread.
+// The thumbnail is drawn at the end of a later frame.
+void G_QueueThumbnail (thumbnail_t* thumb);
+
+// Called by D_DoomLoop after each frame.
+// Draws queued thumbnails on worker threads, for at
+//  most -thumbbudget microseconds of the frame.
+void G_ThumbnailTicker (void);
+
+// Called by I_Quit, prints the costs.
+void G_ThumbnailReport (void);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
@@ -0,0 +1,186 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Cache references and misses from the Linux perf counters,
+//	summed over each frame drawn and each tic run. Only with
+//	-perf; reading the counters costs a system call.
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "doomtype.h"
+#include "m_argv.h"
+
+#include "i_perf.h"
+
+
+#define NUMCOUNTERS	2
+
+typedef struct
+{
+    // PERF_FORMAT_GROUP layout
+    unsigned long long	nr;
+    unsigned long long	values[NUMCOUNTERS];
+
+} perfread_t;
+
+typedef struct
+{
+    unsigned long long	start[NUMCOUNTERS];
+    unsigned long long	total[NUMCOUNTERS];
+    int			count;
+
+} perfsum_t;
+
+static char*		sectionnames[NUMPERFS] = { "frame", "tic" };
+
+// group leader, -1 if not counting
+static int		perffd = -1;
+static perfsum_t	perfsums[NUMPERFS];
+
+
+//
+// I_OpenCounter
+//
+static int
+I_OpenCounter
+( int		config,
+  int		group )
+{
+    struct perf_event_attr	attr;
+
+    memset (&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // this thread, any cpu
+    return syscall (__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+
+//
+// I_ReadCounters
+//
+static boolean I_ReadCounters (unsigned long long* values)
+{
+    perfread_t	buf;
+    int		i;
+
+    if (read (perffd, &buf, sizeof(buf)) != sizeof(buf))
+	return false;
+
+    for (i=0 ; i<NUMCOUNTERS ; i++)
+	values[i] = buf.values[i];
+    return true;
+}
+
+
+//
+// I_InitPerf
+//
+void I_InitPerf (void)
+{
+    if (!M_CheckParm ("-perf"))
+	return;
+
+    perffd = I_OpenCounter (PERF_COUNT_HW_CACHE_REFERENCES, -1);
+    if (perffd == -1
+	|| I_OpenCounter (PERF_COUNT_HW_CACHE_MISSES, perffd) == -1)
+    {
+	printf ("I_InitPerf: no cache counters, "
+		"see /proc/sys/kernel/perf_event_paranoid\n");
+	if (perffd != -1)
+	    close (perffd);
+	perffd = -1;
+	return;
+    }
+
+    printf ("I_InitPerf: counting cache misses\n");
+}
+
+
+//
+// I_BeginPerf
+//
+void I_BeginPerf (perfsection_t section)
+{
+    if (perffd == -1)
+	return;
+
+    I_ReadCounters (perfsums[section].start);
+}
+
+
+//
+// I_EndPerf
+//
+void I_EndPerf (perfsection_t section)
+{
+    unsigned long long	now[NUMCOUNTERS];
+    perfsum_t*		sum;
+    int			i;
+
+    if (perffd == -1 || !I_ReadCounters (now))
+	return;
+
+    sum = &perfsums[section];
+    for (i=0 ; i<NUMCOUNTERS ; i++)
+	sum->total[i] += now[i] - sum->start[i];
+    sum->count++;
+}
+
+
+//
+// I_PerfReport
+//
+void I_PerfReport (void)
+{
+    perfsum_t*	sum;
+    int		i;
+
+    if (perffd == -1)
+	return;
+
+    for (i=0 ; i<NUMPERFS ; i++)
+    {
+	sum = &perfsums[i];
+	if (!sum->count)
+	    continue;
+
+	printf ("I_Perf: %i %ss, %llu cache misses per %s, "
+		"%llu references, %.1f%% missed\n",
+		sum->count, sectionnames[i],
+		sum->total[1]/sum->count, sectionnames[i],
+		sum->total[0]/sum->count,
+		sum->total[0] ? 100.0*sum->total[1]/sum->total[0] : 0.0);
+    }
+}
@@ -0,0 +1,53 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Hardware cache counters around the refresh and the playsim.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __I_PERF__
+#define __I_PERF__
+
+
+typedef enum
+{
+    perf_frame,		// R_RenderPlayerView
+    perf_tic,		// P_Ticker
+    NUMPERFS
+
+} perfsection_t;
+
+
+// Called by I_Init, reads -perf.
+void I_InitPerf (void);
+
+// Bracket one frame or tic, main thread only.
+void I_BeginPerf (perfsection_t section);
+void I_EndPerf (perfsection_t section);
+
+// Prints cache misses per frame and per tic.
+// Called by I_Quit and at the end of a -timedemo.
+void I_PerfReport (void);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
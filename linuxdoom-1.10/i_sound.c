@@ -96,14 +96,20 @@ static int flag = 0;
 #define BUFMUL                  4
 #define MIXBUFFERSIZE		(SAMPLECOUNT*BUFMUL)
 
-#define SAMPLERATE		11025	// Hz
 #define SAMPLESIZE		2   	// 16bit
 
 // The actual lengths of all sound effects.
 int 		lengths[NUMSFX];
 
 // The actual output device.
-int	audio_fd;
+int	audio_fd = -1;
+
+// Sounds go to the internal mixer even with a server.
+static boolean	mixlocal;
+
+// Headless runs leave the device and server alone.
+boolean		nosounddevice;
+static boolean	soundscached;
 
 // The global mixing buffer.
 // Basically, samples from all active internal channels
@@ -480,6 +486,9 @@ I_StartSound
   priority = 0;
   
 #ifdef SNDSERV 
+    if (mixlocal)
+	return addsfx( id, vol, steptable[pitch], sep );
+
     if (sndserver)
     {
 	fprintf(sndserver, "p%2.2x%2.2x%2.2x%2.2x\n", id, pitch, vol, sep);
@@ -543,7 +552,38 @@ void I_UpdateSound( void )
   static int misses = 0;
 #endif
 
-  
+    I_MixSound (mixbuffer, SAMPLECOUNT);
+
+#ifdef SNDINTR
+    // Debug check.
+    if ( flag )
+    {
+      misses += flag;
+      flag = 0;
+    }
+    
+    if ( misses > 10 )
+    {
+      fprintf( stderr, "I_SoundUpdate: missed 10 buffer writes\n");
+      misses = 0;
+    }
+    
+    // Increment flag for update.
+    flag++;
+#endif
+}
+
+
+//
+// I_MixSound
+// Mixes the channels into samples stereo 16bit
+//  values at out, for the mixbuffer or for recording.
+//
+void
+I_MixSound
+( signed short*	out,
+  int		samples )
+{
   // Mix current sound data.
   // Data, from raw sound, for right and left.
   register unsigned int	sample;
@@ -562,13 +602,13 @@ void I_UpdateSound( void )
     
     // Left and right channel
     //  are in global mixbuffer, alternating.
-    leftout = mixbuffer;
-    rightout = mixbuffer+1;
+    leftout = out;
+    rightout = out+1;
     step = 2;
 
     // Determine end, for left channel only
     //  (right channel is implicit).
-    leftend = mixbuffer + SAMPLECOUNT*step;
+    leftend = out + samples*step;
 
     // Mix sounds into the mixing buffer.
     // Loop over step*SAMPLECOUNT,
@@ -633,24 +673,6 @@ void I_UpdateSound( void )
 	leftout += step;
 	rightout += step;
     }
-
-#ifdef SNDINTR
-    // Debug check.
-    if ( flag )
-    {
-      misses += flag;
-      flag = 0;
-    }
-    
-    if ( misses > 10 )
-    {
-      fprintf( stderr, "I_SoundUpdate: missed 10 buffer writes\n");
-      misses = 0;
-    }
-    
-    // Increment flag for update.
-    flag++;
-#endif
 }
 
 
@@ -731,6 +753,49 @@ void I_ShutdownSound(void)
 
 
 
+//
+// I_CacheSounds
+// Loads all sound data for the internal mixer.
+//
+static void I_CacheSounds (void)
+{
+  int i;
+
+  if (soundscached)
+    return;
+  soundscached = true;
+
+  for (i=1 ; i<NUMSFX ; i++)
+  { 
+    // Alias? Example is the chaingun sound linked to pistol.
+    if (!S_sfx[i].link)
+    {
+      // Load data from WAD file.
+      S_sfx[i].data = getsfx( S_sfx[i].name, &lengths[i] );
+    }	
+    else
+    {
+      // Previously loaded already?
+      S_sfx[i].data = S_sfx[i].link->data;
+      lengths[i] = lengths[(S_sfx[i].link - S_sfx)/sizeof(sfxinfo_t)];
+    }
+  }
+}
+
+
+//
+// I_MixLocal
+// Called by G_RenderDemo: sounds go to the internal
+//  mixer for I_MixSound, even with a sound server.
+//
+void I_MixLocal (void)
+{
+  if (mixlocal)
+    return;
+  mixlocal = true;
+  I_CacheSounds ();
+}
+
 
 
 
@@ -740,6 +805,9 @@ I_InitSound()
 #ifdef SNDSERV
   char buffer[256];
   
+  if (nosounddevice)
+    return;
+
   if (getenv("DOOMWADDIR"))
     sprintf(buffer, "%s/%s",
 	    getenv("DOOMWADDIR"),
@@ -759,6 +827,9 @@ I_InitSound()
     
   int i;
   
+  if (nosounddevice)
+    return;
+
 #ifdef SNDINTR
   fprintf( stderr, "I_SoundSetTimer: %d microsecs\n", SOUND_INTERVAL );
   I_SoundSetTimer( SOUND_INTERVAL );
@@ -796,21 +867,7 @@ I_InitSound()
   // Initialize external data (all sounds) at start, keep static.
   fprintf( stderr, "I_InitSound: ");
   
-  for (i=1 ; i<NUMSFX ; i++)
-  { 
-    // Alias? Example is the chaingun sound linked to pistol.
-    if (!S_sfx[i].link)
-    {
-      // Load data from WAD file.
-      S_sfx[i].data = getsfx( S_sfx[i].name, &lengths[i] );
-    }	
-    else
-    {
-      // Previously loaded already?
-      S_sfx[i].data = S_sfx[i].link->data;
-      lengths[i] = lengths[(S_sfx[i].link - S_sfx)/sizeof(sfxinfo_t)];
-    }
-  }
+  I_CacheSounds ();
 
   fprintf( stderr, " pre-cached all sound data\n");
   
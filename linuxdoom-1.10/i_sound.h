@@ -36,6 +36,9 @@ extern char* sndserver_filename;
 #include "sounds.h"
 
 
+// Output rate, stereo 16bit.
+#define SAMPLERATE		11025	// Hz
+
 
 // Init at program start...
 void I_InitSound();
@@ -44,9 +47,21 @@ void I_InitSound();
 void I_UpdateSound(void);
 void I_SubmitSound(void);
 
+// Mixes the playing sounds without the device,
+//  samples stereo pairs at out.
+void I_MixSound (signed short* out, int samples);
+
+// Mixes in process for I_MixSound,
+//  also when a sound server plays the game.
+void I_MixLocal (void);
+
 // ... shut down and relase at program termination.
 void I_ShutdownSound(void);
 
+// Set before I_InitSound by headless modes, which
+//  must run where there is no audio device.
+extern boolean	nosounddevice;
+
 
 //
 //  SFX I/O
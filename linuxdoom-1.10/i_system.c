@@ -30,15 +30,22 @@ rcsid[] = "$Id: m_bbox.c,v 1.1 1997/02/03 22:45:10 b1 Exp $";
 
 #include <stdarg.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #include "doomdef.h"
 #include "m_misc.h"
+#include "m_argv.h"
 #include "i_video.h"
 #include "i_sound.h"
+#include "i_perf.h"
+#include "w_wad.h"
 
+#include "d_main.h"
+#include "m_capture.h"
 #include "d_net.h"
 #include "g_game.h"
+#include "g_thumb.h"
 
 #ifdef __GNUG__
 #pragma implementation "i_system.h"
@@ -50,6 +57,18 @@ rcsid[] = "$Id: m_bbox.c,v 1.1 1997/02/03 22:45:10 b1 Exp $";
 
 int	mb_used = 6;
 
+// Zone growth, see I_ZoneGrow.
+int	mb_max = 64;
+int	mb_chunk = 4;
+int	zonetotal;
+boolean	hugepages;
+
+#define HUGEPAGESIZE	(2*1024*1024)
+
+// Zone sizes are ints of bytes. Whole huge pages of this
+//  many megabytes still fit.
+#define MAXZONEMB	2046
+
 
 void
 I_Tactile
@@ -73,10 +92,98 @@ int  I_GetHeapSize (void)
     return mb_used*1024*1024;
 }
 
+//
+// I_ZoneAlloc
+// With -hugepages, reserved huge pages if the system has any,
+//  else transparent ones.
+//
+byte* I_ZoneAlloc (int* size)
+{
+    byte*	p;
+
+    if (!hugepages)
+	return (byte *) malloc (*size);
+
+    *size = (*size + HUGEPAGESIZE-1) & ~(HUGEPAGESIZE-1);
+#ifdef MAP_HUGETLB
+    p = mmap (NULL, *size, PROT_READ|PROT_WRITE,
+	      MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED)
+	return p;
+#endif
+    p = mmap (NULL, *size, PROT_READ|PROT_WRITE,
+	      MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+	return NULL;
+#ifdef MADV_HUGEPAGE
+    madvise (p, *size, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+
+//
+// I_ZoneBase
+// -zonemb initial megabytes, -zonemax cap for growth,
+//  -zonechunk megabytes added at a time, -hugepages.
+// The config file has them as zone_mb etc.
+//
 byte* I_ZoneBase (int*	size)
 {
+    byte*	zone;
+    int		p;
+
+    p = M_CheckParm ("-zonemb");
+    if (p && p < myargc-1)
+	mb_used = atoi (myargv[p+1]);
+    p = M_CheckParm ("-zonemax");
+    if (p && p < myargc-1)
+	mb_max = atoi (myargv[p+1]);
+    p = M_CheckParm ("-zonechunk");
+    if (p && p < myargc-1)
+	mb_chunk = atoi (myargv[p+1]);
+    if (M_CheckParm ("-hugepages"))
+	hugepages = true;
+
+    if (mb_used < 1)
+	mb_used = 1;
+    if (mb_used > MAXZONEMB)
+	mb_used = MAXZONEMB;
+    if (mb_max < mb_used)
+	mb_max = mb_used;
+    if (mb_max > MAXZONEMB)
+	mb_max = MAXZONEMB;
+    if (mb_chunk < 1)
+	mb_chunk = 1;
+    if (mb_chunk > MAXZONEMB)
+	mb_chunk = MAXZONEMB;
+
     *size = mb_used*1024*1024;
-    return (byte *) malloc (*size);
+    zone = I_ZoneAlloc (size);
+    if (!zone)
+	I_Error ("I_ZoneBase: no memory for %i MB", mb_used);
+    zonetotal = *size;
+    return zone;
+}
+
+
+//
+// I_ZoneGrow
+// Another region of at least *size bytes, or NULL past the cap.
+//
+byte* I_ZoneGrow (int* size)
+{
+    byte*	zone;
+
+    if (*size < mb_chunk*1024*1024)
+	*size = mb_chunk*1024*1024;
+    if (zonetotal + (long long)*size > (long long)mb_max*1024*1024)
+	return NULL;
+
+    zone = I_ZoneAlloc (size);
+    if (zone)
+	zonetotal += *size;
+    return zone;
 }
 
 
@@ -100,6 +207,79 @@ int  I_GetTime (void)
 }
 
 
+//
+// I_GetTimeUS
+// returns time in microseconds, for profiling.
+// Wraps around, so only differences are meaningful.
+//
+int  I_GetTimeUS (void)
+{
+    struct timeval	tp;
+    struct timezone	tzp;
+
+    gettimeofday(&tp, &tzp);
+    return (int)((unsigned)tp.tv_sec*1000000u + (unsigned)tp.tv_usec);
+}
+
+
+
+//
+// I_ReadMemoryFields
+// Sums the kB of the named fields of a /proc file.
+//
+static int I_ReadMemoryFields (char* filename, char** fields, int* kb)
+{
+    FILE*	f;
+    char	line[256];
+    int		value;
+    int		i;
+
+    f = fopen (filename, "r");
+    if (!f)
+	return 0;
+
+    while (fgets (line, sizeof(line), f))
+	for (i=0 ; fields[i] ; i++)
+	    if (!strncmp (line, fields[i], strlen(fields[i]))
+		&& sscanf (line+strlen(fields[i]), "%i", &value) == 1)
+		kb[i] = value;
+
+    fclose (f);
+    return 1;
+}
+
+
+//
+// I_MemoryReport
+// RssFile counts the mapped WADs in full in every process;
+//  Pss splits shared pages among the processes mapping
+//  them, so it is what each instance really costs.
+//
+void I_MemoryReport (void)
+{
+    static char*	statusfields[] = { "VmRSS:", "RssAnon:", "RssFile:", NULL };
+    static char*	rollupfields[] = { "Pss:", NULL };
+    int			status[3];
+    int			pss[1];
+
+    if (!M_CheckParm ("-memreport"))
+	return;
+
+    memset (status, 0, sizeof(status));
+    pss[0] = 0;
+    if (!I_ReadMemoryFields ("/proc/self/status", statusfields, status))
+    {
+	printf ("I_MemoryReport: no /proc/self/status\n");
+	return;
+    }
+    I_ReadMemoryFields ("/proc/self/smaps_rollup", rollupfields, pss);
+
+    printf ("I_MemoryReport: rss %i kB, %i kB private, %i kB mapped files, "
+	    "pss %i kB, zone %i kB\n",
+	    status[0], status[1], status[2], pss[0], zonetotal/1024);
+}
+
+
 
 //
 // I_Init
@@ -107,6 +287,7 @@ int  I_GetTime (void)
 void I_Init (void)
 {
     I_InitSound();
+    I_InitPerf();
     //  I_InitGraphics();
 }
 
@@ -116,6 +297,12 @@ void I_Init (void)
 void I_Quit (void)
 {
     D_QuitNetGame ();
+    D_EventReport ();
+    G_ThumbnailReport ();
+    I_PerfReport ();
+    I_MemoryReport ();
+    W_ReadReport ();
+    M_FinishCapture ();
     I_ShutdownSound();
     I_ShutdownMusic();
     M_SaveDefaults ();
@@ -176,6 +363,7 @@ void I_Error (char *error, ...)
     if (demorecording)
 	G_CheckDemoStatus();
 
+    M_FinishCapture ();
     D_QuitNetGame ();
     I_ShutdownGraphics();
     
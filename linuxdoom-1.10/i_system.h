@@ -39,11 +39,19 @@ void I_Init (void);
 // for the zone management.
 byte*	I_ZoneBase (int *size);
 
+// Called by Z_Malloc when the zone is full,
+// another region of at least *size bytes,
+// NULL when -zonemax would be passed.
+byte*	I_ZoneGrow (int *size);
+
 
 // Called by D_DoomLoop,
 // returns current time in tics.
 int I_GetTime (void);
 
+// Microsecond clock for profiling, only differences count.
+int I_GetTimeUS (void);
+
 
 //
 // Called by D_DoomLoop,
@@ -74,6 +82,12 @@ void I_StartTic (void);
 ticcmd_t* I_BaseTiccmd (void);
 
 
+// With -memreport, prints resident memory and how much
+//  of it is WAD pages shared with other processes.
+// Called by I_Quit and at the end of a -timedemo.
+void I_MemoryReport (void);
+
+
 // Called by M_Responder when quit is selected.
 // Clean exit, displays sell blurb.
 void I_Quit (void);
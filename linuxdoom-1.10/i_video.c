@@ -48,6 +48,7 @@ int XShmGetEventBase( Display* dpy ); // problems with g++?
 #include <netinet/in.h>
 #include <errnos.h>
 #include <signal.h>
+#include <pthread.h>
 
 #include "doomstat.h"
 #include "i_system.h"
@@ -58,6 +59,7 @@ int XShmGetEventBase( Display* dpy ); // problems with g++?
 #include "doomdef.h"
 
 #define POINTER_WARP_COUNTDOWN	1
+#define MAXIMAGES		3
 
 Display*	X_display=0;
 Window		X_mainWindow;
@@ -74,9 +76,38 @@ int		X_height;
 // MIT SHared Memory extension.
 boolean		doShm;
 
-XShmSegmentInfo	X_shminfo;
+XShmSegmentInfo	X_shminfo[MAXIMAGES];
 int		X_shmeventtype;
 
+// Images in rotation, -images 1 to 3, default 2.
+// A frame is copied into a free image and presented,
+//  and the game goes on while the server is still busy.
+// Without MITSHM a present thread does XPutImage/XSync.
+XImage*		images[MAXIMAGES];
+int		numimages = 2;
+int		curimage;
+boolean		imagebusy[MAXIMAGES];
+
+static boolean		presentthread;
+static pthread_t	presentthreadid;
+static pthread_mutex_t	presentlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	presentcond = PTHREAD_COND_INITIALIZER;
+static int		presentqueue[MAXIMAGES];
+static int		presenthead;
+static int		presenttail;
+
+// Input thread, reads X events as they come, -noinputthread
+//  polls them in I_StartTic instead.
+// With it, MITSHM completions are seen there too.
+static boolean		inputthread;
+static pthread_t	inputthreadid;
+
+// Frame time, reported by I_ShutdownGraphics.
+static int		framecount;
+static int		frametime;
+static int		framemax;
+static int		framewait;
+
 // Fake mouse handling.
 // This cannot work properly w/o DGA.
 // Needs an invisible mouse cursor at least.
@@ -163,16 +194,31 @@ int xlatekey(void)
 
 void I_ShutdownGraphics(void)
 {
-  // Detach from X server
-  if (!XShmDetach(X_display, &X_shminfo))
-	    I_Error("XShmDetach() failed in I_ShutdownGraphics()");
+  int	i;
+
+  if (framecount)
+      printf ("I_FinishUpdate: %i frames, %i us average, %i us max, "
+	      "%i us waiting, %i images%s\n",
+	      framecount, frametime/framecount, framemax,
+	      framewait/framecount, numimages,
+	      presentthread ? ", present thread" : "");
 
-  // Release shared memory.
-  shmdt(X_shminfo.shmaddr);
-  shmctl(X_shminfo.shmid, IPC_RMID, 0);
+  if (!doShm)
+      return;
+
+  for (i=0 ; i<numimages ; i++)
+  {
+      // Detach from X server
+      if (!XShmDetach(X_display, &X_shminfo[i]))
+	  I_Error("XShmDetach() failed in I_ShutdownGraphics()");
 
-  // Paranoia.
-  image->data = NULL;
+      // Release shared memory.
+      shmdt(X_shminfo[i].shmaddr);
+      shmctl(X_shminfo[i].shmid, IPC_RMID, 0);
+
+      // Paranoia.
+      images[i]->data = NULL;
+  }
 }
 
 
@@ -189,12 +235,12 @@ void I_StartFrame (void)
 static int	lastmousex = 0;
 static int	lastmousey = 0;
 boolean		mousemoved = false;
-boolean		shmFinished;
 
 void I_GetEvent(void)
 {
 
     event_t event;
+    int		i;
 
     // put event-grabbing stuff in here
     XNextEvent(X_display, &X_event);
@@ -272,7 +318,16 @@ void I_GetEvent(void)
 	break;
 	
       default:
-	if (doShm && X_event.type == X_shmeventtype) shmFinished = true;
+	if (doShm && X_event.type == X_shmeventtype)
+	{
+	    pthread_mutex_lock (&presentlock);
+	    for (i=0 ; i<numimages ; i++)
+		if (((XShmCompletionEvent *)&X_event)->shmseg
+		    == X_shminfo[i].shmseg)
+		    imagebusy[i] = false;
+	    pthread_cond_broadcast (&presentcond);
+	    pthread_mutex_unlock (&presentlock);
+	}
 	break;
     }
 
@@ -303,6 +358,17 @@ createnullcursor
     return cursor;
 }
 
+//
+// I_InputThread
+//
+void* I_InputThread (void* unused)
+{
+    while (1)
+	I_GetEvent();
+    return NULL;
+}
+
+
 //
 // I_StartTic
 //
@@ -312,8 +378,11 @@ void I_StartTic (void)
     if (!X_display)
 	return;
 
-    while (XPending(X_display))
-	I_GetEvent();
+    if (!inputthread)
+    {
+	while (XPending(X_display))
+	    I_GetEvent();
+    }
 
     // Warp the pointer back to the middle of the window
     //  or it will wander off - that is, the game will
@@ -346,6 +415,63 @@ void I_UpdateNoBlit (void)
     // what is this?
 }
 
+//
+// I_PresentThread
+// XPutImage and XSync for the game thread
+//  when there is no MITSHM.
+//
+void* I_PresentThread (void* unused)
+{
+    int		n;
+
+    pthread_mutex_lock (&presentlock);
+    while (1)
+    {
+	while (presenthead == presenttail)
+	    pthread_cond_wait (&presentcond, &presentlock);
+	n = presentqueue[presenttail];
+	pthread_mutex_unlock (&presentlock);
+
+	XPutImage(	X_display,
+			X_mainWindow,
+			X_gc,
+			images[n],
+			0, 0,
+			0, 0,
+			X_width, X_height );
+	XSync(X_display, False);
+
+	pthread_mutex_lock (&presentlock);
+	presenttail = (presenttail+1)%MAXIMAGES;
+	imagebusy[n] = false;
+	pthread_cond_broadcast (&presentcond);
+    }
+    return NULL;
+}
+
+
+//
+// I_WaitImage
+// Until the server or the present thread is done with it.
+// Input events are handled while waiting for MITSHM.
+//
+void I_WaitImage (int n)
+{
+    if (doShm && !inputthread)
+    {
+	while (imagebusy[n])
+	    I_GetEvent();
+    }
+    else if (doShm || presentthread)
+    {
+	pthread_mutex_lock (&presentlock);
+	while (imagebusy[n])
+	    pthread_cond_wait (&presentcond, &presentlock);
+	pthread_mutex_unlock (&presentlock);
+    }
+}
+
+
 //
 // I_FinishUpdate
 //
@@ -355,8 +481,16 @@ void I_FinishUpdate (void)
     static int	lasttic;
     int		tics;
     int		i;
+    int		start;
+    int		wait;
     // UNUSED static unsigned char *bigscreen=0;
 
+    // rendering offscreen, e.g. a demo to video
+    if (!image)
+	return;
+
+    start = I_GetTimeUS ();
+
     // draws little dots on the bottom of the screen
     if (devparm)
     {
@@ -373,6 +507,10 @@ void I_FinishUpdate (void)
     
     }
 
+    // with one image the game draws right into it
+    if (multiply == 1 && numimages > 1)
+	memcpy (image->data, screens[0], SCREENWIDTH*SCREENHEIGHT);
+
     // scales the screen size before blitting it
     if (multiply == 2)
     {
@@ -483,6 +621,7 @@ void I_FinishUpdate (void)
     if (doShm)
     {
 
+	imagebusy[curimage] = true;
 	if (!XShmPutImage(	X_display,
 				X_mainWindow,
 				X_gc,
@@ -492,13 +631,18 @@ void I_FinishUpdate (void)
 				X_width, X_height,
 				True ))
 	    I_Error("XShmPutImage() failed\n");
+	XFlush(X_display);
 
-	// wait for it to finish and processes all input events
-	shmFinished = false;
-	do
-	{
-	    I_GetEvent();
-	} while (!shmFinished);
+    }
+    else if (presentthread)
+    {
+
+	pthread_mutex_lock (&presentlock);
+	imagebusy[curimage] = true;
+	presentqueue[presenthead] = curimage;
+	presenthead = (presenthead+1)%MAXIMAGES;
+	pthread_cond_signal (&presentcond);
+	pthread_mutex_unlock (&presentlock);
 
     }
     else
@@ -518,6 +662,19 @@ void I_FinishUpdate (void)
 
     }
 
+    // Next image, with a single one this waits
+    //  for the frame just sent, as it always did.
+    wait = I_GetTimeUS ();
+    curimage = (curimage+1)%numimages;
+    I_WaitImage (curimage);
+    image = images[curimage];
+
+    framecount++;
+    framewait += I_GetTimeUS () - wait;
+    start = I_GetTimeUS () - start;
+    frametime += start;
+    if (start > framemax)
+	framemax = start;
 }
 
 
@@ -542,40 +699,57 @@ void UploadNewPalette(Colormap cmap, byte *palette)
     register int	c;
     static boolean	firstcall = true;
 
+    // initialize the colormap
+    if (firstcall)
+    {
+	firstcall = false;
+	for (i=0 ; i<256 ; i++)
+	{
+	    colors[i].pixel = i;
+	    colors[i].flags = DoRed|DoGreen|DoBlue;
+	}
+    }
+
+    // set the X colormap entries,
+    //  kept without a display too for I_ReadPalette
+    for (i=0 ; i<256 ; i++)
+    {
+	c = gammatable[usegamma][*palette++];
+	colors[i].red = (c<<8) + c;
+	c = gammatable[usegamma][*palette++];
+	colors[i].green = (c<<8) + c;
+	c = gammatable[usegamma][*palette++];
+	colors[i].blue = (c<<8) + c;
+    }
+
 #ifdef __cplusplus
     if (X_visualinfo.c_class == PseudoColor && X_visualinfo.depth == 8)
 #else
     if (X_visualinfo.class == PseudoColor && X_visualinfo.depth == 8)
 #endif
 	{
-	    // initialize the colormap
-	    if (firstcall)
-	    {
-		firstcall = false;
-		for (i=0 ; i<256 ; i++)
-		{
-		    colors[i].pixel = i;
-		    colors[i].flags = DoRed|DoGreen|DoBlue;
-		}
-	    }
-
-	    // set the X colormap entries
-	    for (i=0 ; i<256 ; i++)
-	    {
-		c = gammatable[usegamma][*palette++];
-		colors[i].red = (c<<8) + c;
-		c = gammatable[usegamma][*palette++];
-		colors[i].green = (c<<8) + c;
-		c = gammatable[usegamma][*palette++];
-		colors[i].blue = (c<<8) + c;
-	    }
-
 	    // store the colors to the current colormap
 	    XStoreColors(X_display, cmap, colors, 256);
-
 	}
 }
 
+//
+// I_ReadPalette
+// The palette on screen, gamma corrected, 768 bytes.
+//
+void I_ReadPalette (byte* palette)
+{
+    int		i;
+
+    for (i=0 ; i<256 ; i++)
+    {
+	*palette++ = colors[i].red>>8;
+	*palette++ = colors[i].green>>8;
+	*palette++ = colors[i].blue>>8;
+    }
+}
+
+
 //
 // I_SetPalette
 //
@@ -592,10 +766,11 @@ void I_SetPalette (byte* palette)
 //  thus there might have been stale
 //  handles accumulating.
 //
-void grabsharedmemory(int size)
+void grabsharedmemory(int size, int n)
 {
 
-  int			key = ('d'<<24) | ('o'<<16) | ('o'<<8) | 'm';
+  // each image starts past the keys the one before may try
+  int			key = (('d'<<24) | ('o'<<16) | ('o'<<8) | 'm') + n*8;
   struct shmid_ds	shminfo;
   int			minsize = 320*200;
   int			id;
@@ -680,13 +855,13 @@ void grabsharedmemory(int size)
 	    "shared memory segments.\n");
     }	
   
-  X_shminfo.shmid = id;
+  X_shminfo[n].shmid = id;
   
   // attach to the shared memory segment
-  image->data = X_shminfo.shmaddr = shmat(id, 0, 0);
+  images[n]->data = X_shminfo[n].shmaddr = shmat(id, 0, 0);
   
   fprintf(stderr, "shared memory id=%d, addr=0x%x\n", id,
-	  (int) (image->data));
+	  (int) (images[n]->data));
 }
 
 void I_InitGraphics(void)
@@ -708,6 +883,7 @@ void I_InitGraphics(void)
     XSetWindowAttributes attribs;
     XGCValues		xgcvalues;
     int			valuemask;
+    int			i;
     static int		firsttime=1;
 
     if (!firsttime)
@@ -728,6 +904,20 @@ void I_InitGraphics(void)
     X_width = SCREENWIDTH * multiply;
     X_height = SCREENHEIGHT * multiply;
 
+    if ( (pnum=M_CheckParm("-images")) && pnum < myargc-1 )
+	numimages = atoi(myargv[pnum+1]);
+    if (numimages < 1)
+	numimages = 1;
+    if (numimages > MAXIMAGES)
+	numimages = MAXIMAGES;
+
+    inputthread = !M_CheckParm("-noinputthread");
+
+    // the input and present threads need a thread safe Xlib,
+    //  set up before any other call
+    if (numimages > 1 || inputthread)
+	XInitThreads();
+
     // check for command-line display name
     if ( (pnum=M_CheckParm("-disp")) ) // suggest parentheses around assignment
 	displayname = myargv[pnum+1];
@@ -855,63 +1045,80 @@ void I_InitGraphics(void)
 
 	X_shmeventtype = XShmGetEventBase(X_display) + ShmCompletion;
 
-	// create the image
-	image = XShmCreateImage(	X_display,
-					X_visual,
-					8,
-					ZPixmap,
-					0,
-					&X_shminfo,
-					X_width,
-					X_height );
-
-	grabsharedmemory(image->bytes_per_line * image->height);
-
-
-	// UNUSED
-	// create the shared memory segment
-	// X_shminfo.shmid = shmget (IPC_PRIVATE,
-	// image->bytes_per_line * image->height, IPC_CREAT | 0777);
-	// if (X_shminfo.shmid < 0)
-	// {
-	// perror("");
-	// I_Error("shmget() failed in InitGraphics()");
-	// }
-	// fprintf(stderr, "shared memory id=%d\n", X_shminfo.shmid);
-	// attach to the shared memory segment
-	// image->data = X_shminfo.shmaddr = shmat(X_shminfo.shmid, 0, 0);
+	for (i=0 ; i<numimages ; i++)
+	{
+	    // create the image
+	    images[i] = XShmCreateImage(	X_display,
+						X_visual,
+						8,
+						ZPixmap,
+						0,
+						&X_shminfo[i],
+						X_width,
+						X_height );
+
+	    grabsharedmemory(images[i]->bytes_per_line * images[i]->height, i);
+
+
+	    // UNUSED
+	    // create the shared memory segment
+	    // X_shminfo.shmid = shmget (IPC_PRIVATE,
+	    // image->bytes_per_line * image->height, IPC_CREAT | 0777);
+	    // if (X_shminfo.shmid < 0)
+	    // {
+	    // perror("");
+	    // I_Error("shmget() failed in InitGraphics()");
+	    // }
+	    // fprintf(stderr, "shared memory id=%d\n", X_shminfo.shmid);
+	    // attach to the shared memory segment
+	    // image->data = X_shminfo.shmaddr = shmat(X_shminfo.shmid, 0, 0);
 	
 
-	if (!image->data)
-	{
-	    perror("");
-	    I_Error("shmat() failed in InitGraphics()");
-	}
+	    if (!images[i]->data)
+	    {
+		perror("");
+		I_Error("shmat() failed in InitGraphics()");
+	    }
 
-	// get the X server to attach to it
-	if (!XShmAttach(X_display, &X_shminfo))
-	    I_Error("XShmAttach() failed in InitGraphics()");
+	    // get the X server to attach to it
+	    if (!XShmAttach(X_display, &X_shminfo[i]))
+		I_Error("XShmAttach() failed in InitGraphics()");
+	}
 
     }
     else
     {
-	image = XCreateImage(	X_display,
-    				X_visual,
-    				8,
-    				ZPixmap,
-    				0,
-    				(char*)malloc(X_width * X_height),
-    				X_width, X_height,
-    				8,
-    				X_width );
+	for (i=0 ; i<numimages ; i++)
+	    images[i] = XCreateImage(	X_display,
+					X_visual,
+					8,
+					ZPixmap,
+					0,
+					(char*)malloc(X_width * X_height),
+					X_width, X_height,
+					8,
+					X_width );
+
+	if (numimages > 1)
+	{
+	    presentthread = true;
+	    if (pthread_create (&presentthreadid, NULL,
+				I_PresentThread, NULL))
+		I_Error("I_InitGraphics: can't start the present thread");
+	}
 
     }
+    image = images[0];
 
-    if (multiply == 1)
+    if (multiply == 1 && numimages == 1)
 	screens[0] = (unsigned char *) (image->data);
     else
 	screens[0] = (unsigned char *) malloc (SCREENWIDTH * SCREENHEIGHT);
 
+    if (inputthread
+	&& pthread_create (&inputthreadid, NULL, I_InputThread, NULL))
+	I_Error("I_InitGraphics: can't start the input thread");
+
 }
 
 
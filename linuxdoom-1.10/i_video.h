@@ -49,6 +49,7 @@ void I_FinishUpdate (void);
 void I_WaitVBL(int count);
 
 void I_ReadScreen (byte* scr);
+void I_ReadPalette (byte* palette);
 
 void I_BeginRead (void);
 void I_EndRead (void);
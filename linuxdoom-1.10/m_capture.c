@@ -0,0 +1,731 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Screen shots and frame capture.
+//	The game thread only copies the screen and palette into a
+//	slot of a bounded queue; encoder threads convert the frames
+//	and the first one free writes them out in order. When the
+//	queue is full the game waits, so no frame is ever lost.
+//	  -capture file	writes every tic as a raw 320x200 rgb24
+//			frame at 35 fps, e.g. for
+//	  ffmpeg -f rawvideo -pix_fmt rgb24 -s 320x200 -r 35 -i file
+//	With -timedemo that is every frame of the demo, as fast
+//	as the encoder keeps up.
+//	M_StartRender writes an uncompressed AVI instead, with the
+//	sound of each tic; see G_RenderDemo.
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "i_sound.h"
+#include "i_video.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "m_swap.h"
+
+#include "m_capture.h"
+
+
+#define CAPTURESLOTS	16
+#define MAXENCODERS	16
+
+#define FRAMESIZE	(SCREENWIDTH*SCREENHEIGHT*3)
+
+// A RIFF AVI must stay below 2 GB, longer videos
+//  go on in name-1.avi, name-2.avi, ...
+#define AVIMAXSIZE	0x40000000
+
+
+typedef enum
+{
+    cap_screenshot,
+    cap_frame
+
+} capturekind_t;
+
+
+typedef struct
+{
+    capturekind_t	kind;
+    boolean		encoded;
+
+    byte		screen[SCREENWIDTH*SCREENHEIGHT];
+    byte		palette[768];
+    short		audio[CAPTURESAMPLES*2];
+    int			samples;
+
+    byte		rgb[FRAMESIZE];
+
+} captureslot_t;
+
+
+// Slot of sequence number n is slots[n%CAPTURESLOTS].
+// Those from written to claimed are being encoded or wait
+//  to be written, those from claimed to queued wait for
+//  an encoder.
+static captureslot_t*	slots;
+static int		queued;
+static int		claimed;
+static int		written;
+static boolean		writing;
+
+static pthread_t	encoders[MAXENCODERS];
+static int		numencoders;
+static pthread_mutex_t	capturelock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	capturecond = PTHREAD_COND_INITIALIZER;
+
+static FILE*		capturefile;
+static char*		capturename;
+static int		capturetic;
+static boolean		captureavi;
+
+// AVI being written
+static int		avisegment;
+static int		aviframes;
+static int		avisamples;
+static int		avimovi;	// file offset of "movi"
+static int*		aviindex;	// id, flags, offset, size
+static int		aviindexcount;
+static int		aviindexalloc;
+
+// statistics
+static int		captureframes;
+static int		capturescreenshots;
+static int		capturestalls;
+static int		capturestalltime;
+
+
+
+//
+// AVI FILES
+// Uncompressed bottom up BGR video and 16bit stereo PCM.
+//
+static byte*	avi_p;
+
+static void AVI_Id (char* id)
+{
+    memcpy (avi_p, id, 4);
+    avi_p += 4;
+}
+
+static void AVI_Long (int value)
+{
+    avi_p[0] = value;
+    avi_p[1] = value>>8;
+    avi_p[2] = value>>16;
+    avi_p[3] = value>>24;
+    avi_p += 4;
+}
+
+static void AVI_Short (int value)
+{
+    avi_p[0] = value;
+    avi_p[1] = value>>8;
+    avi_p += 2;
+}
+
+// Starts a chunk, returns where its size goes.
+static byte* AVI_Chunk (char* id)
+{
+    byte*	size;
+
+    AVI_Id (id);
+    size = avi_p;
+    AVI_Long (0);
+    return size;
+}
+
+static void AVI_EndChunk (byte* size)
+{
+    byte*	end;
+
+    end = avi_p;
+    avi_p = size;
+    AVI_Long (end - (size+4));
+    avi_p = end;
+}
+
+
+//
+// M_AVIHeader
+// Everything up to the movi data, with the current counts.
+//
+static int M_AVIHeader (byte* buffer)
+{
+    byte*	hdrl;
+    byte*	strl;
+    byte*	chunk;
+
+    avi_p = buffer;
+    AVI_Chunk ("RIFF");
+    AVI_Id ("AVI ");
+
+    hdrl = AVI_Chunk ("LIST");
+    AVI_Id ("hdrl");
+
+    chunk = AVI_Chunk ("avih");
+    AVI_Long (1000000/TICRATE);			// us per frame
+    AVI_Long ((FRAMESIZE+CAPTURESAMPLES*4)*TICRATE);
+    AVI_Long (0);				// padding
+    AVI_Long (0x10);				// has index
+    AVI_Long (aviframes);
+    AVI_Long (0);				// initial frames
+    AVI_Long (2);				// streams
+    AVI_Long (FRAMESIZE);
+    AVI_Long (SCREENWIDTH);
+    AVI_Long (SCREENHEIGHT);
+    AVI_Long (0);
+    AVI_Long (0);
+    AVI_Long (0);
+    AVI_Long (0);
+    AVI_EndChunk (chunk);
+
+    // video
+    strl = AVI_Chunk ("LIST");
+    AVI_Id ("strl");
+    chunk = AVI_Chunk ("strh");
+    AVI_Id ("vids");
+    AVI_Id ("DIB ");
+    AVI_Long (0);				// flags
+    AVI_Short (0);				// priority
+    AVI_Short (0);				// language
+    AVI_Long (0);				// initial frames
+    AVI_Long (1);				// scale
+    AVI_Long (TICRATE);				// rate
+    AVI_Long (0);				// start
+    AVI_Long (aviframes);
+    AVI_Long (FRAMESIZE);
+    AVI_Long (-1);				// quality
+    AVI_Long (0);				// sample size
+    AVI_Short (0);
+    AVI_Short (0);
+    AVI_Short (SCREENWIDTH);
+    AVI_Short (SCREENHEIGHT);
+    AVI_EndChunk (chunk);
+    chunk = AVI_Chunk ("strf");
+    AVI_Long (40);
+    AVI_Long (SCREENWIDTH);
+    AVI_Long (SCREENHEIGHT);			// positive, bottom up
+    AVI_Short (1);				// planes
+    AVI_Short (24);				// bits
+    AVI_Long (0);				// uncompressed
+    AVI_Long (FRAMESIZE);
+    AVI_Long (0);
+    AVI_Long (0);
+    AVI_Long (0);
+    AVI_Long (0);
+    AVI_EndChunk (chunk);
+    AVI_EndChunk (strl);
+
+    // sound
+    strl = AVI_Chunk ("LIST");
+    AVI_Id ("strl");
+    chunk = AVI_Chunk ("strh");
+    AVI_Id ("auds");
+    AVI_Long (0);				// handler
+    AVI_Long (0);
+    AVI_Short (0);
+    AVI_Short (0);
+    AVI_Long (0);
+    AVI_Long (4);				// scale, block size
+    AVI_Long (SAMPLERATE*4);			// rate, bytes
+    AVI_Long (0);
+    AVI_Long (avisamples);
+    AVI_Long (CAPTURESAMPLES*4);
+    AVI_Long (-1);
+    AVI_Long (4);				// sample size
+    AVI_Short (0);
+    AVI_Short (0);
+    AVI_Short (0);
+    AVI_Short (0);
+    AVI_EndChunk (chunk);
+    chunk = AVI_Chunk ("strf");
+    AVI_Short (1);				// PCM
+    AVI_Short (2);				// stereo
+    AVI_Long (SAMPLERATE);
+    AVI_Long (SAMPLERATE*4);
+    AVI_Short (4);				// block align
+    AVI_Short (16);				// bits
+    AVI_EndChunk (chunk);
+    AVI_EndChunk (strl);
+    AVI_EndChunk (hdrl);
+
+    // movi list and RIFF sizes are filled in by M_AVIClose
+    AVI_Id ("LIST");
+    AVI_Long (0);
+    AVI_Id ("movi");
+
+    return avi_p - buffer;
+}
+
+
+static void M_AVIOpen (void)
+{
+    byte	header[512];
+    char	name[1024];
+    char*	ext;
+    int		length;
+
+    if (!avisegment)
+	sprintf (name, "%.1000s", capturename);
+    else
+    {
+	// name-1.avi
+	ext = strrchr (capturename, '.');
+	if (!ext)
+	    ext = capturename + strlen (capturename);
+	sprintf (name, "%.*s-%i%.16s", (int)(ext-capturename)%1000,
+		 capturename, avisegment, ext);
+    }
+
+    capturefile = fopen (name, "wb");
+    if (!capturefile)
+    {
+	printf ("M_Capture: couldn't create %s\n", name);
+	return;
+    }
+
+    aviframes = avisamples = aviindexcount = 0;
+    length = M_AVIHeader (header);
+    fwrite (header, length, 1, capturefile);
+    avimovi = length - 4;
+}
+
+
+static void M_AVIClose (void)
+{
+    byte	header[512];
+    byte	size[4];
+    int		length;
+    int		end;
+
+    if (!capturefile)
+	return;
+
+    // index, offsets from "movi"
+    end = ftell (capturefile);
+    avi_p = size;
+    fwrite ("idx1", 4, 1, capturefile);
+    AVI_Long (aviindexcount*16);
+    fwrite (size, 4, 1, capturefile);
+    fwrite (aviindex, 16, aviindexcount, capturefile);
+    length = ftell (capturefile);
+
+    // header again with the counts and sizes
+    M_AVIHeader (header);
+    avi_p = header+4;
+    AVI_Long (length-8);
+    avi_p = header+avimovi-4;
+    AVI_Long (end-avimovi);
+    fseek (capturefile, 0, SEEK_SET);
+    fwrite (header, avimovi+4, 1, capturefile);
+
+    fclose (capturefile);
+    capturefile = NULL;
+}
+
+
+static void
+M_AVIWrite
+( char*		id,
+  void*		data,
+  int		length )
+{
+    byte	header[8];
+    int*	entry;
+
+    if (aviindexcount == aviindexalloc)
+    {
+	aviindexalloc = aviindexalloc ? aviindexalloc*2 : 4096;
+	aviindex = realloc (aviindex, aviindexalloc*16);
+	if (!aviindex)
+	    I_Error ("M_Capture: no memory for the AVI index");
+    }
+
+    entry = aviindex + aviindexcount*4;
+    avi_p = (byte *)entry;
+    AVI_Id (id);
+    AVI_Long (0x10);				// key frame
+    AVI_Long (ftell (capturefile) - avimovi);
+    AVI_Long (length);
+    aviindexcount++;
+
+    avi_p = header;
+    AVI_Id (id);
+    AVI_Long (length);
+    fwrite (header, 8, 1, capturefile);
+    fwrite (data, length, 1, capturefile);
+}
+
+
+
+//
+// M_EncodeFrame
+// Palette lookup, to top down RGB for a raw stream
+//  or bottom up BGR for an AVI.
+//
+static void M_EncodeFrame (captureslot_t* slot)
+{
+    byte*	src;
+    byte*	dest;
+    byte*	pal;
+    int		x;
+    int		y;
+    int		i;
+
+    src = slot->screen;
+    for (y=0 ; y<SCREENHEIGHT ; y++)
+    {
+	if (captureavi)
+	    dest = slot->rgb + (SCREENHEIGHT-1-y)*SCREENWIDTH*3;
+	else
+	    dest = slot->rgb + y*SCREENWIDTH*3;
+
+	for (x=0 ; x<SCREENWIDTH ; x++, src++)
+	{
+	    pal = slot->palette + *src*3;
+	    if (captureavi)
+	    {
+		*dest++ = pal[2];
+		*dest++ = pal[1];
+		*dest++ = pal[0];
+	    }
+	    else
+	    {
+		*dest++ = pal[0];
+		*dest++ = pal[1];
+		*dest++ = pal[2];
+	    }
+	}
+    }
+
+    // little endian samples
+    for (i=0 ; i<slot->samples*2 ; i++)
+	slot->audio[i] = SHORT(slot->audio[i]);
+}
+
+
+//
+// M_WriteFrame
+//
+static void M_WriteFrame (captureslot_t* slot)
+{
+    if (!capturefile)
+	return;
+
+    if (!captureavi)
+    {
+	if (fwrite (slot->rgb, FRAMESIZE, 1, capturefile) != 1)
+	{
+	    printf ("M_Capture: write to %s failed, stopped\n", capturename);
+	    fclose (capturefile);
+	    capturefile = NULL;
+	}
+	return;
+    }
+
+    if (ftell (capturefile) > AVIMAXSIZE)
+    {
+	M_AVIClose ();
+	avisegment++;
+	M_AVIOpen ();
+	if (!capturefile)
+	    return;
+    }
+
+    M_AVIWrite ("00db", slot->rgb, FRAMESIZE);
+    aviframes++;
+    if (slot->samples)
+    {
+	M_AVIWrite ("01wb", slot->audio, slot->samples*4);
+	avisamples += slot->samples;
+    }
+}
+
+
+//
+// M_WriteScreenShot
+//
+static void M_WriteScreenShot (captureslot_t* slot)
+{
+    int		i;
+    char	lbmname[12];
+
+    // find a file name to save it to
+    strcpy(lbmname,"DOOM00.pcx");
+
+    for (i=0 ; i<=99 ; i++)
+    {
+	lbmname[4] = i/10 + '0';
+	lbmname[5] = i%10 + '0';
+	if (access(lbmname,0) == -1)
+	    break;	// file doesn't exist
+    }
+    if (i==100)
+    {
+	printf ("M_ScreenShot: Couldn't create a PCX\n");
+	return;
+    }
+
+    // save the pcx file
+    WritePCXfile (lbmname, slot->screen,
+		  SCREENWIDTH, SCREENHEIGHT,
+		  slot->palette);
+}
+
+
+//
+// M_EncoderThread
+// Writes the oldest slot once it is encoded,
+//  otherwise encodes the next one.
+//
+static void* M_EncoderThread (void* unused)
+{
+    captureslot_t*	slot;
+
+    pthread_mutex_lock (&capturelock);
+    while (1)
+    {
+	slot = &slots[written%CAPTURESLOTS];
+	if (!writing && written < claimed && slot->encoded)
+	{
+	    writing = true;
+	    pthread_mutex_unlock (&capturelock);
+
+	    if (slot->kind == cap_screenshot)
+		M_WriteScreenShot (slot);
+	    else
+		M_WriteFrame (slot);
+
+	    pthread_mutex_lock (&capturelock);
+	    slot->encoded = false;
+	    written++;
+	    writing = false;
+	    pthread_cond_broadcast (&capturecond);
+	    continue;
+	}
+
+	if (claimed < queued)
+	{
+	    slot = &slots[claimed%CAPTURESLOTS];
+	    claimed++;
+	    pthread_mutex_unlock (&capturelock);
+
+	    if (slot->kind == cap_frame)
+		M_EncodeFrame (slot);
+
+	    pthread_mutex_lock (&capturelock);
+	    slot->encoded = true;
+	    pthread_cond_broadcast (&capturecond);
+	    continue;
+	}
+
+	pthread_cond_wait (&capturecond, &capturelock);
+    }
+    return NULL;
+}
+
+
+
+//
+// M_StartEncoders
+//
+static void M_StartEncoders (int count)
+{
+    if (slots)
+	return;
+
+    slots = calloc (CAPTURESLOTS, sizeof(*slots));
+    if (!slots)
+	I_Error ("M_Capture: no memory for the queue");
+
+    if (count > MAXENCODERS)
+	count = MAXENCODERS;
+    for (numencoders=0 ; numencoders<count ; numencoders++)
+	if (pthread_create (&encoders[numencoders], NULL,
+			    M_EncoderThread, NULL))
+	    I_Error ("M_Capture: can't start an encoder thread");
+}
+
+
+//
+// M_CaptureQueue
+// Copies the screen into the next slot, waiting for one if needed.
+//
+static void
+M_CaptureQueue
+( capturekind_t	kind,
+  short*	audio,
+  int		samples )
+{
+    captureslot_t*	slot;
+    int			start;
+
+    M_StartEncoders (1);
+
+    pthread_mutex_lock (&capturelock);
+    if (queued - written == CAPTURESLOTS)
+    {
+	capturestalls++;
+	start = I_GetTimeUS ();
+	while (queued - written == CAPTURESLOTS)
+	    pthread_cond_wait (&capturecond, &capturelock);
+	capturestalltime += I_GetTimeUS () - start;
+    }
+    slot = &slots[queued%CAPTURESLOTS];
+    pthread_mutex_unlock (&capturelock);
+
+    // only this thread touches a slot past queued
+    slot->kind = kind;
+    I_ReadScreen (slot->screen);
+    I_ReadPalette (slot->palette);
+    slot->samples = samples;
+    if (samples)
+	memcpy (slot->audio, audio, samples*4);
+
+    pthread_mutex_lock (&capturelock);
+    queued++;
+    pthread_cond_broadcast (&capturecond);
+    pthread_mutex_unlock (&capturelock);
+}
+
+
+
+//
+// M_InitCapture
+//
+void M_InitCapture (void)
+{
+    int		p;
+
+    p = M_CheckParm ("-capture");
+    if (!p || p >= myargc-1)
+	return;
+
+    capturename = myargv[p+1];
+    capturefile = fopen (capturename, "wb");
+    if (!capturefile)
+	I_Error ("M_InitCapture: couldn't create %s", capturename);
+
+    printf ("M_InitCapture: %ix%i rgb24 frames at %i fps to %s\n",
+	    SCREENWIDTH, SCREENHEIGHT, TICRATE, capturename);
+    capturetic = -1;
+    M_StartEncoders (1);
+}
+
+
+//
+// M_StartRender
+//
+void
+M_StartRender
+( char*		filename,
+  int		jobs )
+{
+    capturename = filename;
+    captureavi = true;
+    M_AVIOpen ();
+    if (!capturefile)
+	I_Error ("M_StartRender: couldn't create %s", capturename);
+
+    M_StartEncoders (jobs);
+    printf ("M_StartRender: %s, %i encoder threads\n",
+	    capturename, numencoders);
+}
+
+
+//
+// M_CaptureScreenShot
+//
+void M_CaptureScreenShot (void)
+{
+    capturescreenshots++;
+    M_CaptureQueue (cap_screenshot, NULL, 0);
+}
+
+
+//
+// M_CaptureFrame
+//
+void
+M_CaptureFrame
+( short*	audio,
+  int		samples )
+{
+    captureframes++;
+    M_CaptureQueue (cap_frame, audio, samples);
+}
+
+
+//
+// M_CaptureTicker
+// The video runs on game tics, so a frame that shows
+//  several tics is repeated and one that shows none is dropped.
+//
+void M_CaptureTicker (void)
+{
+    if (!capturefile || captureavi)
+	return;
+
+    if (capturetic == -1)
+	capturetic = gametic-1;
+
+    for ( ; capturetic < gametic ; capturetic++)
+	M_CaptureFrame (NULL, 0);
+}
+
+
+//
+// M_FinishCapture
+//
+void M_FinishCapture (void)
+{
+    if (!slots)
+	return;
+
+    pthread_mutex_lock (&capturelock);
+    while (written < queued)
+	pthread_cond_wait (&capturecond, &capturelock);
+    pthread_mutex_unlock (&capturelock);
+
+    if (captureavi)
+	M_AVIClose ();
+    else if (capturefile)
+	fclose (capturefile);
+    capturefile = NULL;
+
+    if (captureframes || capturescreenshots)
+	printf ("M_Capture: %i frames, %i screen shots, "
+		"queue full %i times for %i ms\n",
+		captureframes, capturescreenshots,
+		capturestalls, capturestalltime/1000);
+    captureframes = capturescreenshots = 0;
+}
@@ -0,0 +1,68 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Screen shots and frame capture on an encoder thread.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __M_CAPTURE__
+#define __M_CAPTURE__
+
+#include "doomtype.h"
+#include "doomdef.h"
+#include "i_sound.h"
+
+// Sound samples per tic in a rendered video.
+#define CAPTURESAMPLES	(SAMPLERATE/TICRATE)
+
+
+// Called by startup code, reads -capture.
+void M_InitCapture (void);
+
+// Opens an AVI for G_RenderDemo,
+//  with jobs threads to encode the frames.
+void
+M_StartRender
+( char*		filename,
+  int		jobs );
+
+// Queues the screen for a PCX file, see M_ScreenShot.
+void M_CaptureScreenShot (void);
+
+// Queues the screen as the next video frame,
+//  with samples stereo samples of sound.
+void
+M_CaptureFrame
+( short*	audio,
+  int		samples );
+
+// Called by D_DoomLoop after each frame,
+//  queues one video frame per tic run.
+void M_CaptureTicker (void);
+
+// Waits for the queue to drain and closes the capture.
+// Called by I_Quit and I_Error.
+void M_FinishCapture (void);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
@@ -29,9 +29,13 @@ rcsid[] = "$Id: m_misc.c,v 1.6 1997/02/03 22:45:10 b1 Exp $";
 
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <signal.h>
 
 #include <ctype.h>
 
@@ -50,6 +54,8 @@ rcsid[] = "$Id: m_misc.c,v 1.6 1997/02/03 22:45:10 b1 Exp $";
 #include "v_video.h"
 
 #include "hu_stuff.h"
+#include "s_sound.h"
+#include "r_main.h"
 
 // State.
 #include "doomstat.h"
@@ -58,6 +64,7 @@ rcsid[] = "$Id: m_misc.c,v 1.6 1997/02/03 22:45:10 b1 Exp $";
 #include "dstrings.h"
 
 #include "m_misc.h"
+#include "m_capture.h"
 
 //
 // M_DrawText
@@ -191,8 +198,8 @@ extern int	joybstrafe;
 extern int	joybuse;
 extern int	joybspeed;
 
-extern int	viewwidth;
-extern int	viewheight;
+extern VIEWLOCAL int	viewwidth;
+extern VIEWLOCAL int	viewheight;
 
 extern int	mouseSensitivity;
 extern int	showMessages;
@@ -210,7 +217,6 @@ extern	int	numChannels;
 // UNIX hack, to be removed.
 #ifdef SNDSERV
 extern char*	sndserver_filename;
-extern int	mb_used;
 #endif
 
 #ifdef LINUX
@@ -220,70 +226,88 @@ char*		mousedev;
 
 extern char*	chat_macros[];
 
+// performance options, see I_ZoneBase, W_MapFile
+//  and R_InitViewThreads
+extern int	mb_used;
+extern int	mb_max;
+extern int	mb_chunk;
+extern boolean	hugepages;
+extern boolean	wadmap;
+extern int	viewthreadcount;
+
+// UDP port on 127.0.0.1 for M_PollDefaults, 0 for none
+int		adminport;
 
 
-typedef struct
+
+typedef struct default_s
 {
     char*	name;
     int*	location;
     int		defaultvalue;
+    int		minvalue;		// if below maxvalue,
+    int		maxvalue;		//  the values accepted
+    boolean	startup;		// only read at startup
     int		scantranslate;		// PC scan code hack
     int		untranslated;		// lousy hack
+
+    struct default_s*	hashnext;
+    int		savedvalue;		// as in the file
+    char*	savedstring;		//  for string settings
 } default_t;
 
 default_t	defaults[] =
 {
-    {"mouse_sensitivity",&mouseSensitivity, 5},
-    {"sfx_volume",&snd_SfxVolume, 8},
-    {"music_volume",&snd_MusicVolume, 8},
-    {"show_messages",&showMessages, 1},
+    {"mouse_sensitivity",&mouseSensitivity, 5, 0, 9},
+    {"sfx_volume",&snd_SfxVolume, 8, 0, 15},
+    {"music_volume",&snd_MusicVolume, 8, 0, 15},
+    {"show_messages",&showMessages, 1, 0, 1},
     
 
 #ifdef NORMALUNIX
-    {"key_right",&key_right, KEY_RIGHTARROW},
-    {"key_left",&key_left, KEY_LEFTARROW},
-    {"key_up",&key_up, KEY_UPARROW},
-    {"key_down",&key_down, KEY_DOWNARROW},
-    {"key_strafeleft",&key_strafeleft, ','},
-    {"key_straferight",&key_straferight, '.'},
-
-    {"key_fire",&key_fire, KEY_RCTRL},
-    {"key_use",&key_use, ' '},
-    {"key_strafe",&key_strafe, KEY_RALT},
-    {"key_speed",&key_speed, KEY_RSHIFT},
+    {"key_right",&key_right, KEY_RIGHTARROW, 0, 255},
+    {"key_left",&key_left, KEY_LEFTARROW, 0, 255},
+    {"key_up",&key_up, KEY_UPARROW, 0, 255},
+    {"key_down",&key_down, KEY_DOWNARROW, 0, 255},
+    {"key_strafeleft",&key_strafeleft, ',', 0, 255},
+    {"key_straferight",&key_straferight, '.', 0, 255},
+
+    {"key_fire",&key_fire, KEY_RCTRL, 0, 255},
+    {"key_use",&key_use, ' ', 0, 255},
+    {"key_strafe",&key_strafe, KEY_RALT, 0, 255},
+    {"key_speed",&key_speed, KEY_RSHIFT, 0, 255},
 
 // UNIX hack, to be removed. 
 #ifdef SNDSERV
-    {"sndserver", (int *) &sndserver_filename, (int) "sndserver"},
-    {"mb_used", &mb_used, 2},
+    {"sndserver", (int *) &sndserver_filename, (int) "sndserver", 0, 0, true},
 #endif
     
 #endif
 
 #ifdef LINUX
-    {"mousedev", (int*)&mousedev, (int)"/dev/ttyS0"},
-    {"mousetype", (int*)&mousetype, (int)"microsoft"},
+    {"mousedev", (int*)&mousedev, (int)"/dev/ttyS0", 0, 0, true},
+    {"mousetype", (int*)&mousetype, (int)"microsoft", 0, 0, true},
 #endif
 
-    {"use_mouse",&usemouse, 1},
-    {"mouseb_fire",&mousebfire,0},
-    {"mouseb_strafe",&mousebstrafe,1},
-    {"mouseb_forward",&mousebforward,2},
+    {"use_mouse",&usemouse, 1, 0, 1},
+    {"mouseb_fire",&mousebfire,0, -1, 2},
+    {"mouseb_strafe",&mousebstrafe,1, -1, 2},
+    {"mouseb_forward",&mousebforward,2, -1, 2},
 
-    {"use_joystick",&usejoystick, 0},
-    {"joyb_fire",&joybfire,0},
-    {"joyb_strafe",&joybstrafe,1},
-    {"joyb_use",&joybuse,3},
-    {"joyb_speed",&joybspeed,2},
+    {"use_joystick",&usejoystick, 0, 0, 1},
+    {"joyb_fire",&joybfire,0, -1, 3},
+    {"joyb_strafe",&joybstrafe,1, -1, 3},
+    {"joyb_use",&joybuse,3, -1, 3},
+    {"joyb_speed",&joybspeed,2, -1, 3},
 
-    {"screenblocks",&screenblocks, 9},
-    {"detaillevel",&detailLevel, 0},
+    {"screenblocks",&screenblocks, 9, 3, 11},
+    {"detaillevel",&detailLevel, 0, 0, 1},
 
-    {"snd_channels",&numChannels, 3},
+    {"snd_channels",&numChannels, 3, 1, 32, true},
 
 
 
-    {"usegamma",&usegamma, 0},
+    {"usegamma",&usegamma, 0, 0, 4},
 
     {"chatmacro0", (int *) &chat_macros[0], (int) HUSTR_CHATMACRO0 },
     {"chatmacro1", (int *) &chat_macros[1], (int) HUSTR_CHATMACRO1 },
@@ -294,7 +318,15 @@ default_t	defaults[] =
     {"chatmacro6", (int *) &chat_macros[6], (int) HUSTR_CHATMACRO6 },
     {"chatmacro7", (int *) &chat_macros[7], (int) HUSTR_CHATMACRO7 },
     {"chatmacro8", (int *) &chat_macros[8], (int) HUSTR_CHATMACRO8 },
-    {"chatmacro9", (int *) &chat_macros[9], (int) HUSTR_CHATMACRO9 }
+    {"chatmacro9", (int *) &chat_macros[9], (int) HUSTR_CHATMACRO9 },
+
+    {"zone_mb",&mb_used, 6, 1, 2046, true},
+    {"zone_max_mb",&mb_max, 64, 1, 2046, true},
+    {"zone_chunk_mb",&mb_chunk, 4, 1, 2046, true},
+    {"huge_pages",(int *)&hugepages, 0, 0, 1, true},
+    {"wad_map",(int *)&wadmap, 0, 0, 1, true},
+    {"view_threads",&viewthreadcount, 0, 0, 16, true},
+    {"admin_port",&adminport, 0, 0, 65535, true}
 
 };
 
@@ -302,14 +334,402 @@ int	numdefaults;
 char*	defaultfile;
 
 
+// the file was there to read
+static boolean	defaultsread;
+
+// M_LoadDefaults is done, startup settings are fixed
+static boolean	defaultsstarted;
+
+
+//
+// DEFAULTS REGISTRY
+// Every setting is hashed by name, so reading the file,
+//  -set on the command line and the admin port find
+//  theirs at once. The game itself reads the variables.
+//
+#define DEFAULTHASH	64
+
+static default_t*	defaulthash[DEFAULTHASH];
+
+static int M_HashName (char* name)
+{
+    unsigned	hash;
+
+    hash = 0;
+    while (*name)
+	hash = hash*31 + *name++;
+    return hash & (DEFAULTHASH-1);
+}
+
+
+static void M_HashDefaults (void)
+{
+    int		i;
+    int		hash;
+
+    numdefaults = sizeof(defaults)/sizeof(defaults[0]);
+    for (i=0 ; i<numdefaults ; i++)
+    {
+	hash = M_HashName (defaults[i].name);
+	defaults[i].hashnext = defaulthash[hash];
+	defaulthash[hash] = &defaults[i];
+    }
+}
+
+
+static default_t* M_FindDefault (char* name)
+{
+    default_t*	def;
+
+    for (def = defaulthash[M_HashName (name)] ; def ; def = def->hashnext)
+	if (!strcmp (def->name, name))
+	    return def;
+    return NULL;
+}
+
+
+static boolean M_IsStringDefault (default_t* def)
+{
+    return def->defaultvalue <= -0xfff || def->defaultvalue >= 0xfff;
+}
+
+
+//
+// M_GetDefault
+//
+int* M_GetDefault (char* name)
+{
+    default_t*	def;
+
+    def = M_FindDefault (name);
+    return def ? def->location : NULL;
+}
+
+
+//
+// M_SetDefaultValue
+// Strings may be quoted, numbers may be 0x hex.
+// Nothing is changed if the value is bad.
+//
+static char*
+M_SetDefaultValue
+( default_t*	def,
+  char*		value )
+{
+    static char	error[64];
+    char*	newstring;
+    char*	end;
+    int		len;
+    int		parm;
+
+    if (M_IsStringDefault (def))
+    {
+	len = strlen (value);
+	if (len >= 2 && value[0] == '"' && value[len-1] == '"')
+	{
+	    value++;
+	    len -= 2;
+	}
+	newstring = (char *) malloc (len+1);
+	memcpy (newstring, value, len);
+	newstring[len] = 0;
+	*def->location = (int) newstring;
+	return NULL;
+    }
+
+    parm = strtol (value, &end, 0);
+    while (isspace (*end))
+	end++;
+    if (end == value || *end)
+	return "is not a number";
+
+    if (def->minvalue < def->maxvalue
+	&& (parm < def->minvalue || parm > def->maxvalue))
+    {
+	sprintf (error, "must be %i to %i", def->minvalue, def->maxvalue);
+	return error;
+    }
+
+    *def->location = parm;
+    return NULL;
+}
+
+
+//
+// M_SetDefault
+// Returns why the value was refused, or NULL.
+//
+char*
+M_SetDefault
+( char*		name,
+  char*		value )
+{
+    default_t*	def;
+
+    def = M_FindDefault (name);
+    if (!def)
+	return "is not a setting";
+    if (def->startup && defaultsstarted)
+	return "is only read at startup";
+    return M_SetDefaultValue (def, value);
+}
+
+
+//
+// M_ReadDefault
+// One setting from the file or the command line.
+// Once started, startup settings are left alone.
+//
+static void
+M_ReadDefault
+( char*		name,
+  char*		value )
+{
+    default_t*	def;
+    char*	error;
+
+    def = M_FindDefault (name);
+    if (!def)
+	error = "is not a setting";
+    else if (def->startup && defaultsstarted)
+	return;
+    else
+	error = M_SetDefaultValue (def, value);
+
+    if (error)
+	printf ("M_ReadDefaults: %s %s\n", name, error);
+}
+
+
+//
+// M_ReadDefaults
+// Base values, then the file, then -set name value
+//  from the command line.
+//
+static void M_ReadDefaults (void)
+{
+    int		i;
+    FILE*	f;
+    char	line[256];
+    char	def[80];
+    char	strparm[160];
+
+    for (i=0 ; i<numdefaults ; i++)
+	if (!defaults[i].startup || !defaultsstarted)
+	    *defaults[i].location = defaults[i].defaultvalue;
+
+    f = fopen (defaultfile, "r");
+    defaultsread = f != NULL;
+    if (f)
+    {
+	while (fgets (line, sizeof(line), f))
+	    if (sscanf (line, "%79s %159[^\n]", def, strparm) == 2)
+		M_ReadDefault (def, strparm);
+	fclose (f);
+    }
+
+    for (i=0 ; i<numdefaults ; i++)
+	if (!defaults[i].startup || !defaultsstarted)
+	{
+	    defaults[i].savedvalue = *defaults[i].location;
+	    if (M_IsStringDefault (&defaults[i]))
+		defaults[i].savedstring = *(char **)defaults[i].location;
+	}
+
+    for (i=1 ; i<myargc-2 ; i++)
+	if (!strcasecmp (myargv[i], "-set"))
+	    M_ReadDefault (myargv[i+1], myargv[i+2]);
+}
+
+
+//
+// M_ApplyDefaults
+// What the game only reads when it is changed.
+//
+static void M_ApplyDefaults (void)
+{
+    R_SetViewSize (screenblocks, detailLevel);
+    S_SetSfxVolume (snd_SfxVolume);
+    S_SetMusicVolume (snd_MusicVolume);
+    I_SetPalette (W_CacheLumpName ("PLAYPAL",PU_CACHE));
+}
+
+
+//
+// M_ReloadDefaults
+// Reads the config file again while the game runs.
+// Settings only used at startup, the zone and threads,
+//  keep what they started with, overrides included.
+//
+void M_ReloadDefaults (void)
+{
+    M_ReadDefaults ();
+    M_ApplyDefaults ();
+    printf ("M_ReloadDefaults: read %s\n", defaultfile);
+}
+
+
+//
+// ADMIN PORT
+// With admin_port set, or -adminport, one command per
+//  datagram on 127.0.0.1, answered to the sender:
+//	get name / set name value / reload / save
+// SIGHUP reloads the config file too.
+//
+static int		adminsocket = -1;
+static volatile int	hangup;
+
+static void M_Hangup (int sig)
+{
+    hangup = 1;
+}
+
+
+static void M_InitAdmin (void)
+{
+    struct sockaddr_in	address;
+    int			p;
+
+    signal (SIGHUP, M_Hangup);
+
+    p = M_CheckParm ("-adminport");
+    if (p && p < myargc-1)
+	adminport = atoi (myargv[p+1]);
+    if (!adminport)
+	return;
+
+    adminsocket = socket (PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    memset (&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    address.sin_port = htons (adminport);
+    if (adminsocket == -1
+	|| bind (adminsocket, (struct sockaddr *)&address,
+		 sizeof(address)) == -1)
+    {
+	printf ("M_InitAdmin: can't listen on port %i\n", adminport);
+	if (adminsocket != -1)
+	    close (adminsocket);
+	adminsocket = -1;
+	return;
+    }
+
+    fcntl (adminsocket, F_SETFL, O_NONBLOCK);
+    printf ("M_InitAdmin: listening on 127.0.0.1:%i\n", adminport);
+}
+
+
+//
+// M_AdminCommand
+// Fills in the reply.
+//
+static void
+M_AdminCommand
+( char*		command,
+  char*		reply )
+{
+    char	verb[16];
+    char	name[80];
+    char	value[160];
+    int		count;
+    int*	location;
+    char*	error;
+
+    value[0] = 0;
+    count = sscanf (command, "%15s %79s %159[^\n]", verb, name, value);
+
+    if (count >= 2 && !strcmp (verb, "get"))
+    {
+	location = M_GetDefault (name);
+	if (!location)
+	    sprintf (reply, "no setting %s\n", name);
+	else if (M_IsStringDefault (M_FindDefault (name)))
+	    sprintf (reply, "%s \"%.160s\"\n", name, *(char **)location);
+	else
+	    sprintf (reply, "%s %i\n", name, *location);
+    }
+    else if (count == 3 && !strcmp (verb, "set"))
+    {
+	error = M_SetDefault (name, value);
+	if (!error)
+	{
+	    M_ApplyDefaults ();
+	    sprintf (reply, "ok\n");
+	}
+	else
+	    sprintf (reply, "%s %s\n", name, error);
+    }
+    else if (count >= 1 && !strcmp (verb, "reload"))
+    {
+	M_ReloadDefaults ();
+	sprintf (reply, "ok\n");
+    }
+    else if (count >= 1 && !strcmp (verb, "save"))
+    {
+	M_SaveDefaults ();
+	sprintf (reply, "ok\n");
+    }
+    else
+	sprintf (reply, "get name | set name value | reload | save\n");
+}
+
+
+//
+// M_PollDefaults
+// Called once a frame by D_DoomLoop.
+//
+void M_PollDefaults (void)
+{
+    struct sockaddr_in	from;
+    socklen_t		fromlen;
+    char		command[256];
+    char		reply[320];
+    int			length;
+
+    if (hangup)
+    {
+	hangup = 0;
+	M_ReloadDefaults ();
+    }
+
+    if (adminsocket == -1)
+	return;
+
+    while (1)
+    {
+	fromlen = sizeof(from);
+	length = recvfrom (adminsocket, command, sizeof(command)-1, 0,
+			   (struct sockaddr *)&from, &fromlen);
+	if (length < 0)
+	    return;
+	command[length] = 0;
+
+	M_AdminCommand (command, reply);
+	sendto (adminsocket, reply, strlen (reply), 0,
+		(struct sockaddr *)&from, fromlen);
+    }
+}
+
+
 //
 // M_SaveDefaults
+// Leaves the file alone if nothing changed.
+// Startup settings are written as they were read,
+//  without command line overrides.
 //
 void M_SaveDefaults (void)
 {
     int		i;
     int		v;
+    char*	string;
     FILE*	f;
+
+    for (i=0 ; i<numdefaults ; i++)
+	if (!defaults[i].startup
+	    && *defaults[i].location != defaults[i].savedvalue)
+	    break;
+    if (defaultsread && i == numdefaults)
+	return;
 	
     f = fopen (defaultfile, "w");
     if (!f)
@@ -317,18 +737,30 @@ void M_SaveDefaults (void)
 		
     for (i=0 ; i<numdefaults ; i++)
     {
-	if (defaults[i].defaultvalue > -0xfff
-	    && defaults[i].defaultvalue < 0xfff)
+	if (defaults[i].startup)
+	{
+	    v = defaults[i].savedvalue;
+	    string = defaults[i].savedstring;
+	}
+	else
 	{
 	    v = *defaults[i].location;
+	    string = M_IsStringDefault (&defaults[i])
+		? *(char **)defaults[i].location : NULL;
+	}
+
+	if (!M_IsStringDefault (&defaults[i]))
+	{
 	    fprintf (f,"%s\t\t%i\n",defaults[i].name,v);
 	} else {
-	    fprintf (f,"%s\t\t\"%s\"\n",defaults[i].name,
-		     * (char **) (defaults[i].location));
+	    fprintf (f,"%s\t\t\"%s\"\n",defaults[i].name, string);
 	}
+	defaults[i].savedvalue = v;
+	defaults[i].savedstring = string;
     }
 	
     fclose (f);
+    defaultsread = true;
 }
 
 
@@ -340,18 +772,8 @@ extern byte	scantokey[128];
 void M_LoadDefaults (void)
 {
     int		i;
-    int		len;
-    FILE*	f;
-    char	def[80];
-    char	strparm[100];
-    char*	newstring;
-    int		parm;
-    boolean	isstring;
-    
-    // set everything to base values
-    numdefaults = sizeof(defaults)/sizeof(defaults[0]);
-    for (i=0 ; i<numdefaults ; i++)
-	*defaults[i].location = defaults[i].defaultvalue;
+
+    M_HashDefaults ();
     
     // check for a custom default file
     i = M_CheckParm ("-config");
@@ -362,44 +784,10 @@ void M_LoadDefaults (void)
     }
     else
 	defaultfile = basedefault;
-    
-    // read the file in, overriding any set defaults
-    f = fopen (defaultfile, "r");
-    if (f)
-    {
-	while (!feof(f))
-	{
-	    isstring = false;
-	    if (fscanf (f, "%79s %[^\n]\n", def, strparm) == 2)
-	    {
-		if (strparm[0] == '"')
-		{
-		    // get a string default
-		    isstring = true;
-		    len = strlen(strparm);
-		    newstring = (char *) malloc(len);
-		    strparm[len-1] = 0;
-		    strcpy(newstring, strparm+1);
-		}
-		else if (strparm[0] == '0' && strparm[1] == 'x')
-		    sscanf(strparm+2, "%x", &parm);
-		else
-		    sscanf(strparm, "%i", &parm);
-		for (i=0 ; i<numdefaults ; i++)
-		    if (!strcmp(def, defaults[i].name))
-		    {
-			if (!isstring)
-			    *defaults[i].location = parm;
-			else
-			    *defaults[i].location =
-				(int) newstring;
-			break;
-		    }
-	    }
-	}
-		
-	fclose (f);
-    }
+
+    M_ReadDefaults ();
+    M_InitAdmin ();
+    defaultsstarted = true;
 }
 
 
@@ -451,7 +839,10 @@ WritePCXfile
     pcx_t*	pcx;
     byte*	pack;
 	
-    pcx = Z_Malloc (width*height*2+1000, PU_STATIC, NULL);
+    // not the zone, this runs on the capture encoder thread
+    pcx = malloc (width*height*2+1000);
+    if (!pcx)
+	return;
 
     pcx->manufacturer = 0x0a;		// PCX id
     pcx->version = 5;			// 256 color
@@ -493,40 +884,17 @@ WritePCXfile
     length = pack - (byte *)pcx;
     M_WriteFile (filename, pcx, length);
 
-    Z_Free (pcx);
+    free (pcx);
 }
 
 
 //
 // M_ScreenShot
+// The file is named and written by the capture thread.
 //
 void M_ScreenShot (void)
 {
-    int		i;
-    byte*	linear;
-    char	lbmname[12];
-    
-    // munge planar buffer to linear
-    linear = screens[2];
-    I_ReadScreen (linear);
-    
-    // find a file name to save it to
-    strcpy(lbmname,"DOOM00.pcx");
-		
-    for (i=0 ; i<=99 ; i++)
-    {
-	lbmname[4] = i/10 + '0';
-	lbmname[5] = i%10 + '0';
-	if (access(lbmname,0) == -1)
-	    break;	// file doesn't exist
-    }
-    if (i==100)
-	I_Error ("M_ScreenShot: Couldn't create a PCX");
-    
-    // save the pcx file
-    WritePCXfile (lbmname, linear,
-		  SCREENWIDTH, SCREENHEIGHT,
-		  W_CacheLumpName ("PLAYPAL",PU_CACHE));
+    M_CaptureScreenShot ();
 	
     players[consoleplayer].message = "screen shot";
 }
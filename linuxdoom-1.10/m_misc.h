@@ -44,10 +44,31 @@ M_ReadFile
 
 void M_ScreenShot (void);
 
+void
+WritePCXfile
+( char*		filename,
+  byte*		data,
+  int		width,
+  int		height,
+  byte*		palette );
+
 void M_LoadDefaults (void);
 
 void M_SaveDefaults (void);
 
+// Settings by name, as in the config file.
+// M_GetDefault returns NULL for no such setting.
+// M_SetDefault checks the value against the setting's
+//  range and returns why it was refused, or NULL.
+int*	M_GetDefault (char* name);
+char*	M_SetDefault (char* name, char* value);
+
+// Reads the config file again, see M_InitAdmin.
+void M_ReloadDefaults (void);
+
+// Handles SIGHUP and the admin port, once a frame.
+void M_PollDefaults (void);
+
 
 int
 M_DrawText
@@ -38,6 +38,10 @@ int P_Random (void);
 // Fix randoms for demos.
 void M_ClearRandom (void);
 
+// Table positions, kept by snapshots.
+extern int	rndindex;
+extern int	prndindex;
+
 
 #endif
 //-----------------------------------------------------------------------------
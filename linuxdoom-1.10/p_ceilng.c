@@ -72,7 +72,7 @@ void T_MoveCeiling (ceiling_t* ceiling)
 	      case silentCrushAndRaise:
 		break;
 	      default:
-		S_StartSound((mobj_t *)&ceiling->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(ceiling->sector)->soundorg,
 			     sfx_stnmov);
 		// ?
 		break;
@@ -88,7 +88,7 @@ void T_MoveCeiling (ceiling_t* ceiling)
 		break;
 		
 	      case silentCrushAndRaise:
-		S_StartSound((mobj_t *)&ceiling->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(ceiling->sector)->soundorg,
 			     sfx_pstop);
 	      case fastCrushAndRaise:
 	      case crushAndRaise:
@@ -115,7 +115,7 @@ void T_MoveCeiling (ceiling_t* ceiling)
 	    {
 	      case silentCrushAndRaise: break;
 	      default:
-		S_StartSound((mobj_t *)&ceiling->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(ceiling->sector)->soundorg,
 			     sfx_stnmov);
 	    }
 	}
@@ -125,7 +125,7 @@ void T_MoveCeiling (ceiling_t* ceiling)
 	    switch(ceiling->type)
 	    {
 	      case silentCrushAndRaise:
-		S_StartSound((mobj_t *)&ceiling->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(ceiling->sector)->soundorg,
 			     sfx_pstop);
 	      case crushAndRaise:
 		ceiling->speed = CEILSPEED;
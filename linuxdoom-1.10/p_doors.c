@@ -74,19 +74,19 @@ void T_VerticalDoor (vldoor_t* door)
 	    {
 	      case blazeRaise:
 		door->direction = -1; // time to go back down
-		S_StartSound((mobj_t *)&door->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			     sfx_bdcls);
 		break;
 		
 	      case normal:
 		door->direction = -1; // time to go back down
-		S_StartSound((mobj_t *)&door->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			     sfx_dorcls);
 		break;
 		
 	      case close30ThenOpen:
 		door->direction = 1;
-		S_StartSound((mobj_t *)&door->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			     sfx_doropn);
 		break;
 		
@@ -105,7 +105,7 @@ void T_VerticalDoor (vldoor_t* door)
 	      case raiseIn5Mins:
 		door->direction = 1;
 		door->type = normal;
-		S_StartSound((mobj_t *)&door->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			     sfx_doropn);
 		break;
 		
@@ -129,7 +129,7 @@ void T_VerticalDoor (vldoor_t* door)
 	      case blazeClose:
 		door->sector->specialdata = NULL;
 		P_RemoveThinker (&door->thinker);  // unlink and free
-		S_StartSound((mobj_t *)&door->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			     sfx_bdcls);
 		break;
 		
@@ -158,7 +158,7 @@ void T_VerticalDoor (vldoor_t* door)
 		
 	      default:
 		door->direction = 1;
-		S_StartSound((mobj_t *)&door->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			     sfx_doropn);
 		break;
 	    }
@@ -298,7 +298,7 @@ EV_DoDoor
 	    door->topheight -= 4*FRACUNIT;
 	    door->direction = -1;
 	    door->speed = VDOORSPEED * 4;
-	    S_StartSound((mobj_t *)&door->sector->soundorg,
+	    S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			 sfx_bdcls);
 	    break;
 	    
@@ -306,14 +306,14 @@ EV_DoDoor
 	    door->topheight = P_FindLowestCeilingSurrounding(sec);
 	    door->topheight -= 4*FRACUNIT;
 	    door->direction = -1;
-	    S_StartSound((mobj_t *)&door->sector->soundorg,
+	    S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			 sfx_dorcls);
 	    break;
 	    
 	  case close30ThenOpen:
 	    door->topheight = sec->ceilingheight;
 	    door->direction = -1;
-	    S_StartSound((mobj_t *)&door->sector->soundorg,
+	    S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			 sfx_dorcls);
 	    break;
 	    
@@ -324,7 +324,7 @@ EV_DoDoor
 	    door->topheight -= 4*FRACUNIT;
 	    door->speed = VDOORSPEED * 4;
 	    if (door->topheight != sec->ceilingheight)
-		S_StartSound((mobj_t *)&door->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			     sfx_bdopn);
 	    break;
 	    
@@ -334,7 +334,7 @@ EV_DoDoor
 	    door->topheight = P_FindLowestCeilingSurrounding(sec);
 	    door->topheight -= 4*FRACUNIT;
 	    if (door->topheight != sec->ceilingheight)
-		S_StartSound((mobj_t *)&door->sector->soundorg,
+		S_StartSound((mobj_t *)&SECTORINFO(door->sector)->soundorg,
 			     sfx_doropn);
 	    break;
 	    
@@ -441,16 +441,16 @@ EV_VerticalDoor
     {
       case 117:	// BLAZING DOOR RAISE
       case 118:	// BLAZING DOOR OPEN
-	S_StartSound((mobj_t *)&sec->soundorg,sfx_bdopn);
+	S_StartSound((mobj_t *)&SECTORINFO(sec)->soundorg,sfx_bdopn);
 	break;
 	
       case 1:	// NORMAL DOOR SOUND
       case 31:
-	S_StartSound((mobj_t *)&sec->soundorg,sfx_doropn);
+	S_StartSound((mobj_t *)&SECTORINFO(sec)->soundorg,sfx_doropn);
 	break;
 	
       default:	// LOCKED DOOR SOUND
-	S_StartSound((mobj_t *)&sec->soundorg,sfx_doropn);
+	S_StartSound((mobj_t *)&SECTORINFO(sec)->soundorg,sfx_doropn);
 	break;
     }
 	
@@ -30,6 +30,7 @@ rcsid[] = "$Id: p_enemy.c,v 1.5 1997/02/03 22:45:11 b1 Exp $";
 
 #include "m_random.h"
 #include "i_system.h"
+#include "z_zone.h"
 
 #include "doomdef.h"
 #include "p_local.h"
@@ -95,56 +96,280 @@ void A_Fall (mobj_t *actor);
 
 
 //
-// Called by P_NoiseAlert.
-// Recursively traverse adjacent sectors,
-// sound blocking lines cut off traversal.
+// Set by P_NoiseAlert for the sectors it reaches.
 //
-
 mobj_t*		soundtarget;
 
-void
-P_RecursiveSound
-( sector_t*	sec,
-  int		soundblocks )
+
+//
+// SOUND PROPAGATION GRAPH
+// Sound floods through open two-sided lines, and through
+//  at most one open line marked ML_SOUNDBLOCK.
+// Sectors joined by open lines that do not block sound
+//  form a zone. A noise wakes its own zone, traversed 1,
+//  and every zone one open sound blocking line away,
+//  traversed 2, as the old recursive flood fill did.
+// The zones are rebuilt when a line opens or closes,
+//  which only lines of sectors that moved can do.
+//
+static byte*	soundgraph;	// the one block all below are in
+
+static int*	soundzone;	// zone of each sector
+static int*	zonefirst;	// numzones+1 indexes into zonesectors
+static int*	zonesectors;	// sectors, grouped by zone
+static int*	linkfirst;	// numzones+1 indexes into zonelinks
+static int*	zonelinks;	// zones across sound blocking lines
+static int*	zonemark;	// validcount of the last noise
+static int*	dirtysectors;
+static byte*	sectordirty;
+static byte*	lineopen;	// as P_LineOpening would have it
+
+static int	numzones;
+static int	numdirty;
+static boolean	soundgraphvalid;
+
+
+//
+// P_SoundLineOpen
+// Two-sided and openrange > 0, like P_LineOpening.
+//
+static byte P_SoundLineOpen (int i)
+{
+    lineclip_t*	clip;
+    sector_t*	front;
+    sector_t*	back;
+    fixed_t	top;
+    fixed_t	bottom;
+
+    clip = &lineclips[i];
+    if (!(lines[i].flags & ML_TWOSIDED) || clip->backsector == -1)
+	return 0;
+
+    front = &sectors[clip->frontsector];
+    back = &sectors[clip->backsector];
+    top = front->ceilingheight < back->ceilingheight
+	? front->ceilingheight : back->ceilingheight;
+    bottom = front->floorheight > back->floorheight
+	? front->floorheight : back->floorheight;
+    return top - bottom > 0;
+}
+
+
+static int P_ZoneRoot (int sec)
+{
+    while (soundzone[sec] != sec)
+    {
+	soundzone[sec] = soundzone[soundzone[sec]];
+	sec = soundzone[sec];
+    }
+    return sec;
+}
+
+
+//
+// P_AllocSoundGraph
+// Goes with the level.
+//
+static void P_AllocSoundGraph (void)
+{
+    int		size;
+
+    size = (6*(numsectors+1) + 2*numlines)*sizeof(int)
+	+ numsectors + numlines;
+    Z_Malloc (size, PU_LEVEL, &soundgraph);
+
+    soundzone = (int *)soundgraph;
+    zonefirst = soundzone + numsectors;
+    zonesectors = zonefirst + numsectors+1;
+    linkfirst = zonesectors + numsectors;
+    zonelinks = linkfirst + numsectors+1;
+    zonemark = zonelinks + 2*numlines;
+    dirtysectors = zonemark + numsectors;
+    sectordirty = (byte *)(dirtysectors + numsectors+1);
+    lineopen = sectordirty + numsectors;
+
+    memset (zonemark, 0, numsectors*sizeof(int));
+    memset (sectordirty, 0, numsectors);
+    numdirty = 0;
+}
+
+
+//
+// P_BuildSoundGraph
+//
+static void P_BuildSoundGraph (void)
 {
+    lineclip_t*	clip;
+    int*	count;
     int		i;
-    line_t*	check;
-    sector_t*	other;
-	
-    // wake up all monsters in this sector
-    if (sec->validcount == validcount
-	&& sec->soundtraversed <= soundblocks+1)
+    int		a;
+    int		b;
+
+    for (i=0 ; i<numsectors ; i++)
+	soundzone[i] = i;
+
+    for (i=0 ; i<numlines ; i++)
     {
-	return;		// already flooded
+	lineopen[i] = P_SoundLineOpen (i);
+	if (!lineopen[i] || (lines[i].flags & ML_SOUNDBLOCK))
+	    continue;
+	a = P_ZoneRoot (lineclips[i].frontsector);
+	b = P_ZoneRoot (lineclips[i].backsector);
+	if (a != b)
+	    soundzone[a] = b;
     }
-    
-    sec->validcount = validcount;
-    sec->soundtraversed = soundblocks+1;
-    sec->soundtarget = soundtarget;
-	
-    for (i=0 ;i<sec->linecount ; i++)
+
+    // number the zones, root sectors first
+    numzones = 0;
+    for (i=0 ; i<numsectors ; i++)
+	if (soundzone[i] == i)
+	    zonemark[i] = numzones++;
+    for (i=0 ; i<numsectors ; i++)
+	soundzone[i] = P_ZoneRoot (i);
+    for (i=0 ; i<numsectors ; i++)
+	soundzone[i] = zonemark[soundzone[i]];
+    memset (zonemark, 0, numzones*sizeof(int));
+
+    // group the sectors by zone, counting in the next slot
+    count = zonefirst;
+    memset (count, 0, (numzones+1)*sizeof(int));
+    for (i=0 ; i<numsectors ; i++)
+	count[soundzone[i]+1]++;
+    for (i=0 ; i<numzones ; i++)
+	count[i+1] += count[i];
+    for (i=0 ; i<numsectors ; i++)
+	zonesectors[zonefirst[soundzone[i]]++] = i;
+    for (i=numzones ; i>0 ; i--)
+	zonefirst[i] = zonefirst[i-1];
+    zonefirst[0] = 0;
+
+    // and the links the same way
+    count = linkfirst;
+    memset (count, 0, (numzones+1)*sizeof(int));
+    for (i=0, clip=lineclips ; i<numlines ; i++, clip++)
     {
-	check = sec->lines[i];
-	if (! (check->flags & ML_TWOSIDED) )
+	if (!lineopen[i] || !(lines[i].flags & ML_SOUNDBLOCK))
 	    continue;
-	
-	P_LineOpening (check);
+	a = soundzone[clip->frontsector];
+	b = soundzone[clip->backsector];
+	if (a == b)
+	    continue;
+	count[a+1]++;
+	count[b+1]++;
+    }
+    for (i=0 ; i<numzones ; i++)
+	count[i+1] += count[i];
+    for (i=0, clip=lineclips ; i<numlines ; i++, clip++)
+    {
+	if (!lineopen[i] || !(lines[i].flags & ML_SOUNDBLOCK))
+	    continue;
+	a = soundzone[clip->frontsector];
+	b = soundzone[clip->backsector];
+	if (a == b)
+	    continue;
+	zonelinks[linkfirst[a]++] = b;
+	zonelinks[linkfirst[b]++] = a;
+    }
+    for (i=numzones ; i>0 ; i--)
+	linkfirst[i] = linkfirst[i-1];
+    linkfirst[0] = 0;
 
-	if (openrange <= 0)
-	    continue;	// closed door
-	
-	if ( sides[ check->sidenum[0] ].sector == sec)
-	    other = sides[ check->sidenum[1] ] .sector;
-	else
-	    other = sides[ check->sidenum[0] ].sector;
-	
-	if (check->flags & ML_SOUNDBLOCK)
+    for (i=0 ; i<numdirty ; i++)
+	sectordirty[dirtysectors[i]] = 0;
+    numdirty = 0;
+    soundgraphvalid = true;
+}
+
+
+//
+// P_CheckSoundGraph
+// Lines of sectors that moved since the last noise may
+//  have opened or closed.
+//
+static void P_CheckSoundGraph (void)
+{
+    sector_t*	sec;
+    int		i;
+    int		j;
+    int		line;
+
+    for (i=0 ; i<numdirty && soundgraphvalid ; i++)
+    {
+	sec = &sectors[dirtysectors[i]];
+	for (j=0 ; j<sec->linecount ; j++)
 	{
-	    if (!soundblocks)
-		P_RecursiveSound (other, 1);
+	    line = sec->lines[j] - lines;
+	    if (lineopen[line] != P_SoundLineOpen (line))
+	    {
+		soundgraphvalid = false;
+		break;
+	    }
 	}
-	else
-	    P_RecursiveSound (other, soundblocks);
+    }
+
+    if (!soundgraphvalid)
+    {
+	P_BuildSoundGraph ();
+	return;
+    }
+
+    for (i=0 ; i<numdirty ; i++)
+	sectordirty[dirtysectors[i]] = 0;
+    numdirty = 0;
+}
+
+
+//
+// P_SectorMoved
+// Called by T_MovePlane.
+//
+void P_SectorMoved (sector_t* sec)
+{
+    int		i;
+
+    if (!soundgraph || !soundgraphvalid)
+	return;
+
+    i = sec - sectors;
+    if (!sectordirty[i])
+    {
+	sectordirty[i] = 1;
+	dirtysectors[numdirty++] = i;
+    }
+}
+
+
+//
+// P_InvalidateSoundGraph
+// For anything that changes heights or line flags
+//  other than T_MovePlane.
+//
+void P_InvalidateSoundGraph (void)
+{
+    soundgraphvalid = false;
+}
+
+
+//
+// P_AlertZone
+//
+static void
+P_AlertZone
+( int		zone,
+  int		traversed )
+{
+    sector_t*		sec;
+    sectorinfo_t*	info;
+    int			i;
+
+    zonemark[zone] = validcount;
+    for (i=zonefirst[zone] ; i<zonefirst[zone+1] ; i++)
+    {
+	sec = &sectors[zonesectors[i]];
+	info = &sectorinfo[zonesectors[i]];
+	sec->validcount = validcount;
+	info->soundtraversed = traversed;
+	info->soundtarget = soundtarget;
     }
 }
 
@@ -160,9 +385,29 @@ P_NoiseAlert
 ( mobj_t*	target,
   mobj_t*	emmiter )
 {
+    int		zone;
+    int		i;
+
     soundtarget = target;
     validcount++;
-    P_RecursiveSound (emmiter->subsector->sector, 0);
+
+    if (!soundgraph)
+    {
+	P_AllocSoundGraph ();
+	P_BuildSoundGraph ();
+    }
+    else if (!soundgraphvalid)
+	P_BuildSoundGraph ();
+    else if (numdirty)
+	P_CheckSoundGraph ();
+
+    zone = soundzone[emmiter->subsector->sector - sectors];
+    P_AlertZone (zone, 1);
+
+    // beyond one sound blocking line
+    for (i=linkfirst[zone] ; i<linkfirst[zone+1] ; i++)
+	if (zonemark[zonelinks[i]] != validcount)
+	    P_AlertZone (zonelinks[i], 2);
 }
 
 
@@ -565,22 +810,16 @@ P_LookForPlayers
 //
 void A_KeenDie (mobj_t* mo)
 {
-    thinker_t*	th;
     mobj_t*	mo2;
     line_t	junk;
 
     A_Fall (mo);
     
-    // scan the remaining thinkers
-    // to see if all Keens are dead
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    // scan the remaining Keens
+    // to see if all are dead
+    for (mo2 = mobjtypehead[mo->type] ; mo2 ; mo2 = mo2->tnext)
     {
-	if (th->function.acp1 != (actionf_p1)P_MobjThinker)
-	    continue;
-
-	mo2 = (mobj_t *)th;
 	if (mo2 != mo
-	    && mo2->type == mo->type
 	    && mo2->health > 0)
 	{
 	    // other Keen not dead
@@ -606,7 +845,7 @@ void A_Look (mobj_t* actor)
     mobj_t*	targ;
 	
     actor->threshold = 0;	// any shot will wake up
-    targ = actor->subsector->sector->soundtarget;
+    targ = SECTORINFO(actor->subsector->sector)->soundtarget;
 
     if (targ
 	&& (targ->flags & MF_SHOOTABLE) )
@@ -1458,24 +1697,10 @@ A_PainShootSkull
     mobj_t*	newmobj;
     angle_t	an;
     int		prestep;
-    int		count;
-    thinker_t*	currentthinker;
-
-    // count total number of skull currently on the level
-    count = 0;
-
-    currentthinker = thinkercap.next;
-    while (currentthinker != &thinkercap)
-    {
-	if (   (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
-	    && ((mobj_t *)currentthinker)->type == MT_SKULL)
-	    count++;
-	currentthinker = currentthinker->next;
-    }
 
     // if there are allready 20 skulls on the level,
     // don't spit another one
-    if (count > 20)
+    if (mobjtypecount[MT_SKULL] > 20)
 	return;
 
 
@@ -1608,7 +1833,6 @@ void A_Explode (mobj_t* thingy)
 //
 void A_BossDeath (mobj_t* mo)
 {
-    thinker_t*	th;
     mobj_t*	mo2;
     line_t	junk;
     int		i;
@@ -1687,16 +1911,11 @@ void A_BossDeath (mobj_t* mo)
     if (i==MAXPLAYERS)
 	return;	// no one left alive, so do not end game
     
-    // scan the remaining thinkers to see
-    // if all bosses are dead
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    // scan the remaining bosses
+    // to see if all are dead
+    for (mo2 = mobjtypehead[mo->type] ; mo2 ; mo2 = mo2->tnext)
     {
-	if (th->function.acp1 != (actionf_p1)P_MobjThinker)
-	    continue;
-	
-	mo2 = (mobj_t *)th;
 	if (mo2 != mo
-	    && mo2->type == mo->type
 	    && mo2->health > 0)
 	{
 	    // other boss not dead
@@ -1812,28 +2031,16 @@ int		braintargeton;
 
 void A_BrainAwake (mobj_t* mo)
 {
-    thinker_t*	thinker;
     mobj_t*	m;
 	
     // find all the target spots
     numbraintargets = 0;
     braintargeton = 0;
 	
-    thinker = thinkercap.next;
-    for (thinker = thinkercap.next ;
-	 thinker != &thinkercap ;
-	 thinker = thinker->next)
+    for (m = mobjtypehead[MT_BOSSTARGET] ; m ; m = m->tnext)
     {
-	if (thinker->function.acp1 != (actionf_p1)P_MobjThinker)
-	    continue;	// not a mobj
-
-	m = (mobj_t *)thinker;
-
-	if (m->type == MT_BOSSTARGET )
-	{
-	    braintargets[numbraintargets] = m;
-	    numbraintargets++;
-	}
+	braintargets[numbraintargets] = m;
+	numbraintargets++;
     }
 	
     S_StartSound (NULL,sfx_bossit);
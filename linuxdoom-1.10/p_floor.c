@@ -56,6 +56,8 @@ T_MovePlane
 {
     boolean	flag;
     fixed_t	lastpos;
+
+    P_SectorMoved (sector);
 	
     switch(floorOrCeiling)
     {
@@ -216,7 +218,7 @@ void T_MoveFloor(floormove_t* floor)
 		      floor->crush,0,floor->direction);
     
     if (!(leveltime&7))
-	S_StartSound((mobj_t *)&floor->sector->soundorg,
+	S_StartSound((mobj_t *)&SECTORINFO(floor->sector)->soundorg,
 		     sfx_stnmov);
     
     if (res == pastdest)
@@ -247,7 +249,7 @@ void T_MoveFloor(floormove_t* floor)
 	}
 	P_RemoveThinker(&floor->thinker);
 
-	S_StartSound((mobj_t *)&floor->sector->soundorg,
+	S_StartSound((mobj_t *)&SECTORINFO(floor->sector)->soundorg,
 		     sfx_pstop);
     }
 
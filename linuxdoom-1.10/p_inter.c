@@ -47,6 +47,8 @@ rcsid[] = "$Id: p_inter.c,v 1.4 1997/02/03 22:45:11 b1 Exp $";
 #endif
 #include "p_inter.h"
 
+#include "g_stats.h"
+
 
 #define BONUSADD	6
 
@@ -885,6 +887,8 @@ P_DamageMobj
     
     // do the damage	
     target->health -= damage;	
+    if (statsactive)
+	G_StatsDamage (target, source, damage);
     if (target->health <= 0)
     {
 	P_KillMobj (source, target);
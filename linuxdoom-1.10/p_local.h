@@ -103,9 +103,24 @@ extern int		itemrespawntime[ITEMQUESIZE];
 extern int		iquehead;
 extern int		iquetail;
 
+// Dead player corpses, recycled in deathmatch.
+#define BODYQUESIZE		32
+
+extern mobj_t*		bodyque[BODYQUESIZE];
+extern int		bodyqueslot;
+
 
 void P_RespawnSpecials (void);
 
+// The live mobjs of each type, in thinker list order,
+//  linked through tnext. A mobj leaves its list when
+//  it is removed, not when its thinker is freed.
+extern mobj_t*		mobjtypehead[NUMMOBJTYPES];
+extern int		mobjtypecount[NUMMOBJTYPES];
+
+void	P_InitMobjIndex (void);
+void	P_IndexMobj (mobj_t* mobj);
+
 mobj_t*
 P_SpawnMobj
 ( fixed_t	x,
@@ -128,6 +143,10 @@ void	P_SpawnPlayerMissile (mobj_t* source, mobjtype_t type);
 //
 void P_NoiseAlert (mobj_t* target, mobj_t* emmiter);
 
+// Keep the sound propagation graph of P_NoiseAlert current.
+void P_SectorMoved (sector_t* sec);
+void P_InvalidateSoundGraph (void);
+
 
 //
 // P_MAPUTL
@@ -153,9 +172,6 @@ typedef struct
 
 #define MAXINTERCEPTS	128
 
-extern intercept_t	intercepts[MAXINTERCEPTS];
-extern intercept_t*	intercept_p;
-
 typedef boolean (*traverser_t) (intercept_t *in);
 
 fixed_t P_AproxDistance (fixed_t dx, fixed_t dy);
@@ -179,8 +195,6 @@ boolean P_BlockThingsIterator (int x, int y, boolean(*func)(mobj_t*) );
 #define PT_ADDTHINGS	2
 #define PT_EARLYOUT		4
 
-extern divline_t	trace;
-
 boolean
 P_PathTraverse
 ( fixed_t	x1,
@@ -190,6 +204,99 @@ P_PathTraverse
   int		flags,
   boolean	(*trav) (intercept_t *));
 
+
+//
+// The scratch state of one caller's map queries:
+//  line visit stamps, the intercepts of a path, and
+//  the sight and aim slopes. Queries on different
+//  mapquery_t can run on several threads at once,
+//  while the playsim doesn't run. The plain functions
+//  above work on mainquery, which stamps lines with
+//  the global validcount like they always did.
+//
+typedef struct mapquery_s
+{
+    // lines seen since P_QueryNewVisit, [numlines]
+    int*		linestamps;
+    int			numstamps;
+    int			validcount;
+
+    // P_QueryPathTraverse
+    intercept_t		intercepts[MAXINTERCEPTS];
+    intercept_t*	intercept_p;
+    divline_t		trace;
+    boolean		earlyout;
+
+    // P_QueryLineOpening
+    fixed_t		opentop;
+    fixed_t		openbottom;
+    fixed_t		openrange;
+    fixed_t		lowfloor;
+
+    // P_QuerySight and P_QueryAim
+    fixed_t		topslope;
+    fixed_t		bottomslope;
+    fixed_t		sightzstart;
+    divline_t		strace;
+    fixed_t		t2x;
+    fixed_t		t2y;
+    int			sightcounts[2];
+
+    mobj_t*		shootthing;
+    fixed_t		shootz;
+    fixed_t		attackrange;
+    fixed_t		aimslope;
+    mobj_t*		linetarget;	// who got aimed at (or NULL)
+
+    // callbacks of the plain functions
+    boolean		(*linefunc) (line_t*);
+    boolean		(*thingfunc) (mobj_t*);
+    traverser_t		traverser;
+
+    // for the caller's own callbacks
+    void*		user;
+
+} mapquery_t;
+
+typedef boolean (*querytraverser_t) (mapquery_t* q, intercept_t* in);
+
+extern mapquery_t	mainquery;
+
+void	P_InitQuery (mapquery_t* q);
+void	P_FreeQuery (mapquery_t* q);
+
+// Starts a new set of line visits, as validcount++ does.
+void	P_QueryNewVisit (mapquery_t* q);
+
+// Marks the line seen, returns true if it already was.
+boolean	P_QueryLineSeen (mapquery_t* q, line_t* ld);
+
+void	P_QueryLineOpening (mapquery_t* q, line_t* linedef);
+
+boolean
+P_QueryBlockLines
+( mapquery_t*	q,
+  int		x,
+  int		y,
+  boolean	(*func) (mapquery_t*, line_t*) );
+
+boolean
+P_QueryBlockThings
+( mapquery_t*	q,
+  int		x,
+  int		y,
+  boolean	(*func) (mapquery_t*, mobj_t*) );
+
+boolean
+P_QueryPathTraverse
+( mapquery_t*	q,
+  fixed_t	x1,
+  fixed_t	y1,
+  fixed_t	x2,
+  fixed_t	y2,
+  int		flags,
+  querytraverser_t trav );
+
 void P_UnsetThingPosition (mobj_t* thing);
 void P_SetThingPosition (mobj_t* thing);
 
@@ -212,6 +319,7 @@ boolean P_TryMove (mobj_t* thing, fixed_t x, fixed_t y);
 boolean P_TeleportMove (mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove (mobj_t* mo);
 boolean P_CheckSight (mobj_t* t1, mobj_t* t2);
+boolean P_QuerySight (mapquery_t* q, mobj_t* t1, mobj_t* t2);
 void 	P_UseLines (player_t* player);
 
 boolean P_ChangeSector (sector_t* sector, boolean crunch);
@@ -224,6 +332,14 @@ P_AimLineAttack
   angle_t	angle,
   fixed_t	distance );
 
+// Leaves q->linetarget set.
+fixed_t
+P_QueryAim
+( mapquery_t*	q,
+  mobj_t*	t1,
+  angle_t	angle,
+  fixed_t	distance );
+
 void
 P_LineAttack
 ( mobj_t*	t1,
@@ -188,10 +188,13 @@ P_TeleportMove
 //
 boolean PIT_CheckLine (line_t* ld)
 {
-    if (tmbbox[BOXRIGHT] <= ld->bbox[BOXLEFT]
-	|| tmbbox[BOXLEFT] >= ld->bbox[BOXRIGHT]
-	|| tmbbox[BOXTOP] <= ld->bbox[BOXBOTTOM]
-	|| tmbbox[BOXBOTTOM] >= ld->bbox[BOXTOP] )
+    lineclip_t*	clip;
+
+    clip = &lineclips[ld-lines];
+    if (tmbbox[BOXRIGHT] <= clip->bbox[BOXLEFT]
+	|| tmbbox[BOXLEFT] >= clip->bbox[BOXRIGHT]
+	|| tmbbox[BOXTOP] <= clip->bbox[BOXBOTTOM]
+	|| tmbbox[BOXBOTTOM] >= clip->bbox[BOXTOP] )
 	return true;
 
     if (P_BoxOnLineSide (tmbbox, ld) != -1)
@@ -208,15 +211,15 @@ boolean PIT_CheckLine (line_t* ld)
     // so two special lines that are only 8 pixels apart
     // could be crossed in either order.
     
-    if (!ld->backsector)
+    if (clip->backsector == -1)
 	return false;		// one sided line
 		
     if (!(tmthing->flags & MF_MISSILE) )
     {
-	if ( ld->flags & ML_BLOCKING )
+	if ( clip->flags & ML_BLOCKING )
 	    return false;	// explicitly blocking everything
 
-	if ( !tmthing->player && ld->flags & ML_BLOCKMONSTERS )
+	if ( !tmthing->player && clip->flags & ML_BLOCKMONSTERS )
 	    return false;	// block monsters only
     }
 
@@ -803,17 +806,15 @@ fixed_t		attackrange;
 
 fixed_t		aimslope;
 
-// slopes to top and bottom of target
-extern fixed_t	topslope;
-extern fixed_t	bottomslope;	
-
 
 //
 // PTR_AimTraverse
-// Sets linetaget and aimslope when a target is aimed at.
+// Sets q->linetarget and q->aimslope when a target is aimed at.
 //
 boolean
-PTR_AimTraverse (intercept_t* in)
+PTR_AimTraverse
+( mapquery_t*	q,
+  intercept_t*	in )
 {
     line_t*		li;
     mobj_t*		th;
@@ -832,28 +833,28 @@ PTR_AimTraverse (intercept_t* in)
 	// Crosses a two sided line.
 	// A two sided line will restrict
 	// the possible target ranges.
-	P_LineOpening (li);
+	P_QueryLineOpening (q, li);
 	
-	if (openbottom >= opentop)
+	if (q->openbottom >= q->opentop)
 	    return false;		// stop
 	
-	dist = FixedMul (attackrange, in->frac);
+	dist = FixedMul (q->attackrange, in->frac);
 
 	if (li->frontsector->floorheight != li->backsector->floorheight)
 	{
-	    slope = FixedDiv (openbottom - shootz , dist);
-	    if (slope > bottomslope)
-		bottomslope = slope;
+	    slope = FixedDiv (q->openbottom - q->shootz , dist);
+	    if (slope > q->bottomslope)
+		q->bottomslope = slope;
 	}
 		
 	if (li->frontsector->ceilingheight != li->backsector->ceilingheight)
 	{
-	    slope = FixedDiv (opentop - shootz , dist);
-	    if (slope < topslope)
-		topslope = slope;
+	    slope = FixedDiv (q->opentop - q->shootz , dist);
+	    if (slope < q->topslope)
+		q->topslope = slope;
 	}
 		
-	if (topslope <= bottomslope)
+	if (q->topslope <= q->bottomslope)
 	    return false;		// stop
 			
 	return true;			// shot continues
@@ -861,33 +862,33 @@ PTR_AimTraverse (intercept_t* in)
     
     // shoot a thing
     th = in->d.thing;
-    if (th == shootthing)
+    if (th == q->shootthing)
 	return true;			// can't shoot self
     
     if (!(th->flags&MF_SHOOTABLE))
 	return true;			// corpse or something
 
     // check angles to see if the thing can be aimed at
-    dist = FixedMul (attackrange, in->frac);
-    thingtopslope = FixedDiv (th->z+th->height - shootz , dist);
+    dist = FixedMul (q->attackrange, in->frac);
+    thingtopslope = FixedDiv (th->z+th->height - q->shootz , dist);
 
-    if (thingtopslope < bottomslope)
+    if (thingtopslope < q->bottomslope)
 	return true;			// shot over the thing
 
-    thingbottomslope = FixedDiv (th->z - shootz, dist);
+    thingbottomslope = FixedDiv (th->z - q->shootz, dist);
 
-    if (thingbottomslope > topslope)
+    if (thingbottomslope > q->topslope)
 	return true;			// shot under the thing
     
     // this thing can be hit!
-    if (thingtopslope > topslope)
-	thingtopslope = topslope;
+    if (thingtopslope > q->topslope)
+	thingtopslope = q->topslope;
     
-    if (thingbottomslope < bottomslope)
-	thingbottomslope = bottomslope;
+    if (thingbottomslope < q->bottomslope)
+	thingbottomslope = q->bottomslope;
 
-    aimslope = (thingtopslope+thingbottomslope)/2;
-    linetarget = th;
+    q->aimslope = (thingtopslope+thingbottomslope)/2;
+    q->linetarget = th;
 
     return false;			// don't go any farther
 }
@@ -949,8 +950,8 @@ boolean PTR_ShootTraverse (intercept_t* in)
       hitline:
 	// position a bit closer
 	frac = in->frac - FixedDiv (4*FRACUNIT,attackrange);
-	x = trace.x + FixedMul (trace.dx, frac);
-	y = trace.y + FixedMul (trace.dy, frac);
+	x = mainquery.trace.x + FixedMul (mainquery.trace.dx, frac);
+	y = mainquery.trace.y + FixedMul (mainquery.trace.dy, frac);
 	z = shootz + FixedMul (aimslope, FixedMul(frac, attackrange));
 
 	if (li->frontsector->ceilingpic == skyflatnum)
@@ -996,8 +997,8 @@ boolean PTR_ShootTraverse (intercept_t* in)
     // position a bit closer
     frac = in->frac - FixedDiv (10*FRACUNIT,attackrange);
 
-    x = trace.x + FixedMul (trace.dx, frac);
-    y = trace.y + FixedMul (trace.dy, frac);
+    x = mainquery.trace.x + FixedMul (mainquery.trace.dx, frac);
+    y = mainquery.trace.y + FixedMul (mainquery.trace.dy, frac);
     z = shootz + FixedMul (aimslope, FixedMul(frac, attackrange));
 
     // Spawn bullet puffs or blod spots,
@@ -1017,11 +1018,12 @@ boolean PTR_ShootTraverse (intercept_t* in)
 
 
 //
-// P_AimLineAttack
+// P_QueryAim
 //
 fixed_t
-P_AimLineAttack
-( mobj_t*	t1,
+P_QueryAim
+( mapquery_t*	q,
+  mobj_t*	t1,
   angle_t	angle,
   fixed_t	distance )
 {
@@ -1029,29 +1031,46 @@ P_AimLineAttack
     fixed_t	y2;
 	
     angle >>= ANGLETOFINESHIFT;
-    shootthing = t1;
+    q->shootthing = t1;
     
     x2 = t1->x + (distance>>FRACBITS)*finecosine[angle];
     y2 = t1->y + (distance>>FRACBITS)*finesine[angle];
-    shootz = t1->z + (t1->height>>1) + 8*FRACUNIT;
+    q->shootz = t1->z + (t1->height>>1) + 8*FRACUNIT;
 
     // can't shoot outside view angles
-    topslope = 100*FRACUNIT/160;	
-    bottomslope = -100*FRACUNIT/160;
+    q->topslope = 100*FRACUNIT/160;	
+    q->bottomslope = -100*FRACUNIT/160;
     
-    attackrange = distance;
-    linetarget = NULL;
+    q->attackrange = distance;
+    q->linetarget = NULL;
 	
-    P_PathTraverse ( t1->x, t1->y,
-		     x2, y2,
-		     PT_ADDLINES|PT_ADDTHINGS,
-		     PTR_AimTraverse );
+    P_QueryPathTraverse ( q, t1->x, t1->y,
+			  x2, y2,
+			  PT_ADDLINES|PT_ADDTHINGS,
+			  PTR_AimTraverse );
 		
-    if (linetarget)
-	return aimslope;
+    if (q->linetarget)
+	return q->aimslope;
 
     return 0;
 }
+
+
+//
+// P_AimLineAttack
+//
+fixed_t
+P_AimLineAttack
+( mobj_t*	t1,
+  angle_t	angle,
+  fixed_t	distance )
+{
+    fixed_t	slope;
+
+    slope = P_QueryAim (&mainquery, t1, angle, distance);
+    linetarget = mainquery.linetarget;
+    return slope;
+}
  
 
 //
@@ -1324,13 +1343,15 @@ P_ChangeSector
 {
     int		x;
     int		y;
+    int*	blockbox;
 	
     nofit = false;
     crushchange = crunch;
 	
     // re-check heights for all things near the moving sector
-    for (x=sector->blockbox[BOXLEFT] ; x<= sector->blockbox[BOXRIGHT] ; x++)
-	for (y=sector->blockbox[BOXBOTTOM];y<= sector->blockbox[BOXTOP] ; y++)
+    blockbox = SECTORINFO(sector)->blockbox;
+    for (x=blockbox[BOXLEFT] ; x<= blockbox[BOXRIGHT] ; x++)
+	for (y=blockbox[BOXBOTTOM];y<= blockbox[BOXTOP] ; y++)
 	    P_BlockThingsIterator (x, y, PIT_ChangeSector);
 	
 	
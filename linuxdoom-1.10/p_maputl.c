@@ -29,9 +29,11 @@ rcsid[] = "$Id: p_maputl.c,v 1.5 1997/02/03 22:45:11 b1 Exp $";
 
 
 #include <stdlib.h>
+#include <string.h>
 
 
 #include "m_bbox.h"
+#include "i_system.h"
 
 #include "doomdef.h"
 #include "p_local.h"
@@ -72,27 +74,29 @@ P_PointOnLineSide
     fixed_t	dy;
     fixed_t	left;
     fixed_t	right;
+    lineclip_t*	clip;
 	
-    if (!line->dx)
+    clip = &lineclips[line-lines];
+    if (!clip->dx)
     {
-	if (x <= line->v1->x)
-	    return line->dy > 0;
+	if (x <= clip->x)
+	    return clip->dy > 0;
 	
-	return line->dy < 0;
+	return clip->dy < 0;
     }
-    if (!line->dy)
+    if (!clip->dy)
     {
-	if (y <= line->v1->y)
-	    return line->dx < 0;
+	if (y <= clip->y)
+	    return clip->dx < 0;
 	
-	return line->dx > 0;
+	return clip->dx > 0;
     }
 	
-    dx = (x - line->v1->x);
-    dy = (y - line->v1->y);
+    dx = (x - clip->x);
+    dy = (y - clip->y);
 	
-    left = FixedMul ( line->dy>>FRACBITS , dx );
-    right = FixedMul ( dy , line->dx>>FRACBITS );
+    left = FixedMul ( clip->dy>>FRACBITS , dx );
+    right = FixedMul ( dy , clip->dx>>FRACBITS );
 	
     if (right < left)
 	return 0;		// front side
@@ -113,13 +117,15 @@ P_BoxOnLineSide
 {
     int		p1;
     int		p2;
+    lineclip_t*	clip;
 	
-    switch (ld->slopetype)
+    clip = &lineclips[ld-lines];
+    switch (clip->slopetype)
     {
       case ST_HORIZONTAL:
-	p1 = tmbox[BOXTOP] > ld->v1->y;
-	p2 = tmbox[BOXBOTTOM] > ld->v1->y;
-	if (ld->dx < 0)
+	p1 = tmbox[BOXTOP] > clip->y;
+	p2 = tmbox[BOXBOTTOM] > clip->y;
+	if (clip->dx < 0)
 	{
 	    p1 ^= 1;
 	    p2 ^= 1;
@@ -127,9 +133,9 @@ P_BoxOnLineSide
 	break;
 	
       case ST_VERTICAL:
-	p1 = tmbox[BOXRIGHT] < ld->v1->x;
-	p2 = tmbox[BOXLEFT] < ld->v1->x;
-	if (ld->dy < 0)
+	p1 = tmbox[BOXRIGHT] < clip->x;
+	p2 = tmbox[BOXLEFT] < clip->x;
+	if (clip->dy < 0)
 	{
 	    p1 ^= 1;
 	    p2 ^= 1;
@@ -297,38 +303,50 @@ fixed_t openrange;
 fixed_t	lowfloor;
 
 
-void P_LineOpening (line_t* linedef)
+void P_QueryLineOpening (mapquery_t* q, line_t* linedef)
 {
     sector_t*	front;
     sector_t*	back;
+    lineclip_t*	clip;
 	
-    if (linedef->sidenum[1] == -1)
+    clip = &lineclips[linedef-lines];
+    if (clip->backsector == -1)
     {
 	// single sided line
-	openrange = 0;
+	q->openrange = 0;
 	return;
     }
 	 
-    front = linedef->frontsector;
-    back = linedef->backsector;
+    front = &sectors[clip->frontsector];
+    back = &sectors[clip->backsector];
 	
     if (front->ceilingheight < back->ceilingheight)
-	opentop = front->ceilingheight;
+	q->opentop = front->ceilingheight;
     else
-	opentop = back->ceilingheight;
+	q->opentop = back->ceilingheight;
 
     if (front->floorheight > back->floorheight)
     {
-	openbottom = front->floorheight;
-	lowfloor = back->floorheight;
+	q->openbottom = front->floorheight;
+	q->lowfloor = back->floorheight;
     }
     else
     {
-	openbottom = back->floorheight;
-	lowfloor = front->floorheight;
+	q->openbottom = back->floorheight;
+	q->lowfloor = front->floorheight;
     }
 	
-    openrange = opentop - openbottom;
+    q->openrange = q->opentop - q->openbottom;
+}
+
+
+void P_LineOpening (line_t* linedef)
+{
+    P_QueryLineOpening (&mainquery, linedef);
+    opentop = mainquery.opentop;
+    openbottom = mainquery.openbottom;
+    openrange = mainquery.openrange;
+    lowfloor = mainquery.lowfloor;
 }
 
 
@@ -451,6 +469,81 @@ P_SetThingPosition (mobj_t* thing)
 
 
 
+//
+// MAP QUERIES
+//
+mapquery_t	mainquery;
+
+
+//
+// P_InitQuery
+//
+void P_InitQuery (mapquery_t* q)
+{
+    memset (q, 0, sizeof(*q));
+}
+
+
+//
+// P_FreeQuery
+//
+void P_FreeQuery (mapquery_t* q)
+{
+    free (q->linestamps);
+    memset (q, 0, sizeof(*q));
+}
+
+
+//
+// P_QueryNewVisit
+// Stamps only grow, so older stamps, even ones
+//  left over from another level, never match again.
+//
+void P_QueryNewVisit (mapquery_t* q)
+{
+    if (q == &mainquery)
+    {
+	validcount++;
+	return;
+    }
+
+    if (q->numstamps < numlines)
+    {
+	q->linestamps = realloc (q->linestamps, numlines*sizeof(int));
+	if (!q->linestamps)
+	    I_Error ("P_QueryNewVisit: no memory for %i lines", numlines);
+	memset (q->linestamps+q->numstamps, 0,
+		(numlines-q->numstamps)*sizeof(int));
+	q->numstamps = numlines;
+    }
+    q->validcount++;
+}
+
+
+//
+// P_QueryLineSeen
+//
+boolean P_QueryLineSeen (mapquery_t* q, line_t* ld)
+{
+    int*	stamp;
+
+    if (q == &mainquery)
+    {
+	if (ld->validcount == validcount)
+	    return true;
+	ld->validcount = validcount;
+	return false;
+    }
+
+    stamp = &q->linestamps[ld-lines];
+    if (*stamp == q->validcount)
+	return true;
+    *stamp = q->validcount;
+    return false;
+}
+
+
+
 //
 // BLOCK MAP ITERATORS
 // For each line/thing in the given mapblock,
@@ -461,18 +554,19 @@ P_SetThingPosition (mobj_t* thing)
 
 
 //
-// P_BlockLinesIterator
-// The validcount flags are used to avoid checking lines
+// P_QueryBlockLines
+// The line stamps are used to avoid checking lines
 // that are marked in multiple mapblocks,
-// so increment validcount before the first call
-// to P_BlockLinesIterator, then make one or more calls
+// so call P_QueryNewVisit before the first call
+// to P_QueryBlockLines, then make one or more calls
 // to it.
 //
 boolean
-P_BlockLinesIterator
-( int			x,
-  int			y,
-  boolean(*func)(line_t*) )
+P_QueryBlockLines
+( mapquery_t*	q,
+  int		x,
+  int		y,
+  boolean	(*func) (mapquery_t*, line_t*) )
 {
     int			offset;
     short*		list;
@@ -494,12 +588,10 @@ P_BlockLinesIterator
     {
 	ld = &lines[*list];
 
-	if (ld->validcount == validcount)
+	if (P_QueryLineSeen (q, ld))
 	    continue; 	// line has already been checked
-
-	ld->validcount = validcount;
 		
-	if ( !func(ld) )
+	if ( !func(q, ld) )
 	    return false;
     }
     return true;	// everything was checked
@@ -507,13 +599,14 @@ P_BlockLinesIterator
 
 
 //
-// P_BlockThingsIterator
+// P_QueryBlockThings
 //
 boolean
-P_BlockThingsIterator
-( int			x,
-  int			y,
-  boolean(*func)(mobj_t*) )
+P_QueryBlockThings
+( mapquery_t*	q,
+  int		x,
+  int		y,
+  boolean	(*func) (mapquery_t*, mobj_t*) )
 {
     mobj_t*		mobj;
 	
@@ -530,23 +623,73 @@ P_BlockThingsIterator
 	 mobj ;
 	 mobj = mobj->bnext)
     {
-	if (!func( mobj ) )
+	if (!func(q, mobj) )
 	    return false;
     }
     return true;
 }
 
 
+//
+// P_BlockLinesIterator
+// The plain iterators run on mainquery, so increment
+// validcount before the first call to
+// P_BlockLinesIterator, then make one or more calls
+// to it. The callbacks are saved around the call,
+// since they may iterate again.
+//
+static boolean PIT_PlainLine (mapquery_t* q, line_t* ld)
+{
+    return q->linefunc (ld);
+}
+
+static boolean PIT_PlainThing (mapquery_t* q, mobj_t* mobj)
+{
+    return q->thingfunc (mobj);
+}
+
+
+boolean
+P_BlockLinesIterator
+( int			x,
+  int			y,
+  boolean(*func)(line_t*) )
+{
+    boolean		(*oldfunc) (line_t*);
+    boolean		result;
+
+    oldfunc = mainquery.linefunc;
+    mainquery.linefunc = func;
+    result = P_QueryBlockLines (&mainquery, x, y, PIT_PlainLine);
+    mainquery.linefunc = oldfunc;
+    return result;
+}
+
 
 //
-// INTERCEPT ROUTINES
+// P_BlockThingsIterator
 //
-intercept_t	intercepts[MAXINTERCEPTS];
-intercept_t*	intercept_p;
+boolean
+P_BlockThingsIterator
+( int			x,
+  int			y,
+  boolean(*func)(mobj_t*) )
+{
+    boolean		(*oldfunc) (mobj_t*);
+    boolean		result;
+
+    oldfunc = mainquery.thingfunc;
+    mainquery.thingfunc = func;
+    result = P_QueryBlockThings (&mainquery, x, y, PIT_PlainThing);
+    mainquery.thingfunc = oldfunc;
+    return result;
+}
+
 
-divline_t 	trace;
-boolean 	earlyout;
-int		ptflags;
+
+//
+// INTERCEPT ROUTINES
+//
 
 //
 // PIT_AddLineIntercepts.
@@ -559,26 +702,31 @@ int		ptflags;
 // Returns true if earlyout and a solid line hit.
 //
 boolean
-PIT_AddLineIntercepts (line_t* ld)
+PIT_AddLineIntercepts
+( mapquery_t*	q,
+  line_t*	ld )
 {
     int			s1;
     int			s2;
     fixed_t		frac;
     divline_t		dl;
+    divline_t*		trace;
+
+    trace = &q->trace;
 	
     // avoid precision problems with two routines
-    if ( trace.dx > FRACUNIT*16
-	 || trace.dy > FRACUNIT*16
-	 || trace.dx < -FRACUNIT*16
-	 || trace.dy < -FRACUNIT*16)
+    if ( trace->dx > FRACUNIT*16
+	 || trace->dy > FRACUNIT*16
+	 || trace->dx < -FRACUNIT*16
+	 || trace->dy < -FRACUNIT*16)
     {
-	s1 = P_PointOnDivlineSide (ld->v1->x, ld->v1->y, &trace);
-	s2 = P_PointOnDivlineSide (ld->v2->x, ld->v2->y, &trace);
+	s1 = P_PointOnDivlineSide (ld->v1->x, ld->v1->y, trace);
+	s2 = P_PointOnDivlineSide (ld->v2->x, ld->v2->y, trace);
     }
     else
     {
-	s1 = P_PointOnLineSide (trace.x, trace.y, ld);
-	s2 = P_PointOnLineSide (trace.x+trace.dx, trace.y+trace.dy, ld);
+	s1 = P_PointOnLineSide (trace->x, trace->y, ld);
+	s2 = P_PointOnLineSide (trace->x+trace->dx, trace->y+trace->dy, ld);
     }
     
     if (s1 == s2)
@@ -586,13 +734,13 @@ PIT_AddLineIntercepts (line_t* ld)
     
     // hit the line
     P_MakeDivline (ld, &dl);
-    frac = P_InterceptVector (&trace, &dl);
+    frac = P_InterceptVector (trace, &dl);
 
     if (frac < 0)
 	return true;	// behind source
 	
     // try to early out the check
-    if (earlyout
+    if (q->earlyout
 	&& frac < FRACUNIT
 	&& !ld->backsector)
     {
@@ -600,10 +748,10 @@ PIT_AddLineIntercepts (line_t* ld)
     }
     
 	
-    intercept_p->frac = frac;
-    intercept_p->isaline = true;
-    intercept_p->d.line = ld;
-    intercept_p++;
+    q->intercept_p->frac = frac;
+    q->intercept_p->isaline = true;
+    q->intercept_p->d.line = ld;
+    q->intercept_p++;
 
     return true;	// continue
 }
@@ -613,7 +761,10 @@ PIT_AddLineIntercepts (line_t* ld)
 //
 // PIT_AddThingIntercepts
 //
-boolean PIT_AddThingIntercepts (mobj_t* thing)
+boolean
+PIT_AddThingIntercepts
+( mapquery_t*	q,
+  mobj_t*	thing )
 {
     fixed_t		x1;
     fixed_t		y1;
@@ -626,10 +777,12 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
     boolean		tracepositive;
 
     divline_t		dl;
+    divline_t*		trace;
     
     fixed_t		frac;
-	
-    tracepositive = (trace.dx ^ trace.dy)>0;
+
+    trace = &q->trace;
+    tracepositive = (trace->dx ^ trace->dy)>0;
 		
     // check a corner to corner crossection for hit
     if (tracepositive)
@@ -649,8 +802,8 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
 	y2 = thing->y + thing->radius;			
     }
     
-    s1 = P_PointOnDivlineSide (x1, y1, &trace);
-    s2 = P_PointOnDivlineSide (x2, y2, &trace);
+    s1 = P_PointOnDivlineSide (x1, y1, trace);
+    s2 = P_PointOnDivlineSide (x2, y2, trace);
 
     if (s1 == s2)
 	return true;		// line isn't crossed
@@ -660,15 +813,15 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
     dl.dx = x2-x1;
     dl.dy = y2-y1;
     
-    frac = P_InterceptVector (&trace, &dl);
+    frac = P_InterceptVector (trace, &dl);
 
     if (frac < 0)
 	return true;		// behind source
 
-    intercept_p->frac = frac;
-    intercept_p->isaline = false;
-    intercept_p->d.thing = thing;
-    intercept_p++;
+    q->intercept_p->frac = frac;
+    q->intercept_p->isaline = false;
+    q->intercept_p->d.thing = thing;
+    q->intercept_p++;
 
     return true;		// keep going
 }
@@ -681,7 +834,8 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
 // 
 boolean
 P_TraverseIntercepts
-( traverser_t	func,
+( mapquery_t*	q,
+  querytraverser_t func,
   fixed_t	maxfrac )
 {
     int			count;
@@ -689,14 +843,14 @@ P_TraverseIntercepts
     intercept_t*	scan;
     intercept_t*	in;
 	
-    count = intercept_p - intercepts;
+    count = q->intercept_p - q->intercepts;
     
     in = 0;			// shut up compiler warning
 	
     while (count--)
     {
 	dist = MAXINT;
-	for (scan = intercepts ; scan<intercept_p ; scan++)
+	for (scan = q->intercepts ; scan<q->intercept_p ; scan++)
 	{
 	    if (scan->frac < dist)
 	    {
@@ -720,7 +874,7 @@ P_TraverseIntercepts
     }
 #endif
 
-        if ( !func (in) )
+        if ( !func (q, in) )
 	    return false;	// don't bother going farther
 
 	in->frac = MAXINT;
@@ -733,20 +887,21 @@ P_TraverseIntercepts
 
 
 //
-// P_PathTraverse
+// P_QueryPathTraverse
 // Traces a line from x1,y1 to x2,y2,
 // calling the traverser function for each.
 // Returns true if the traverser function returns true
 // for all lines.
 //
 boolean
-P_PathTraverse
-( fixed_t		x1,
+P_QueryPathTraverse
+( mapquery_t*		q,
+  fixed_t		x1,
   fixed_t		y1,
   fixed_t		x2,
   fixed_t		y2,
   int			flags,
-  boolean (*trav) (intercept_t *))
+  querytraverser_t	trav )
 {
     fixed_t	xt1;
     fixed_t	yt1;
@@ -769,10 +924,10 @@ P_PathTraverse
 
     int		count;
 		
-    earlyout = flags & PT_EARLYOUT;
+    q->earlyout = flags & PT_EARLYOUT;
 		
-    validcount++;
-    intercept_p = intercepts;
+    P_QueryNewVisit (q);
+    q->intercept_p = q->intercepts;
 	
     if ( ((x1-bmaporgx)&(MAPBLOCKSIZE-1)) == 0)
 	x1 += FRACUNIT;	// don't side exactly on a line
@@ -780,10 +935,10 @@ P_PathTraverse
     if ( ((y1-bmaporgy)&(MAPBLOCKSIZE-1)) == 0)
 	y1 += FRACUNIT;	// don't side exactly on a line
 
-    trace.x = x1;
-    trace.y = y1;
-    trace.dx = x2 - x1;
-    trace.dy = y2 - y1;
+    q->trace.x = x1;
+    q->trace.y = y1;
+    q->trace.dx = x2 - x1;
+    q->trace.dy = y2 - y1;
 
     x1 -= bmaporgx;
     y1 -= bmaporgy;
@@ -847,13 +1002,13 @@ P_PathTraverse
     {
 	if (flags & PT_ADDLINES)
 	{
-	    if (!P_BlockLinesIterator (mapx, mapy,PIT_AddLineIntercepts))
+	    if (!P_QueryBlockLines (q, mapx, mapy, PIT_AddLineIntercepts))
 		return false;	// early out
 	}
 	
 	if (flags & PT_ADDTHINGS)
 	{
-	    if (!P_BlockThingsIterator (mapx, mapy,PIT_AddThingIntercepts))
+	    if (!P_QueryBlockThings (q, mapx, mapy, PIT_AddThingIntercepts))
 		return false;	// early out
 	}
 		
@@ -876,8 +1031,35 @@ P_PathTraverse
 		
     }
     // go through the sorted list
-    return P_TraverseIntercepts ( trav, FRACUNIT );
+    return P_TraverseIntercepts (q, trav, FRACUNIT);
 }
 
 
+//
+// P_PathTraverse
+//
+static boolean PTR_Plain (mapquery_t* q, intercept_t* in)
+{
+    return q->traverser (in);
+}
 
+
+boolean
+P_PathTraverse
+( fixed_t		x1,
+  fixed_t		y1,
+  fixed_t		x2,
+  fixed_t		y2,
+  int			flags,
+  boolean (*trav) (intercept_t *))
+{
+    traverser_t		oldtrav;
+    boolean		result;
+
+    oldtrav = mainquery.traverser;
+    mainquery.traverser = trav;
+    result = P_QueryPathTraverse (&mainquery, x1, y1, x2, y2,
+				  flags, PTR_Plain);
+    mainquery.traverser = oldtrav;
+    return result;
+}
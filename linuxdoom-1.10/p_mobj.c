@@ -473,6 +473,65 @@ void P_MobjThinker (mobj_t* mobj)
 }
 
 
+//
+// P_InitMobjIndex
+// Empties the type lists, along with the thinker list.
+//
+mobj_t*		mobjtypehead[NUMMOBJTYPES];
+mobj_t*		mobjtypetail[NUMMOBJTYPES];
+int		mobjtypecount[NUMMOBJTYPES];
+
+void P_InitMobjIndex (void)
+{
+    memset (mobjtypehead, 0, sizeof(mobjtypehead));
+    memset (mobjtypetail, 0, sizeof(mobjtypetail));
+    memset (mobjtypecount, 0, sizeof(mobjtypecount));
+}
+
+
+//
+// P_IndexMobj
+// Appends a mobj to the list of its type.
+// Mobjs are indexed in the order they join the
+//  thinker list, so the lists keep that order.
+//
+void P_IndexMobj (mobj_t* mobj)
+{
+    mobj->tnext = NULL;
+    mobj->tprev = mobjtypetail[mobj->type];
+    if (mobj->tprev)
+	mobj->tprev->tnext = mobj;
+    else
+	mobjtypehead[mobj->type] = mobj;
+    mobjtypetail[mobj->type] = mobj;
+    mobjtypecount[mobj->type]++;
+}
+
+
+//
+// P_UnIndexMobj
+//
+static void P_UnIndexMobj (mobj_t* mobj)
+{
+    // not in a list
+    if (!mobj->tprev && mobjtypehead[mobj->type] != mobj)
+	return;
+
+    if (mobj->tnext)
+	mobj->tnext->tprev = mobj->tprev;
+    else
+	mobjtypetail[mobj->type] = mobj->tprev;
+
+    if (mobj->tprev)
+	mobj->tprev->tnext = mobj->tnext;
+    else
+	mobjtypehead[mobj->type] = mobj->tnext;
+
+    mobj->tnext = mobj->tprev = NULL;
+    mobjtypecount[mobj->type]--;
+}
+
+
 //
 // P_SpawnMobj
 //
@@ -529,6 +588,7 @@ P_SpawnMobj
     mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
 	
     P_AddThinker (&mobj->thinker);
+    P_IndexMobj (mobj);
 
     return mobj;
 }
@@ -559,8 +619,9 @@ void P_RemoveMobj (mobj_t* mobj)
 	    iquetail = (iquetail+1)&(ITEMQUESIZE-1);
     }
 	
-    // unlink from sector and block lists
+    // unlink from sector, block and type lists
     P_UnsetThingPosition (mobj);
+    P_UnIndexMobj (mobj);
     
     // stop any playing sound
     S_StopSound (mobj);
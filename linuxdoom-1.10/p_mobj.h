@@ -282,6 +282,11 @@ typedef struct mobj_s
 
     // Thing being chased/attacked for tracers.
     struct mobj_s*	tracer;	
+
+    // Links among the live mobjs of the same type,
+    //  in spawn order (see mobjtypehead).
+    struct mobj_s*	tnext;
+    struct mobj_s*	tprev;
     
 } mobj_t;
 
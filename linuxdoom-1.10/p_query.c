@@ -0,0 +1,219 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Map queries on several threads, checked.
+//	Sight and aim queries between the things of the start
+//	map are answered once by P_CheckSight and P_AimLineAttack,
+//	then by threads that each own a mapquery_t and run all
+//	of them, starting at different places. Every answer
+//	must match the serial one.
+//	  -querytest n [-querythreads t]
+//				n queries on t threads, default one
+//				per processor
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/sysinfo.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "m_argv.h"
+#include "g_game.h"
+
+#include "p_local.h"
+#include "p_query.h"
+
+
+#define MAXQUERYTHREADS	16
+
+
+typedef struct
+{
+    mobj_t*	t1;
+    mobj_t*	t2;
+    angle_t	angle;
+
+    // the plain functions' answers
+    boolean	sight;
+    fixed_t	slope;
+    mobj_t*	linetarget;
+
+} querycase_t;
+
+
+static querycase_t*	querycases;
+static int		numquerycases;
+static int		numquerythreads;
+
+static int		queryerrors[MAXQUERYTHREADS];
+
+
+//
+// P_QueryCase
+// Returns the number of answers that differ.
+//
+static int
+P_QueryCase
+( mapquery_t*	q,
+  querycase_t*	c )
+{
+    int		errors;
+    fixed_t	slope;
+
+    errors = 0;
+    if (P_QuerySight (q, c->t1, c->t2) != c->sight)
+	errors++;
+
+    slope = P_QueryAim (q, c->t1, c->angle, MISSILERANGE);
+    if (slope != c->slope || q->linetarget != c->linetarget)
+	errors++;
+
+    return errors;
+}
+
+
+//
+// P_QueryThread
+//
+static void* P_QueryThread (void* arg)
+{
+    mapquery_t	q;
+    int		n;
+    int		i;
+    int		j;
+
+    n = (int)(long)arg;
+    P_InitQuery (&q);
+
+    for (j=0 ; j<numquerycases ; j++)
+    {
+	i = (j + n*numquerycases/numquerythreads) % numquerycases;
+	queryerrors[n] += P_QueryCase (&q, &querycases[i]);
+    }
+
+    P_FreeQuery (&q);
+    return NULL;
+}
+
+
+//
+// P_QueryTest
+//
+void P_QueryTest (int arg)
+{
+    pthread_t		threads[MAXQUERYTHREADS];
+    mobj_t**		things;
+    thinker_t*		th;
+    querycase_t*	c;
+    int			numthings;
+    int			start;
+    int			serial;
+    int			parallel;
+    int			errors;
+    int			i;
+    int			p;
+
+    numquerycases = atoi (myargv[arg+1]);
+    if (numquerycases < 1)
+	numquerycases = 1;
+
+    numquerythreads = get_nprocs ();
+    p = M_CheckParm ("-querythreads");
+    if (p && p < myargc-1)
+	numquerythreads = atoi (myargv[p+1]);
+    if (numquerythreads < 1)
+	numquerythreads = 1;
+    if (numquerythreads > MAXQUERYTHREADS)
+	numquerythreads = MAXQUERYTHREADS;
+
+    G_InitNew (startskill, startepisode, startmap);
+
+    numthings = 0;
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	    numthings++;
+
+    things = malloc (numthings*sizeof(*things) + 1);
+    querycases = malloc (numquerycases*sizeof(*querycases));
+    if (!things || !querycases)
+	I_Error ("P_QueryTest: no memory for %i queries", numquerycases);
+    if (numthings < 2)
+	I_Error ("P_QueryTest: %i things on the map", numthings);
+
+    numthings = 0;
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	    things[numthings++] = (mobj_t *)th;
+
+    // the same cases every run
+    srand (1);
+    for (i=0 ; i<numquerycases ; i++)
+    {
+	c = &querycases[i];
+	c->t1 = things[rand () % numthings];
+	c->t2 = things[rand () % numthings];
+	c->angle = R_PointToAngle2 (c->t1->x, c->t1->y,
+				    c->t2->x, c->t2->y);
+    }
+
+    start = I_GetTimeUS ();
+    for (i=0 ; i<numquerycases ; i++)
+    {
+	c = &querycases[i];
+	c->sight = P_CheckSight (c->t1, c->t2);
+	c->slope = P_AimLineAttack (c->t1, c->angle, MISSILERANGE);
+	c->linetarget = linetarget;
+    }
+    serial = I_GetTimeUS () - start;
+
+    start = I_GetTimeUS ();
+    for (i=0 ; i<numquerythreads ; i++)
+	if (pthread_create (&threads[i], NULL,
+			    P_QueryThread, (void *)(long)i))
+	    I_Error ("P_QueryTest: can't start a thread");
+    for (i=0 ; i<numquerythreads ; i++)
+	pthread_join (threads[i], NULL);
+    parallel = I_GetTimeUS () - start;
+
+    errors = 0;
+    for (i=0 ; i<numquerythreads ; i++)
+	errors += queryerrors[i];
+
+    if (!serial)
+	serial = 1;
+    if (!parallel)
+	parallel = 1;
+    printf ("P_QueryTest: %i queries between %i things, %i threads\n"
+	    "  plain %.1f queries/ms, threads %.1f queries/ms, %.2fx\n"
+	    "  %i answers differ\n",
+	    numquerycases, numthings, numquerythreads,
+	    1000.0*numquerycases/serial,
+	    1000.0*numquerycases*numquerythreads/parallel,
+	    (double)numquerythreads*serial/parallel,
+	    errors);
+    exit (errors != 0);
+}
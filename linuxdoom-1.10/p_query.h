@@ -0,0 +1,39 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Map queries on several threads, checked.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __P_QUERY__
+#define __P_QUERY__
+
+
+// Called by startup code when -querytest is given.
+// Answers random sight and aim queries with the plain
+//  functions, then on threads with their own mapquery_t,
+//  compares the answers and exits.
+void P_QueryTest (int arg);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
@@ -26,7 +26,9 @@ rcsid[] = "$Id: p_tick.c,v 1.4 1997/02/03 16:47:55 b1 Exp $";
 
 #include "i_system.h"
 #include "z_zone.h"
+#include "m_random.h"
 #include "p_local.h"
+#include "s_sound.h"
 
 // State.
 #include "doomstat.h"
@@ -186,7 +188,7 @@ void P_UnArchiveWorld (void)
 	sec->special = *get++;		// needed?
 	sec->tag = *get++;		// needed?
 	sec->specialdata = 0;
-	sec->soundtarget = 0;
+	SECTORINFO(sec)->soundtarget = 0;
     }
     
     // do lines
@@ -208,6 +210,7 @@ void P_UnArchiveWorld (void)
 	}
     }
     save_p = (byte *)get;	
+    P_InvalidateSoundGraph ();
 }
 
 
@@ -312,6 +315,7 @@ void P_UnArchiveThinkers (void)
 	    mobj->ceilingz = mobj->subsector->sector->ceilingheight;
 	    mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
 	    P_AddThinker (&mobj->thinker);
+	    P_IndexMobj (mobj);
 	    break;
 			
 	  default:
@@ -584,3 +588,446 @@ void P_UnArchiveSpecials (void)
 
 }
 
+
+
+
+//
+// SNAPSHOTS
+// In-memory archives for the rewind ring (g_rewind.c).
+// A snapshot never leaves the process and is only restored
+//  on the level it was taken on, so unlike a savegame it
+//  keeps fixed point heights at full precision, stores
+//  pointers into the static level data as they are, and
+//  keeps every reference between thinkers (targets, tracers,
+//  sector and blockmap links) by numbering the thinker list.
+// Every thinker is copied raw, including ones that are
+//  removed but not yet freed, so a restored world runs
+//  exactly like the original did.
+//
+extern mobj_t*	braintargets[32];
+extern int	numbraintargets;
+extern int	braintargeton;
+
+static thinker_t**	snapthinkers;
+static int		snapmaxthinkers;
+static int		snapnumthinkers;
+
+
+//
+// P_SnapAllocThinkers
+// Makes room for num thinker pointers.
+//
+static void P_SnapAllocThinkers (int num)
+{
+    if (num <= snapmaxthinkers)
+	return;
+
+    if (snapthinkers)
+	Z_Free (snapthinkers);
+
+    snapmaxthinkers = snapmaxthinkers ? snapmaxthinkers*2 : 1024;
+    while (snapmaxthinkers < num)
+	snapmaxthinkers *= 2;
+
+    snapthinkers = Z_Malloc (snapmaxthinkers*sizeof(*snapthinkers),
+			     PU_STATIC, NULL);
+}
+
+
+//
+// P_SnapBlockSize
+// Thinkers come straight out of the zone,
+//  so the block header knows their size.
+//
+static int P_SnapBlockSize (thinker_t* th)
+{
+    memblock_t*	block;
+
+    block = (memblock_t *)((byte *)th - sizeof(memblock_t));
+    return block->size - sizeof(memblock_t);
+}
+
+
+//
+// P_SnapIndex
+// Thinker pointer to 1-based index, 0 for NULL or anything
+//  that is not in the thinker list any more (freed memory).
+// P_ArchiveSnapshot stashes the index in thinker.prev.
+//
+static int P_SnapIndex (void* ptr)
+{
+    thinker_t*	th;
+    long	idx;
+
+    th = ptr;
+    if (!th)
+	return 0;
+
+    idx = (long)th->prev;
+    if (idx < 1
+	|| idx > snapnumthinkers
+	|| snapthinkers[idx-1] != th)
+	return 0;
+
+    return idx;
+}
+
+
+//
+// P_SnapPointer
+// 1-based index back to the restored thinker.
+//
+static void* P_SnapPointer (int idx)
+{
+    if (idx < 1 || idx > snapnumthinkers)
+	return NULL;
+    return snapthinkers[idx-1];
+}
+
+
+//
+// P_SnapshotSize
+// Exact number of bytes P_ArchiveSnapshot will write,
+//  including worst case padding.
+//
+int P_SnapshotSize (void)
+{
+    thinker_t*	th;
+    int		size;
+    int		i;
+    int		j;
+
+    size = 8*sizeof(int) + MAXPLAYERS*(sizeof(player_t)+3);
+    size += numsectors*7*sizeof(int);
+    for (i=0 ; i<numlines ; i++)
+    {
+	size += 2*sizeof(int);
+	for (j=0 ; j<2 ; j++)
+	    if (lines[i].sidenum[j] != -1)
+		size += 4*sizeof(int);
+    }
+    size += (MAXCEILINGS + MAXPLATS + BODYQUESIZE + 32 + 8)*sizeof(int);
+    size += ITEMQUESIZE*(sizeof(mapthing_t) + sizeof(int)) + 3;
+    size += MAXBUTTONS*sizeof(button_t) + 3;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+	size += 2*sizeof(int) + P_SnapBlockSize (th) + 3;
+
+    return size;
+}
+
+
+//
+// P_ArchiveSnapshot
+// Writes the whole dynamic level state at save_p.
+// Caller must supply at least P_SnapshotSize() bytes.
+//
+void P_ArchiveSnapshot (void)
+{
+    thinker_t*	th;
+    thinker_t*	prev;
+    mobj_t*	mobj;
+    player_t*	player;
+    sector_t*	sec;
+    line_t*	li;
+    side_t*	si;
+    int*	put;
+    int		size;
+    int		i;
+    int		j;
+
+    // number the thinkers, stashing the index in prev
+    snapnumthinkers = 0;
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+	snapnumthinkers++;
+    P_SnapAllocThinkers (snapnumthinkers);
+
+    i = 0;
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    {
+	snapthinkers[i] = th;
+	th->prev = (thinker_t *)(long)++i;
+    }
+
+    PADSAVEP();
+    put = (int *)save_p;
+    *put++ = leveltime;
+    *put++ = prndindex;
+    *put++ = rndindex;
+    *put++ = snapnumthinkers;
+
+    // thinkers, in list order
+    for (i=0 ; i<snapnumthinkers ; i++)
+    {
+	th = snapthinkers[i];
+	size = P_SnapBlockSize (th);
+	*put++ = size;
+	*put++ = ((memblock_t *)((byte *)th - sizeof(memblock_t)))->tag;
+	memcpy (put, th, size);
+
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	{
+	    mobj = (mobj_t *)put;
+	    if (mobj->flags & MF_NOSECTOR)
+		mobj->snext = mobj->sprev = NULL;
+	    else
+	    {
+		mobj->snext = (mobj_t *)(long)P_SnapIndex (mobj->snext);
+		mobj->sprev = (mobj_t *)(long)P_SnapIndex (mobj->sprev);
+	    }
+	    if (mobj->flags & MF_NOBLOCKMAP)
+		mobj->bnext = mobj->bprev = NULL;
+	    else
+	    {
+		mobj->bnext = (mobj_t *)(long)P_SnapIndex (mobj->bnext);
+		mobj->bprev = (mobj_t *)(long)P_SnapIndex (mobj->bprev);
+	    }
+	    mobj->target = (mobj_t *)(long)P_SnapIndex (mobj->target);
+	    mobj->tracer = (mobj_t *)(long)P_SnapIndex (mobj->tracer);
+
+	    // the type lists are rebuilt in list order
+	    mobj->tnext = mobj->tprev = NULL;
+	}
+	put = (int *)((byte *)put + ((size+3)&~3));
+    }
+
+    // players
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i])
+	    continue;
+
+	player = (player_t *)put;
+	memcpy (player, &players[i], sizeof(player_t));
+	player->mo = (mobj_t *)(long)P_SnapIndex (player->mo);
+	player->attacker = (mobj_t *)(long)P_SnapIndex (player->attacker);
+	put = (int *)((byte *)put + ((sizeof(player_t)+3)&~3));
+    }
+
+    // sectors
+    for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
+    {
+	*put++ = sec->floorheight;
+	*put++ = sec->ceilingheight;
+	*put++ = (sec->floorpic<<16) | (unsigned short)sec->ceilingpic;
+	*put++ = (sec->lightlevel<<16) | (unsigned short)sec->special;
+	*put++ = (sec->tag<<16) | (SECTORINFO(sec)->soundtraversed & 0xffff);
+	*put++ = P_SnapIndex (SECTORINFO(sec)->soundtarget);
+	*put++ = P_SnapIndex (sec->specialdata);
+    }
+
+    // lines
+    for (i=0, li = lines ; i<numlines ; i++,li++)
+    {
+	*put++ = (li->flags<<16) | (unsigned short)li->special;
+	*put++ = li->tag;
+	for (j=0 ; j<2 ; j++)
+	{
+	    if (li->sidenum[j] == -1)
+		continue;
+
+	    si = &sides[li->sidenum[j]];
+	    *put++ = si->textureoffset;
+	    *put++ = si->rowoffset;
+	    *put++ = (si->toptexture<<16) | (unsigned short)si->bottomtexture;
+	    *put++ = si->midtexture;
+	}
+    }
+
+    // lists that point into the thinkers
+    for (i=0 ; i<MAXCEILINGS ; i++)
+	*put++ = P_SnapIndex (activeceilings[i]);
+    for (i=0 ; i<MAXPLATS ; i++)
+	*put++ = P_SnapIndex (activeplats[i]);
+    *put++ = bodyqueslot;
+    for (i=0 ; i<BODYQUESIZE ; i++)
+	*put++ = P_SnapIndex (bodyque[i]);
+    *put++ = numbraintargets;
+    *put++ = braintargeton;
+    for (i=0 ; i<numbraintargets ; i++)
+	*put++ = P_SnapIndex (braintargets[i]);
+
+    // item respawn queue and switches hold no thinker pointers
+    *put++ = iquehead;
+    *put++ = iquetail;
+    memcpy (put, itemrespawntime, sizeof(itemrespawntime));
+    put += ITEMQUESIZE;
+    save_p = (byte *)put;
+    memcpy (save_p, itemrespawnque, sizeof(itemrespawnque));
+    save_p += sizeof(itemrespawnque);
+    PADSAVEP();
+    memcpy (save_p, buttonlist, sizeof(buttonlist));
+    save_p += sizeof(buttonlist);
+    PADSAVEP();
+
+    // put the thinker list back together
+    prev = &thinkercap;
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    {
+	th->prev = prev;
+	prev = th;
+    }
+}
+
+
+//
+// P_UnArchiveSnapshot
+// Replaces the current level state with the one at save_p.
+//
+void P_UnArchiveSnapshot (void)
+{
+    thinker_t*	th;
+    thinker_t*	next;
+    mobj_t*	mobj;
+    sector_t*	sec;
+    line_t*	li;
+    side_t*	si;
+    int*	get;
+    int		size;
+    int		tag;
+    int		blockx;
+    int		blocky;
+    int		i;
+    int		j;
+
+    // throw away the current thinkers; the sector and
+    //  block links are rebuilt from scratch below
+    th = thinkercap.next;
+    while (th != &thinkercap)
+    {
+	next = th->next;
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	    S_StopSound ((mobj_t *)th);
+	Z_Free (th);
+	th = next;
+    }
+    P_InitThinkers ();
+
+    for (i=0 ; i<numsectors ; i++)
+	sectors[i].thinglist = NULL;
+    memset (blocklinks, 0, bmapwidth*bmapheight*sizeof(*blocklinks));
+
+    PADSAVEP();
+    get = (int *)save_p;
+    leveltime = *get++;
+    prndindex = *get++;
+    rndindex = *get++;
+    snapnumthinkers = *get++;
+    P_SnapAllocThinkers (snapnumthinkers);
+
+    for (i=0 ; i<snapnumthinkers ; i++)
+    {
+	size = *get++;
+	tag = *get++;
+	th = Z_Malloc (size, tag, NULL);
+	memcpy (th, get, size);
+	P_AddThinker (th);
+	snapthinkers[i] = th;
+	get = (int *)((byte *)get + ((size+3)&~3));
+    }
+
+    // resolve the mobj references now everything exists
+    for (i=0 ; i<snapnumthinkers ; i++)
+    {
+	th = snapthinkers[i];
+	if (th->function.acp1 != (actionf_p1)P_MobjThinker)
+	    continue;
+
+	mobj = (mobj_t *)th;
+	mobj->snext = P_SnapPointer ((long)mobj->snext);
+	mobj->sprev = P_SnapPointer ((long)mobj->sprev);
+	mobj->bnext = P_SnapPointer ((long)mobj->bnext);
+	mobj->bprev = P_SnapPointer ((long)mobj->bprev);
+	mobj->target = P_SnapPointer ((long)mobj->target);
+	mobj->tracer = P_SnapPointer ((long)mobj->tracer);
+	if (mobj->player)
+	    mobj->player->mo = mobj;
+	P_IndexMobj (mobj);
+
+	// list heads have no predecessor
+	if (!(mobj->flags & MF_NOSECTOR) && !mobj->sprev)
+	    mobj->subsector->sector->thinglist = mobj;
+
+	if (!(mobj->flags & MF_NOBLOCKMAP) && !mobj->bprev)
+	{
+	    blockx = (mobj->x - bmaporgx)>>MAPBLOCKSHIFT;
+	    blocky = (mobj->y - bmaporgy)>>MAPBLOCKSHIFT;
+
+	    if (blockx>=0 && blockx < bmapwidth
+		&& blocky>=0 && blocky < bmapheight)
+	    {
+		blocklinks[blocky*bmapwidth+blockx] = mobj;
+	    }
+	}
+    }
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i])
+	    continue;
+
+	memcpy (&players[i], get, sizeof(player_t));
+	players[i].mo = P_SnapPointer ((long)players[i].mo);
+	players[i].attacker = P_SnapPointer ((long)players[i].attacker);
+	get = (int *)((byte *)get + ((sizeof(player_t)+3)&~3));
+    }
+
+    for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
+    {
+	sec->floorheight = *get++;
+	sec->ceilingheight = *get++;
+	sec->floorpic = *get >> 16;
+	sec->ceilingpic = *get++;
+	sec->lightlevel = *get >> 16;
+	sec->special = *get++;
+	sec->tag = *get >> 16;
+	SECTORINFO(sec)->soundtraversed = (short)*get++;
+	SECTORINFO(sec)->soundtarget = P_SnapPointer (*get++);
+	sec->specialdata = P_SnapPointer (*get++);
+    }
+
+    for (i=0, li = lines ; i<numlines ; i++,li++)
+    {
+	li->flags = *get >> 16;
+	li->special = *get++;
+	li->tag = *get++;
+	for (j=0 ; j<2 ; j++)
+	{
+	    if (li->sidenum[j] == -1)
+		continue;
+
+	    si = &sides[li->sidenum[j]];
+	    si->textureoffset = *get++;
+	    si->rowoffset = *get++;
+	    si->toptexture = *get >> 16;
+	    si->bottomtexture = *get++;
+	    si->midtexture = *get++;
+	}
+    }
+
+    for (i=0 ; i<MAXCEILINGS ; i++)
+	activeceilings[i] = P_SnapPointer (*get++);
+    for (i=0 ; i<MAXPLATS ; i++)
+	activeplats[i] = P_SnapPointer (*get++);
+    bodyqueslot = *get++;
+    for (i=0 ; i<BODYQUESIZE ; i++)
+	bodyque[i] = P_SnapPointer (*get++);
+    numbraintargets = *get++;
+    braintargeton = *get++;
+    for (i=0 ; i<numbraintargets ; i++)
+	braintargets[i] = P_SnapPointer (*get++);
+
+    iquehead = *get++;
+    iquetail = *get++;
+    memcpy (itemrespawntime, get, sizeof(itemrespawntime));
+    get += ITEMQUESIZE;
+    save_p = (byte *)get;
+    memcpy (itemrespawnque, save_p, sizeof(itemrespawnque));
+    save_p += sizeof(itemrespawnque);
+    PADSAVEP();
+    memcpy (buttonlist, save_p, sizeof(buttonlist));
+    save_p += sizeof(buttonlist);
+    PADSAVEP();
+
+    P_InvalidateSoundGraph ();
+}
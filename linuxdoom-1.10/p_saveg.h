@@ -40,6 +40,12 @@ void P_UnArchiveThinkers (void);
 void P_ArchiveSpecials (void);
 void P_UnArchiveSpecials (void);
 
+// In-memory snapshots of the running level, for rewind.
+// Only valid on the level they were taken on.
+int  P_SnapshotSize (void);
+void P_ArchiveSnapshot (void);
+void P_UnArchiveSnapshot (void);
+
 extern byte*		save_p; 
 
 
@@ -58,9 +58,11 @@ vertex_t*	vertexes;
 
 int		numsegs;
 seg_t*		segs;
+segclip_t*	segclips;
 
 int		numsectors;
 sector_t*	sectors;
+sectorinfo_t*	sectorinfo;
 
 int		numsubsectors;
 subsector_t*	subsectors;
@@ -70,6 +72,7 @@ node_t*		nodes;
 
 int		numlines;
 line_t*		lines;
+lineclip_t*	lineclips;
 
 int		numsides;
 side_t*		sides;
@@ -162,6 +165,7 @@ void P_LoadSegs (int lump)
     int			i;
     mapseg_t*		ml;
     seg_t*		li;
+    segclip_t*		clip;
     line_t*		ldef;
     int			linedef;
     int			side;
@@ -169,11 +173,13 @@ void P_LoadSegs (int lump)
     numsegs = W_LumpLength (lump) / sizeof(mapseg_t);
     segs = Z_Malloc (numsegs*sizeof(seg_t),PU_LEVEL,0);	
     memset (segs, 0, numsegs*sizeof(seg_t));
+    segclips = Z_Malloc (numsegs*sizeof(segclip_t),PU_LEVEL,0);
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
     ml = (mapseg_t *)data;
     li = segs;
-    for (i=0 ; i<numsegs ; i++, li++, ml++)
+    clip = segclips;
+    for (i=0 ; i<numsegs ; i++, li++, clip++, ml++)
     {
 	li->v1 = &vertexes[SHORT(ml->v1)];
 	li->v2 = &vertexes[SHORT(ml->v2)];
@@ -190,6 +196,14 @@ void P_LoadSegs (int lump)
 	    li->backsector = sides[ldef->sidenum[side^1]].sector;
 	else
 	    li->backsector = 0;
+
+	clip->x1 = li->v1->x;
+	clip->y1 = li->v1->y;
+	clip->x2 = li->v2->x;
+	clip->y2 = li->v2->y;
+	clip->angle = li->angle;
+	clip->sidedef = ldef->sidenum[side];
+	clip->backsector = li->backsector ? li->backsector - sectors : -1;
     }
 	
     Z_Free (data);
@@ -238,6 +252,8 @@ void P_LoadSectors (int lump)
     numsectors = W_LumpLength (lump) / sizeof(mapsector_t);
     sectors = Z_Malloc (numsectors*sizeof(sector_t),PU_LEVEL,0);	
     memset (sectors, 0, numsectors*sizeof(sector_t));
+    sectorinfo = Z_Malloc (numsectors*sizeof(sectorinfo_t),PU_LEVEL,0);
+    memset (sectorinfo, 0, numsectors*sizeof(sectorinfo_t));
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
     ms = (mapsector_t *)data;
@@ -360,17 +376,20 @@ void P_LoadLineDefs (int lump)
     int			i;
     maplinedef_t*	mld;
     line_t*		ld;
+    lineclip_t*		clip;
     vertex_t*		v1;
     vertex_t*		v2;
 	
     numlines = W_LumpLength (lump) / sizeof(maplinedef_t);
     lines = Z_Malloc (numlines*sizeof(line_t),PU_LEVEL,0);	
     memset (lines, 0, numlines*sizeof(line_t));
+    lineclips = Z_Malloc (numlines*sizeof(lineclip_t),PU_LEVEL,0);
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
     mld = (maplinedef_t *)data;
     ld = lines;
-    for (i=0 ; i<numlines ; i++, mld++, ld++)
+    clip = lineclips;
+    for (i=0 ; i<numlines ; i++, mld++, ld++, clip++)
     {
 	ld->flags = SHORT(mld->flags);
 	ld->special = SHORT(mld->special);
@@ -426,6 +445,16 @@ void P_LoadLineDefs (int lump)
 	    ld->backsector = sides[ld->sidenum[1]].sector;
 	else
 	    ld->backsector = 0;
+
+	memcpy (clip->bbox, ld->bbox, sizeof(clip->bbox));
+	clip->x = v1->x;
+	clip->y = v1->y;
+	clip->dx = ld->dx;
+	clip->dy = ld->dy;
+	clip->frontsector = ld->frontsector ? ld->frontsector - sectors : -1;
+	clip->backsector = ld->backsector ? ld->backsector - sectors : -1;
+	clip->slopetype = ld->slopetype;
+	clip->flags = ld->flags & (ML_BLOCKING|ML_BLOCKMONSTERS);
     }
 	
     Z_Free (data);
@@ -504,6 +533,7 @@ void P_GroupLines (void)
     int			total;
     line_t*		li;
     sector_t*		sector;
+    sectorinfo_t*	info;
     subsector_t*	ss;
     seg_t*		seg;
     fixed_t		bbox[4];
@@ -553,30 +583,325 @@ void P_GroupLines (void)
 	    I_Error ("P_GroupLines: miscounted");
 			
 	// set the degenmobj_t to the middle of the bounding box
-	sector->soundorg.x = (bbox[BOXRIGHT]+bbox[BOXLEFT])/2;
-	sector->soundorg.y = (bbox[BOXTOP]+bbox[BOXBOTTOM])/2;
+	info = &sectorinfo[i];
+	info->soundorg.x = (bbox[BOXRIGHT]+bbox[BOXLEFT])/2;
+	info->soundorg.y = (bbox[BOXTOP]+bbox[BOXBOTTOM])/2;
 		
 	// adjust bounding box to map blocks
 	block = (bbox[BOXTOP]-bmaporgy+MAXRADIUS)>>MAPBLOCKSHIFT;
 	block = block >= bmapheight ? bmapheight-1 : block;
-	sector->blockbox[BOXTOP]=block;
+	info->blockbox[BOXTOP]=block;
 
 	block = (bbox[BOXBOTTOM]-bmaporgy-MAXRADIUS)>>MAPBLOCKSHIFT;
 	block = block < 0 ? 0 : block;
-	sector->blockbox[BOXBOTTOM]=block;
+	info->blockbox[BOXBOTTOM]=block;
 
 	block = (bbox[BOXRIGHT]-bmaporgx+MAXRADIUS)>>MAPBLOCKSHIFT;
 	block = block >= bmapwidth ? bmapwidth-1 : block;
-	sector->blockbox[BOXRIGHT]=block;
+	info->blockbox[BOXRIGHT]=block;
 
 	block = (bbox[BOXLEFT]-bmaporgx-MAXRADIUS)>>MAPBLOCKSHIFT;
 	block = block < 0 ? 0 : block;
-	sector->blockbox[BOXLEFT]=block;
+	info->blockbox[BOXLEFT]=block;
     }
 	
 }
 
 
+//
+// LEVEL BASELINE
+// The parts of the map a running level changes, as loaded.
+// Lets a savegame of the map already in memory restart it
+//  without parsing the map lumps again.
+//
+typedef struct
+{
+    fixed_t	floorheight;
+    fixed_t	ceilingheight;
+    short	floorpic;
+    short	ceilingpic;
+    short	lightlevel;
+    short	special;
+    short	tag;
+    
+} sectorbase_t;
+
+typedef struct
+{
+    fixed_t	textureoffset;
+    fixed_t	rowoffset;
+    short	toptexture;
+    short	bottomtexture;
+    short	midtexture;
+    
+} sidebase_t;
+
+typedef struct
+{
+    short	flags;
+    short	special;
+    short	tag;
+    
+} linebase_t;
+
+// Set by G_DoLoadGame before G_InitNew,
+//  cleared by P_SetupLevel if the map had to be loaded.
+boolean		reuselevel;
+
+// Map lump of the level in memory, -1 if none.
+static int		levellump = -1;
+
+static sectorbase_t*	sectorbase;
+static sidebase_t*	sidebase;
+static linebase_t*	linebase;
+
+extern char*		reloadname;
+
+
+//
+// P_SaveLevelBase
+//
+void P_SaveLevelBase (void)
+{
+    int		i;
+
+    sectorbase = Z_Malloc (numsectors*sizeof(*sectorbase), PU_LEVEL, 0);
+    for (i=0 ; i<numsectors ; i++)
+    {
+	sectorbase[i].floorheight = sectors[i].floorheight;
+	sectorbase[i].ceilingheight = sectors[i].ceilingheight;
+	sectorbase[i].floorpic = sectors[i].floorpic;
+	sectorbase[i].ceilingpic = sectors[i].ceilingpic;
+	sectorbase[i].lightlevel = sectors[i].lightlevel;
+	sectorbase[i].special = sectors[i].special;
+	sectorbase[i].tag = sectors[i].tag;
+    }
+
+    sidebase = Z_Malloc (numsides*sizeof(*sidebase), PU_LEVEL, 0);
+    for (i=0 ; i<numsides ; i++)
+    {
+	sidebase[i].textureoffset = sides[i].textureoffset;
+	sidebase[i].rowoffset = sides[i].rowoffset;
+	sidebase[i].toptexture = sides[i].toptexture;
+	sidebase[i].bottomtexture = sides[i].bottomtexture;
+	sidebase[i].midtexture = sides[i].midtexture;
+    }
+
+    linebase = Z_Malloc (numlines*sizeof(*linebase), PU_LEVEL, 0);
+    for (i=0 ; i<numlines ; i++)
+    {
+	linebase[i].flags = lines[i].flags;
+	linebase[i].special = lines[i].special;
+	linebase[i].tag = lines[i].tag;
+    }
+}
+
+
+//
+// P_ResetLevel
+// Frees the thinkers and puts the map back the way
+//  it was loaded. The static geometry stays.
+//
+void P_ResetLevel (void)
+{
+    thinker_t*	th;
+    thinker_t*	next;
+    int		i;
+
+    th = thinkercap.next;
+    while (th != &thinkercap)
+    {
+	next = th->next;
+	Z_Free (th);
+	th = next;
+    }
+    P_InitThinkers ();
+
+    for (i=0 ; i<numsectors ; i++)
+    {
+	sectors[i].floorheight = sectorbase[i].floorheight;
+	sectors[i].ceilingheight = sectorbase[i].ceilingheight;
+	sectors[i].floorpic = sectorbase[i].floorpic;
+	sectors[i].ceilingpic = sectorbase[i].ceilingpic;
+	sectors[i].lightlevel = sectorbase[i].lightlevel;
+	sectors[i].special = sectorbase[i].special;
+	sectors[i].tag = sectorbase[i].tag;
+	sectorinfo[i].soundtraversed = 0;
+	sectorinfo[i].soundtarget = NULL;
+	sectors[i].thinglist = NULL;
+	sectors[i].specialdata = NULL;
+    }
+
+    for (i=0 ; i<numsides ; i++)
+    {
+	sides[i].textureoffset = sidebase[i].textureoffset;
+	sides[i].rowoffset = sidebase[i].rowoffset;
+	sides[i].toptexture = sidebase[i].toptexture;
+	sides[i].bottomtexture = sidebase[i].bottomtexture;
+	sides[i].midtexture = sidebase[i].midtexture;
+    }
+
+    for (i=0 ; i<numlines ; i++)
+    {
+	lines[i].flags = linebase[i].flags;
+	lines[i].special = linebase[i].special;
+	lines[i].tag = linebase[i].tag;
+	lines[i].specialdata = NULL;
+    }
+
+    memset (blocklinks, 0, bmapwidth*bmapheight*sizeof(*blocklinks));
+}
+
+
+//
+// HOT RELOAD
+// Property changes to sectors, sides and lines are made in
+//  place, as long as the structure of the map is the same.
+// Each returns false if the level has to be loaded again.
+//
+static boolean P_ReloadSectors (int lump)
+{
+    byte*		data;
+    int			i;
+    mapsector_t*	ms;
+    sector_t*		ss;
+    sectorbase_t*	base;
+
+    if (W_LumpLength (lump) != numsectors*sizeof(mapsector_t))
+	return false;
+    data = W_CacheLumpNum (lump,PU_STATIC);
+
+    ms = (mapsector_t *)data;
+    ss = sectors;
+    base = sectorbase;
+    for (i=0 ; i<numsectors ; i++, ss++, ms++, base++)
+    {
+	ss->floorheight = base->floorheight = SHORT(ms->floorheight)<<FRACBITS;
+	ss->ceilingheight = base->ceilingheight
+	    = SHORT(ms->ceilingheight)<<FRACBITS;
+	ss->floorpic = base->floorpic = R_FlatNumForName(ms->floorpic);
+	ss->ceilingpic = base->ceilingpic = R_FlatNumForName(ms->ceilingpic);
+	ss->lightlevel = base->lightlevel = SHORT(ms->lightlevel);
+	ss->special = base->special = SHORT(ms->special);
+	ss->tag = base->tag = SHORT(ms->tag);
+
+	// things stand on the new floor
+	P_ChangeSector (ss, false);
+    }
+
+    Z_Free (data);
+    return true;
+}
+
+
+static boolean P_ReloadSideDefs (int lump)
+{
+    byte*		data;
+    int			i;
+    mapsidedef_t*	msd;
+    side_t*		sd;
+    sidebase_t*		base;
+
+    if (W_LumpLength (lump) != numsides*sizeof(mapsidedef_t))
+	return false;
+    data = W_CacheLumpNum (lump,PU_STATIC);
+
+    msd = (mapsidedef_t *)data;
+    for (i=0 ; i<numsides ; i++, msd++)
+	if (sides[i].sector != &sectors[SHORT(msd->sector)])
+	{
+	    Z_Free (data);
+	    return false;
+	}
+
+    msd = (mapsidedef_t *)data;
+    sd = sides;
+    base = sidebase;
+    for (i=0 ; i<numsides ; i++, msd++, sd++, base++)
+    {
+	sd->textureoffset = base->textureoffset
+	    = SHORT(msd->textureoffset)<<FRACBITS;
+	sd->rowoffset = base->rowoffset = SHORT(msd->rowoffset)<<FRACBITS;
+	sd->toptexture = base->toptexture
+	    = R_TextureNumForName(msd->toptexture);
+	sd->bottomtexture = base->bottomtexture
+	    = R_TextureNumForName(msd->bottomtexture);
+	sd->midtexture = base->midtexture
+	    = R_TextureNumForName(msd->midtexture);
+    }
+
+    Z_Free (data);
+    return true;
+}
+
+
+static boolean P_ReloadLineDefs (int lump)
+{
+    byte*		data;
+    int			i;
+    maplinedef_t*	mld;
+    line_t*		ld;
+    linebase_t*		base;
+
+    if (W_LumpLength (lump) != numlines*sizeof(maplinedef_t))
+	return false;
+    data = W_CacheLumpNum (lump,PU_STATIC);
+
+    mld = (maplinedef_t *)data;
+    ld = lines;
+    for (i=0 ; i<numlines ; i++, mld++, ld++)
+	if (ld->v1 != &vertexes[SHORT(mld->v1)]
+	    || ld->v2 != &vertexes[SHORT(mld->v2)]
+	    || ld->sidenum[0] != SHORT(mld->sidenum[0])
+	    || ld->sidenum[1] != SHORT(mld->sidenum[1]))
+	{
+	    Z_Free (data);
+	    return false;
+	}
+
+    mld = (maplinedef_t *)data;
+    ld = lines;
+    base = linebase;
+    for (i=0 ; i<numlines ; i++, mld++, ld++, base++)
+    {
+	ld->flags = base->flags = SHORT(mld->flags);
+	ld->special = base->special = SHORT(mld->special);
+	ld->tag = base->tag = SHORT(mld->tag);
+	lineclips[i].flags = ld->flags & (ML_BLOCKING|ML_BLOCKMONSTERS);
+    }
+
+    Z_Free (data);
+    return true;
+}
+
+
+//
+// P_ReloadMapLump
+// Called by G_HotReload for every lump that changed.
+//
+boolean P_ReloadMapLump (int lump)
+{
+    P_InvalidateSoundGraph ();
+    if (levellump == -1
+	|| lump <= levellump
+	|| lump > levellump+ML_BLOCKMAP)
+	return true;
+
+    switch (lump - levellump)
+    {
+      case ML_SECTORS:
+	return P_ReloadSectors (lump);
+      case ML_SIDEDEFS:
+	return P_ReloadSideDefs (lump);
+      case ML_LINEDEFS:
+	return P_ReloadLineDefs (lump);
+    }
+
+    // the rest shapes the map, or populates it
+    return false;
+}
+
+
 //
 // P_SetupLevel
 //
@@ -590,7 +915,10 @@ P_SetupLevel
     int		i;
     char	lumpname[9];
     int		lumpnum;
+    int		start;
+    zonestats_t	stats;
 	
+    start = I_GetTimeUS ();
     totalkills = totalitems = totalsecret = wminfo.maxfrags = 0;
     wminfo.partime = 180;
     for (i=0 ; i<MAXPLAYERS ; i++)
@@ -606,24 +934,6 @@ P_SetupLevel
     // Make sure all sounds are stopped before Z_FreeTags.
     S_Start ();			
 
-    
-#if 0 // UNUSED
-    if (debugfile)
-    {
-	Z_FreeTags (PU_LEVEL, MAXINT);
-	Z_FileDumpHeap (debugfile);
-    }
-    else
-#endif
-	Z_FreeTags (PU_LEVEL, PU_PURGELEVEL-1);
-
-
-    // UNUSED W_Profile ();
-    P_InitThinkers ();
-
-    // if working with a devlopment map, reload it
-    W_Reload ();			
-	   
     // find map name
     if ( gamemode == commercial)
     {
@@ -644,20 +954,51 @@ P_SetupLevel
     lumpnum = W_GetNumForName (lumpname);
 	
     leveltime = 0;
-	
-    // note: most of this ordering is important	
-    P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
-    P_LoadVertexes (lumpnum+ML_VERTEXES);
-    P_LoadSectors (lumpnum+ML_SECTORS);
-    P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
 
-    P_LoadLineDefs (lumpnum+ML_LINEDEFS);
-    P_LoadSubsectors (lumpnum+ML_SSECTORS);
-    P_LoadNodes (lumpnum+ML_NODES);
-    P_LoadSegs (lumpnum+ML_SEGS);
+    // a savegame of the level in memory only needs
+    //  the dynamic state reset, development maps
+    //  are always read again
+    if (reuselevel && lumpnum == levellump && !reloadname)
+    {
+	P_ResetLevel ();
+    }
+    else
+    {
+	reuselevel = false;
+
+#if 0 // UNUSED
+	if (debugfile)
+	{
+	    Z_FreeTags (PU_LEVEL, MAXINT);
+	    Z_FileDumpHeap (debugfile);
+	}
+	else
+#endif
+	    Z_FreeTags (PU_LEVEL, PU_PURGELEVEL-1);
+
+
+	// UNUSED W_Profile ();
+	P_InitThinkers ();
+
+	// if working with a devlopment map, reload it
+	W_Reload ();			
+	   
+	// note: most of this ordering is important	
+	P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
+	P_LoadVertexes (lumpnum+ML_VERTEXES);
+	P_LoadSectors (lumpnum+ML_SECTORS);
+	P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
+
+	P_LoadLineDefs (lumpnum+ML_LINEDEFS);
+	P_LoadSubsectors (lumpnum+ML_SSECTORS);
+	P_LoadNodes (lumpnum+ML_NODES);
+	P_LoadSegs (lumpnum+ML_SEGS);
 	
-    rejectmatrix = W_CacheLumpNum (lumpnum+ML_REJECT,PU_LEVEL);
-    P_GroupLines ();
+	rejectmatrix = W_CacheLumpNum (lumpnum+ML_REJECT,PU_LEVEL);
+	P_GroupLines ();
+	P_SaveLevelBase ();
+	levellump = lumpnum;
+    }
 
     bodyqueslot = 0;
     deathmatch_p = deathmatchstarts;
@@ -684,12 +1025,19 @@ P_SetupLevel
     // build subsector connect matrix
     //	UNUSED P_ConnectSubsectors ();
 
-    // preload graphics
-    if (precache)
-	R_PrecacheLevel ();
+    // heights and lines are as loaded again
+    P_InvalidateSoundGraph ();
 
-    //printf ("free memory: 0x%x\n", Z_FreeMemory());
+    // preload graphics, a reused level has them already
+    if (precache && !reuselevel)
+	R_PrecacheLevel ();
 
+    Z_GetStats (&stats);
+    printf ("P_SetupLevel: %s in %i ms, old level freed in %i us, "
+	    "zone %i%% fragmented, level arena %i of %i KB\n",
+	    lumpname, (I_GetTimeUS () - start)/1000,
+	    reuselevel ? 0 : stats.levelfreetime, stats.fragmentation,
+	    stats.arenaused>>10, stats.arenasize>>10);
 }
 
 
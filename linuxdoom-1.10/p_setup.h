@@ -40,6 +40,14 @@ P_SetupLevel
 // Called by startup code.
 void P_Init (void);
 
+// Lets the next P_SetupLevel keep the map in memory
+//  if it is the same one, see G_DoLoadGame.
+extern boolean	reuselevel;
+
+// Updates the level in memory for a lump that changed
+//  on disk. Returns false if it has to be loaded again.
+boolean P_ReloadMapLump (int lump);
+
 #endif
 //-----------------------------------------------------------------------------
 //
@@ -33,20 +33,6 @@ rcsid[] = "$Id: p_sight.c,v 1.3 1997/01/28 22:08:28 b1 Exp $";
 // State.
 #include "r_state.h"
 
-//
-// P_CheckSight
-//
-fixed_t		sightzstart;		// eye z of looker
-fixed_t		topslope;
-fixed_t		bottomslope;		// slopes to top and bottom of target
-
-divline_t	strace;			// from t1 to t2
-fixed_t		t2x;
-fixed_t		t2y;
-
-int		sightcounts[2];
-
-
 //
 // P_DivlineSide
 // Returns side 0 (front), 1 (back), or 2 (on).
@@ -130,9 +116,12 @@ P_InterceptVector2
 //
 // P_CrossSubsector
 // Returns true
-//  if strace crosses the given subsector successfully.
+//  if q->strace crosses the given subsector successfully.
 //
-boolean P_CrossSubsector (int num)
+boolean
+P_CrossSubsector
+( mapquery_t*	q,
+  int		num )
 {
     seg_t*		seg;
     line_t*		line;
@@ -168,15 +157,13 @@ boolean P_CrossSubsector (int num)
 	line = seg->linedef;
 
 	// allready checked other side?
-	if (line->validcount == validcount)
+	if (P_QueryLineSeen (q, line))
 	    continue;
-	
-	line->validcount = validcount;
 		
 	v1 = line->v1;
 	v2 = line->v2;
-	s1 = P_DivlineSide (v1->x,v1->y, &strace);
-	s2 = P_DivlineSide (v2->x, v2->y, &strace);
+	s1 = P_DivlineSide (v1->x,v1->y, &q->strace);
+	s2 = P_DivlineSide (v2->x, v2->y, &q->strace);
 
 	// line isn't crossed?
 	if (s1 == s2)
@@ -186,8 +173,8 @@ boolean P_CrossSubsector (int num)
 	divl.y = v1->y;
 	divl.dx = v2->x - v1->x;
 	divl.dy = v2->y - v1->y;
-	s1 = P_DivlineSide (strace.x, strace.y, &divl);
-	s2 = P_DivlineSide (t2x, t2y, &divl);
+	s1 = P_DivlineSide (q->strace.x, q->strace.y, &divl);
+	s2 = P_DivlineSide (q->t2x, q->t2y, &divl);
 
 	// line isn't crossed?
 	if (s1 == s2)
@@ -224,23 +211,23 @@ boolean P_CrossSubsector (int num)
 	if (openbottom >= opentop)	
 	    return false;		// stop
 	
-	frac = P_InterceptVector2 (&strace, &divl);
+	frac = P_InterceptVector2 (&q->strace, &divl);
 		
 	if (front->floorheight != back->floorheight)
 	{
-	    slope = FixedDiv (openbottom - sightzstart , frac);
-	    if (slope > bottomslope)
-		bottomslope = slope;
+	    slope = FixedDiv (openbottom - q->sightzstart , frac);
+	    if (slope > q->bottomslope)
+		q->bottomslope = slope;
 	}
 		
 	if (front->ceilingheight != back->ceilingheight)
 	{
-	    slope = FixedDiv (opentop - sightzstart , frac);
-	    if (slope < topslope)
-		topslope = slope;
+	    slope = FixedDiv (opentop - q->sightzstart , frac);
+	    if (slope < q->topslope)
+		q->topslope = slope;
 	}
 		
-	if (topslope <= bottomslope)
+	if (q->topslope <= q->bottomslope)
 	    return false;		// stop				
     }
     // passed the subsector ok
@@ -252,9 +239,12 @@ boolean P_CrossSubsector (int num)
 //
 // P_CrossBSPNode
 // Returns true
-//  if strace crosses the given node successfully.
+//  if q->strace crosses the given node successfully.
 //
-boolean P_CrossBSPNode (int bspnum)
+boolean
+P_CrossBSPNode
+( mapquery_t*	q,
+  int		bspnum )
 {
     node_t*	bsp;
     int		side;
@@ -262,43 +252,44 @@ boolean P_CrossBSPNode (int bspnum)
     if (bspnum & NF_SUBSECTOR)
     {
 	if (bspnum == -1)
-	    return P_CrossSubsector (0);
+	    return P_CrossSubsector (q, 0);
 	else
-	    return P_CrossSubsector (bspnum&(~NF_SUBSECTOR));
+	    return P_CrossSubsector (q, bspnum&(~NF_SUBSECTOR));
     }
 		
     bsp = &nodes[bspnum];
     
     // decide which side the start point is on
-    side = P_DivlineSide (strace.x, strace.y, (divline_t *)bsp);
+    side = P_DivlineSide (q->strace.x, q->strace.y, (divline_t *)bsp);
     if (side == 2)
 	side = 0;	// an "on" should cross both sides
 
     // cross the starting side
-    if (!P_CrossBSPNode (bsp->children[side]) )
+    if (!P_CrossBSPNode (q, bsp->children[side]) )
 	return false;
 	
     // the partition plane is crossed here
-    if (side == P_DivlineSide (t2x, t2y,(divline_t *)bsp))
+    if (side == P_DivlineSide (q->t2x, q->t2y,(divline_t *)bsp))
     {
 	// the line doesn't touch the other side
 	return true;
     }
     
     // cross the ending side		
-    return P_CrossBSPNode (bsp->children[side^1]);
+    return P_CrossBSPNode (q, bsp->children[side^1]);
 }
 
 
 //
-// P_CheckSight
+// P_QuerySight
 // Returns true
 //  if a straight line between t1 and t2 is unobstructed.
 // Uses REJECT.
 //
 boolean
-P_CheckSight
-( mobj_t*	t1,
+P_QuerySight
+( mapquery_t*	q,
+  mobj_t*	t1,
   mobj_t*	t2 )
 {
     int		s1;
@@ -319,7 +310,7 @@ P_CheckSight
     // Check in REJECT table.
     if (rejectmatrix[bytenum]&bitnum)
     {
-	sightcounts[0]++;
+	q->sightcounts[0]++;
 
 	// can't possibly be connected
 	return false;	
@@ -327,23 +318,35 @@ P_CheckSight
 
     // An unobstructed LOS is possible.
     // Now look from eyes of t1 to any part of t2.
-    sightcounts[1]++;
+    q->sightcounts[1]++;
 
-    validcount++;
+    P_QueryNewVisit (q);
 	
-    sightzstart = t1->z + t1->height - (t1->height>>2);
-    topslope = (t2->z+t2->height) - sightzstart;
-    bottomslope = (t2->z) - sightzstart;
+    q->sightzstart = t1->z + t1->height - (t1->height>>2);
+    q->topslope = (t2->z+t2->height) - q->sightzstart;
+    q->bottomslope = (t2->z) - q->sightzstart;
 	
-    strace.x = t1->x;
-    strace.y = t1->y;
-    t2x = t2->x;
-    t2y = t2->y;
-    strace.dx = t2->x - t1->x;
-    strace.dy = t2->y - t1->y;
+    q->strace.x = t1->x;
+    q->strace.y = t1->y;
+    q->t2x = t2->x;
+    q->t2y = t2->y;
+    q->strace.dx = t2->x - t1->x;
+    q->strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode (numnodes-1);	
+    return P_CrossBSPNode (q, numnodes-1);	
+}
+
+
+//
+// P_CheckSight
+//
+boolean
+P_CheckSight
+( mobj_t*	t1,
+  mobj_t*	t2 )
+{
+    return P_QuerySight (&mainquery, t1, t2);
 }
 
 
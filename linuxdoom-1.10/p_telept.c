@@ -50,12 +50,11 @@ EV_Teleport
   int		side,
   mobj_t*	thing )
 {
-    int		i;
     int		tag;
     mobj_t*	m;
+    mobj_t*	dest;
     mobj_t*	fog;
     unsigned	an;
-    thinker_t*	thinker;
     sector_t*	sector;
     fixed_t	oldx;
     fixed_t	oldy;
@@ -70,63 +69,52 @@ EV_Teleport
     if (side == 1)		
 	return 0;	
 
-    
+    // The destination is the first teleportman, in thinker
+    //  order, of the first sector with the tag.
     tag = line->tag;
-    for (i = 0; i < numsectors; i++)
+    dest = NULL;
+    for (m = mobjtypehead[MT_TELEPORTMAN] ; m ; m = m->tnext)
     {
-	if (sectors[ i ].tag == tag )
-	{
-	    thinker = thinkercap.next;
-	    for (thinker = thinkercap.next;
-		 thinker != &thinkercap;
-		 thinker = thinker->next)
-	    {
-		// not a mobj
-		if (thinker->function.acp1 != (actionf_p1)P_MobjThinker)
-		    continue;	
-
-		m = (mobj_t *)thinker;
-		
-		// not a teleportman
-		if (m->type != MT_TELEPORTMAN )
-		    continue;		
-
-		sector = m->subsector->sector;
-		// wrong sector
-		if (sector-sectors != i )
-		    continue;	
-
-		oldx = thing->x;
-		oldy = thing->y;
-		oldz = thing->z;
+	sector = m->subsector->sector;
+	// wrong sector
+	if (sector->tag != tag)
+	    continue;
+
+	if (!dest || sector < dest->subsector->sector)
+	    dest = m;
+    }
+
+    if (!dest)
+	return 0;
+    m = dest;
+
+    oldx = thing->x;
+    oldy = thing->y;
+    oldz = thing->z;
 				
-		if (!P_TeleportMove (thing, m->x, m->y))
-		    return 0;
+    if (!P_TeleportMove (thing, m->x, m->y))
+	return 0;
 		
-		thing->z = thing->floorz;  //fixme: not needed?
-		if (thing->player)
-		    thing->player->viewz = thing->z+thing->player->viewheight;
+    thing->z = thing->floorz;  //fixme: not needed?
+    if (thing->player)
+	thing->player->viewz = thing->z+thing->player->viewheight;
 				
-		// spawn teleport fog at source and destination
-		fog = P_SpawnMobj (oldx, oldy, oldz, MT_TFOG);
-		S_StartSound (fog, sfx_telept);
-		an = m->angle >> ANGLETOFINESHIFT;
-		fog = P_SpawnMobj (m->x+20*finecosine[an], m->y+20*finesine[an]
-				   , thing->z, MT_TFOG);
-
-		// emit sound, where?
-		S_StartSound (fog, sfx_telept);
+    // spawn teleport fog at source and destination
+    fog = P_SpawnMobj (oldx, oldy, oldz, MT_TFOG);
+    S_StartSound (fog, sfx_telept);
+    an = m->angle >> ANGLETOFINESHIFT;
+    fog = P_SpawnMobj (m->x+20*finecosine[an], m->y+20*finesine[an]
+		       , thing->z, MT_TFOG);
+
+    // emit sound, where?
+    S_StartSound (fog, sfx_telept);
 		
-		// don't move for a bit
-		if (thing->player)
-		    thing->reactiontime = 18;	
-
-		thing->angle = m->angle;
-		thing->momx = thing->momy = thing->momz = 0;
-		return 1;
-	    }	
-	}
-    }
-    return 0;
+    // don't move for a bit
+    if (thing->player)
+	thing->reactiontime = 18;	
+
+    thing->angle = m->angle;
+    thing->momx = thing->momy = thing->momz = 0;
+    return 1;
 }
 
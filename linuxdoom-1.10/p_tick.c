@@ -53,6 +53,7 @@ thinker_t	thinkercap;
 void P_InitThinkers (void)
 {
     thinkercap.prev = thinkercap.next  = &thinkercap;
+    P_InitMobjIndex ();
 }
 
 
@@ -44,14 +44,14 @@ rcsid[] = "$Id: r_bsp.c,v 1.4 1997/02/03 22:45:12 b1 Exp $";
 
 
 
-seg_t*		curline;
-side_t*		sidedef;
-line_t*		linedef;
-sector_t*	frontsector;
-sector_t*	backsector;
+VIEWLOCAL seg_t*		curline;
+VIEWLOCAL side_t*		sidedef;
+VIEWLOCAL line_t*		linedef;
+VIEWLOCAL sector_t*	frontsector;
+VIEWLOCAL sector_t*	backsector;
 
-drawseg_t	drawsegs[MAXDRAWSEGS];
-drawseg_t*	ds_p;
+VIEWLOCAL drawseg_t	drawsegs[MAXDRAWSEGS];
+VIEWLOCAL drawseg_t*	ds_p;
 
 
 void
@@ -88,8 +88,8 @@ typedef	struct
 #define MAXSEGS		32
 
 // newend is one past the last valid seg
-cliprange_t*	newend;
-cliprange_t	solidsegs[MAXSEGS];
+VIEWLOCAL cliprange_t*	newend;
+VIEWLOCAL cliprange_t	solidsegs[MAXSEGS];
 
 
 
@@ -264,12 +264,14 @@ void R_AddLine (seg_t*	line)
     angle_t		angle2;
     angle_t		span;
     angle_t		tspan;
+    segclip_t*		clip;
     
     curline = line;
+    clip = &segclips[line-segs];
 
     // OPTIMIZE: quickly reject orthogonal back sides.
-    angle1 = R_PointToAngle (line->v1->x, line->v1->y);
-    angle2 = R_PointToAngle (line->v2->x, line->v2->y);
+    angle1 = R_PointToAngle (clip->x1, clip->y1);
+    angle2 = R_PointToAngle (clip->x2, clip->y2);
     
     // Clip to view edges.
     // OPTIMIZE: make constant out of 2*clipangle (FIELDOFVIEW).
@@ -317,11 +319,13 @@ void R_AddLine (seg_t*	line)
     if (x1 == x2)
 	return;				
 	
-    backsector = line->backsector;
-
     // Single sided line?
-    if (!backsector)
+    if (clip->backsector == -1)
+    {
+	backsector = NULL;
 	goto clipsolid;		
+    }
+    backsector = &sectors[clip->backsector];
 
     // Closed door.
     if (backsector->ceilingheight <= frontsector->floorheight
@@ -341,7 +345,7 @@ void R_AddLine (seg_t*	line)
     if (backsector->ceilingpic == frontsector->ceilingpic
 	&& backsector->floorpic == frontsector->floorpic
 	&& backsector->lightlevel == frontsector->lightlevel
-	&& curline->sidedef->midtexture == 0)
+	&& sides[clip->sidedef].midtexture == 0)
     {
 	return;
     }
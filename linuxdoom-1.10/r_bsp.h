@@ -28,25 +28,25 @@
 #endif
 
 
-extern seg_t*		curline;
-extern side_t*		sidedef;
-extern line_t*		linedef;
-extern sector_t*	frontsector;
-extern sector_t*	backsector;
+extern VIEWLOCAL seg_t*		curline;
+extern VIEWLOCAL side_t*		sidedef;
+extern VIEWLOCAL line_t*		linedef;
+extern VIEWLOCAL sector_t*	frontsector;
+extern VIEWLOCAL sector_t*	backsector;
 
-extern int		rw_x;
-extern int		rw_stopx;
+extern VIEWLOCAL int		rw_x;
+extern VIEWLOCAL int		rw_stopx;
 
-extern boolean		segtextured;
+extern VIEWLOCAL boolean		segtextured;
 
 // false if the back side is the same plane
-extern boolean		markfloor;		
-extern boolean		markceiling;
+extern VIEWLOCAL boolean		markfloor;		
+extern VIEWLOCAL boolean		markceiling;
 
 extern boolean		skymap;
 
-extern drawseg_t	drawsegs[MAXDRAWSEGS];
-extern drawseg_t*	ds_p;
+extern VIEWLOCAL drawseg_t	drawsegs[MAXDRAWSEGS];
+extern VIEWLOCAL drawseg_t*	ds_p;
 
 extern lighttable_t**	hscalelight;
 extern lighttable_t**	vscalelight;
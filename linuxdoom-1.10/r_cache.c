@@ -0,0 +1,406 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Startup cache of the tables R_InitTextures, R_InitSpriteLumps
+//	and R_InitSpriteDefs build from TEXTURE1/TEXTURE2, PNAMES,
+//	every patch header and every sprite header.
+//	The cache is one file, mapped on the next start; the tables
+//	point straight into the mapping, only pointer arrays and the
+//	composite cache are allocated. It is keyed by a hash of the
+//	lump directory plus size and date of every WAD, so any change
+//	to the WAD set rebuilds it.
+//	  -datacache file	use file instead of <default file>.cache
+//	  -nodatacache		neither read nor write it
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "m_argv.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+#include "r_state.h"
+#include "r_cache.h"
+
+
+#define DATACACHEID		"RDC1"
+#define DATACACHEVERSION	1
+
+
+typedef struct
+{
+    char		identification[4];	// DATACACHEID
+    int			version;
+    unsigned		key;
+    int			length;
+
+    // int ofs[], compositesize[], widthmask[], height[]
+    //  then per texture: texture_t, collump[width], colofs[width]
+    int			numtextures;
+    int			texturesofs;
+
+    // fixed_t width[], offset[], topoffset[]
+    int			firstspritelump;
+    int			numspritelumps;
+    int			spritelumpsofs;
+
+    // int name[], numframes[], framesofs[] then the frames
+    int			numsprites;
+    int			spritesofs;
+
+} datacache_t;
+
+
+static datacache_t*	datacache;
+static boolean		nodatacache;
+static char		datacachename[1024];
+
+// file image while saving
+static byte*		cachebuf;
+static int		cachelength;
+static int		cachealloc;
+
+
+
+//
+// R_DataCacheKey
+// FNV-1a over everything the tables are built from:
+//  the directory, and the size and time of every file.
+//
+static unsigned
+R_HashBytes
+( unsigned	key,
+  void*		data,
+  int		length )
+{
+    byte*	p;
+
+    for (p = data ; length-- ; p++)
+	key = (key ^ *p) * 16777619u;
+    return key;
+}
+
+
+extern char*	reloadname;
+
+static unsigned R_DataCacheKey (void)
+{
+    struct stat	fileinfo;
+    unsigned	key;
+    int		sizes[3];
+    int		lasthandle;
+    int		i;
+
+    sizes[0] = sizeof(texture_t);
+    sizes[1] = sizeof(texpatch_t);
+    sizes[2] = sizeof(spriteframe_t);
+
+    key = R_HashBytes (2166136261u, sizes, sizeof(sizes));
+    key = R_HashBytes (key, &modifiedgame, sizeof(modifiedgame));
+    key = R_HashBytes (key, &numlumps, sizeof(numlumps));
+
+    lasthandle = -2;
+    for (i=0 ; i<numlumps ; i++)
+    {
+	key = R_HashBytes (key, lumpinfo[i].name, 8);
+	key = R_HashBytes (key, &lumpinfo[i].position, sizeof(int));
+	key = R_HashBytes (key, &lumpinfo[i].size, sizeof(int));
+
+	if (lumpinfo[i].handle == lasthandle)
+	    continue;
+	lasthandle = lumpinfo[i].handle;
+
+	// the reloadable file has no handle, and changes
+	//  in place while the directory stays the same
+	if (lasthandle == -1
+	    ? !stat (reloadname, &fileinfo)
+	    : !fstat (lasthandle, &fileinfo))
+	{
+	    key = R_HashBytes (key, &fileinfo.st_size, sizeof(fileinfo.st_size));
+	    key = R_HashBytes (key, &fileinfo.st_mtime, sizeof(fileinfo.st_mtime));
+	}
+    }
+
+    return key;
+}
+
+
+
+//
+// R_LoadDataCache
+//
+boolean R_LoadDataCache (void)
+{
+    struct stat		fileinfo;
+    byte*		base;
+    int*		ofs;
+    int			handle;
+    int			width;
+    int			i;
+    int			p;
+
+    if (M_CheckParm ("-nodatacache"))
+    {
+	nodatacache = true;
+	return false;
+    }
+
+    p = M_CheckParm ("-datacache");
+    if (p && p < myargc-1)
+	sprintf (datacachename, "%.1000s", myargv[p+1]);
+    else
+	sprintf (datacachename, "%.1000s.cache", basedefault);
+
+    handle = open (datacachename, O_RDONLY);
+    if (handle == -1)
+	return false;
+
+    if (fstat (handle, &fileinfo) == -1
+	|| fileinfo.st_size < sizeof(datacache_t))
+    {
+	close (handle);
+	return false;
+    }
+
+    base = mmap (NULL, fileinfo.st_size, PROT_READ|PROT_WRITE,
+		 MAP_PRIVATE, handle, 0);
+    close (handle);
+    if (base == MAP_FAILED)
+	return false;
+
+    datacache = (datacache_t *)base;
+    if (strncmp (datacache->identification, DATACACHEID, 4)
+	|| datacache->version != DATACACHEVERSION
+	|| datacache->length != fileinfo.st_size
+	|| datacache->key != R_DataCacheKey ())
+    {
+	printf ("\nR_LoadDataCache: %s is stale", datacachename);
+	munmap (base, fileinfo.st_size);
+	datacache = NULL;
+	return false;
+    }
+
+    // Textures.
+    numtextures = datacache->numtextures;
+    ofs = (int *)(base + datacache->texturesofs);
+    texturecompositesize = ofs + numtextures;
+    texturewidthmask = ofs + numtextures*2;
+    textureheight = ofs + numtextures*3;
+
+    textures = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    texturecolumnlump = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    texturecolumnofs = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    texturecomposite = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    texturetranslation = Z_Malloc ((numtextures+1)*4, PU_STATIC, 0);
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	textures[i] = (texture_t *)(base + ofs[i]);
+	width = textures[i]->width;
+	texturecolumnlump[i] = (short *)((byte *)textures[i]
+					  + sizeof(texture_t)
+					  + sizeof(texpatch_t)
+					  *(textures[i]->patchcount-1));
+	texturecolumnofs[i] = (unsigned short *)(texturecolumnlump[i]+width);
+	texturecomposite[i] = 0;
+	texturetranslation[i] = i;
+    }
+
+    // Sprite lump sizes.
+    firstspritelump = datacache->firstspritelump;
+    numspritelumps = datacache->numspritelumps;
+    lastspritelump = firstspritelump + numspritelumps - 1;
+    spritewidth = (fixed_t *)(base + datacache->spritelumpsofs);
+    spriteoffset = spritewidth + numspritelumps;
+    spritetopoffset = spritewidth + numspritelumps*2;
+
+    return true;
+}
+
+
+//
+// R_LoadCachedSpriteDefs
+//
+boolean R_LoadCachedSpriteDefs (char** namelist)
+{
+    byte*	base;
+    int*	names;
+    int*	numframes;
+    int*	framesofs;
+    int		i;
+
+    if (!datacache)
+	return false;
+
+    base = (byte *)datacache;
+    names = (int *)(base + datacache->spritesofs);
+    numframes = names + datacache->numsprites;
+    framesofs = names + datacache->numsprites*2;
+
+    for (i=0 ; namelist[i] ; i++)
+	if (i >= datacache->numsprites || names[i] != *(int *)namelist[i])
+	    return false;
+    if (i != datacache->numsprites)
+	return false;
+
+    numsprites = i;
+    if (!numsprites)
+	return true;
+
+    sprites = Z_Malloc (numsprites*sizeof(*sprites), PU_STATIC, NULL);
+    for (i=0 ; i<numsprites ; i++)
+    {
+	sprites[i].numframes = numframes[i];
+	sprites[i].spriteframes = (spriteframe_t *)(base + framesofs[i]);
+    }
+
+    return true;
+}
+
+
+
+//
+// R_SaveDataCache
+//
+static int
+R_CacheWrite
+( void*		data,
+  int		length )
+{
+    int		ofs;
+
+    ofs = cachelength;
+    if (cachelength + length + 3 > cachealloc)
+    {
+	cachealloc = (cachelength + length + 3) * 2;
+	cachebuf = realloc (cachebuf, cachealloc);
+	if (!cachebuf)
+	    I_Error ("R_SaveDataCache: no memory for %i bytes", cachealloc);
+    }
+
+    memcpy (cachebuf + cachelength, data, length);
+    cachelength += length;
+    while (cachelength & 3)
+	cachebuf[cachelength++] = 0;
+    return ofs;
+}
+
+
+void R_SaveDataCache (char** namelist)
+{
+    datacache_t	header;
+    char	tempname[1040];
+    texture_t*	texture;
+    int*	ofs;
+    int		count;
+    int		i;
+    FILE*	f;
+
+    if (datacache || nodatacache || !*datacachename)
+	return;
+
+    memset (&header, 0, sizeof(header));
+    memcpy (header.identification, DATACACHEID, 4);
+    header.version = DATACACHEVERSION;
+    header.key = R_DataCacheKey ();
+
+    cachelength = 0;
+    R_CacheWrite (&header, sizeof(header));
+
+    // Textures, offsets filled in as the records go out.
+    header.numtextures = numtextures;
+    header.texturesofs = R_CacheWrite (texturecompositesize, numtextures*4);
+    R_CacheWrite (texturecompositesize, numtextures*4);
+    R_CacheWrite (texturewidthmask, numtextures*4);
+    R_CacheWrite (textureheight, numtextures*4);
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	texture = textures[i];
+	count = R_CacheWrite (texture, sizeof(texture_t)
+			      + sizeof(texpatch_t)*(texture->patchcount-1));
+	ofs = (int *)(cachebuf + header.texturesofs);
+	ofs[i] = count;
+	R_CacheWrite (texturecolumnlump[i], texture->width*2);
+	cachelength -= (texture->width*2) & 3;	// colofs follows directly
+	R_CacheWrite (texturecolumnofs[i], texture->width*2);
+    }
+
+    // Sprite lump sizes.
+    header.firstspritelump = firstspritelump;
+    header.numspritelumps = numspritelumps;
+    header.spritelumpsofs = R_CacheWrite (spritewidth, numspritelumps*4);
+    R_CacheWrite (spriteoffset, numspritelumps*4);
+    R_CacheWrite (spritetopoffset, numspritelumps*4);
+
+    // Sprite frames, names give the number of sprites.
+    header.numsprites = numsprites;
+    header.spritesofs = cachelength;
+    for (i=0 ; i<numsprites ; i++)
+	R_CacheWrite (namelist[i], 4);
+    for (i=0 ; i<numsprites ; i++)
+	R_CacheWrite (&sprites[i].numframes, 4);
+    for (i=0 ; i<numsprites ; i++)
+	R_CacheWrite (&i, 4);
+    for (i=0 ; i<numsprites ; i++)
+    {
+	count = R_CacheWrite (sprites[i].spriteframes,
+			      sprites[i].numframes*sizeof(spriteframe_t));
+	ofs = (int *)(cachebuf + header.spritesofs) + numsprites*2;
+	ofs[i] = count;
+    }
+
+    header.length = cachelength;
+    memcpy (cachebuf, &header, sizeof(header));
+
+    // Write and rename, so a crash never leaves half a cache.
+    sprintf (tempname, "%s.tmp", datacachename);
+    f = fopen (tempname, "wb");
+    if (!f)
+	return;
+    count = fwrite (cachebuf, 1, cachelength, f);
+    if (fclose (f) || count != cachelength
+	|| rename (tempname, datacachename))
+    {
+	remove (tempname);
+	printf ("R_SaveDataCache: couldn't write %s\n", datacachename);
+    }
+    else
+	printf ("R_SaveDataCache: %s, %i KB\n",
+		datacachename, cachelength>>10);
+
+    free (cachebuf);
+    cachebuf = NULL;
+    cachealloc = 0;
+}
@@ -0,0 +1,48 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Startup cache of the texture and sprite tables.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __R_CACHE__
+#define __R_CACHE__
+
+#include "doomtype.h"
+
+
+// Maps the cache file if it matches the loaded WADs,
+//  and sets up textures and sprite lump sizes from it.
+// Returns false if R_InitTextures etc. have to run.
+boolean R_LoadDataCache (void);
+
+// Sets up sprites from the cache, if it was loaded
+//  and was built for the same namelist.
+boolean R_LoadCachedSpriteDefs (char** namelist);
+
+// Called once all the tables are built.
+// Writes the cache file if it was not used.
+void R_SaveDataCache (char** namelist);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
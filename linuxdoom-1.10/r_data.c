@@ -27,6 +27,8 @@
 static const char
 rcsid[] = "$Id: r_data.c,v 1.4 1997/02/03 16:47:55 b1 Exp $";
 
+#include <pthread.h>
+
 #include "i_system.h"
 #include "z_zone.h"
 
@@ -40,6 +42,7 @@ rcsid[] = "$Id: r_data.c,v 1.4 1997/02/03 16:47:55 b1 Exp $";
 
 #include "doomstat.h"
 #include "r_sky.h"
+#include "r_cache.h"
 
 #ifdef LINUX
 #include  <alloca.h>
@@ -93,39 +96,6 @@ typedef struct
 } maptexture_t;
 
 
-// A single patch from a texture definition,
-//  basically a rectangular area within
-//  the texture rectangle.
-typedef struct
-{
-    // Block origin (allways UL),
-    // which has allready accounted
-    // for the internal origin of the patch.
-    int		originx;	
-    int		originy;
-    int		patch;
-} texpatch_t;
-
-
-// A maptexturedef_t describes a rectangular texture,
-//  which is composed of one or more mappatch_t structures
-//  that arrange graphic patches.
-typedef struct
-{
-    // Keep name for switch changing, etc.
-    char	name[8];		
-    short	width;
-    short	height;
-    
-    // All the patches[patchcount]
-    //  are drawn back to front into the cached texture.
-    short	patchcount;
-    texpatch_t	patches[1];		
-    
-} texture_t;
-
-
-
 int		firstflat;
 int		lastflat;
 int		numflats;
@@ -150,6 +120,10 @@ short**			texturecolumnlump;
 unsigned short**	texturecolumnofs;
 byte**			texturecomposite;
 
+// a pointer to each column, resolved for the level,
+//  NULL until R_TextureColumns
+byte***			texturecolumns;
+
 // for global animation
 int*		flattranslation;
 int*		texturetranslation;
@@ -241,8 +215,9 @@ void R_GenerateComposite (int texnum)
 	
     texture = textures[texnum];
 
+    // it stays with the column pointers until the level ends
     block = Z_Malloc (texturecompositesize[texnum],
-		      PU_STATIC, 
+		      PU_LEVEL, 
 		      &texturecomposite[texnum]);	
 
     collump = texturecolumnlump[texnum];
@@ -255,7 +230,8 @@ void R_GenerateComposite (int texnum)
 	 i<texture->patchcount;
 	 i++, patch++)
     {
-	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
+	// other textures may point into it
+	realpatch = W_MapLumpNum (patch->patch, PU_LEVEL);
 	x1 = patch->originx;
 	x2 = x1 + SHORT(realpatch->width);
 
@@ -282,10 +258,6 @@ void R_GenerateComposite (int texnum)
 	}
 						
     }
-
-    // Now that the texture has been built in column cache,
-    //  it is purgable from zone memory.
-    Z_ChangeTag (block, PU_CACHE);
 }
 
 
@@ -327,7 +299,7 @@ void R_GenerateLookup (int texnum)
 	 i<texture->patchcount;
 	 i++, patch++)
     {
-	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
+	realpatch = W_MapLumpNum (patch->patch, PU_CACHE);
 	x1 = patch->originx;
 	x2 = x1 + SHORT(realpatch->width);
 	
@@ -376,6 +348,106 @@ void R_GenerateLookup (int texnum)
 
 
 
+//
+// R_CacheLumpNum
+// W_MapLumpNum for the refresh.
+// Threads of R_RenderViews take turns at the zone,
+//  and what they load stays until the level ends,
+//  so no other view can purge it while in use.
+// Mapped lumps need neither.
+//
+static pthread_mutex_t	viewcachelock = PTHREAD_MUTEX_INITIALIZER;
+
+void*
+R_CacheLumpNum
+( int		lump,
+  int		tag )
+{
+    void*	data;
+
+    if (!viewthread || lumpinfo[lump].data)
+	return W_MapLumpNum (lump, tag);
+
+    pthread_mutex_lock (&viewcachelock);
+    data = W_CacheLumpNum (lump, PU_LEVEL);
+    pthread_mutex_unlock (&viewcachelock);
+    return data;
+}
+
+
+//
+// R_ResolveTexture
+// Everything the columns point into stays until the
+//  level ends, and so does the table. It is filled in
+//  before texturecolumns sees it, as other views may
+//  be reading texturecolumns without the lock.
+// The table has texturewidthmask+1 entries, wrapping
+//  around textures that are not a power of two wide.
+//
+static byte** R_ResolveTexture (int tex)
+{
+    texture_t*		texture;
+    byte**		columns;
+    byte**		building;
+    short*		collump;
+    unsigned short*	colofs;
+    byte*		data;
+    int			width;
+    int			x;
+
+    texture = textures[tex];
+    collump = texturecolumnlump[tex];
+    colofs = texturecolumnofs[tex];
+
+    if (texturecompositesize[tex] && !texturecomposite[tex])
+	R_GenerateComposite (tex);
+    else if (texturecomposite[tex])
+	Z_ChangeTag (texturecomposite[tex], PU_LEVEL);
+
+    width = texturewidthmask[tex]+1;
+    columns = Z_Malloc (width*sizeof(*columns), PU_LEVEL, &building);
+    for (x=0 ; x<texture->width ; x++)
+    {
+	if (collump[x] > 0)
+	    data = W_MapLumpNum (collump[x], PU_LEVEL);
+	else
+	    data = texturecomposite[tex];
+	columns[x] = data + colofs[x];
+    }
+    for ( ; x<width ; x++)
+	columns[x] = columns[x % texture->width];
+
+    // hand the block over to texturecolumns
+    Z_ChangeUser (columns, (void **)&texturecolumns[tex]);
+    __atomic_store_n (&texturecolumns[tex], columns, __ATOMIC_RELEASE);
+
+    return columns;
+}
+
+
+//
+// R_TextureColumns
+//
+byte** R_TextureColumns (int tex)
+{
+    byte**	columns;
+
+    columns = __atomic_load_n (&texturecolumns[tex], __ATOMIC_ACQUIRE);
+    if (columns)
+	return columns;
+
+    if (!viewthread)
+	return R_ResolveTexture (tex);
+
+    pthread_mutex_lock (&viewcachelock);
+    columns = texturecolumns[tex];
+    if (!columns)
+	columns = R_ResolveTexture (tex);
+    pthread_mutex_unlock (&viewcachelock);
+    return columns;
+}
+
+
 //
 // R_GetColumn
 //
@@ -384,20 +456,7 @@ R_GetColumn
 ( int		tex,
   int		col )
 {
-    int		lump;
-    int		ofs;
-	
-    col &= texturewidthmask[tex];
-    lump = texturecolumnlump[tex][col];
-    ofs = texturecolumnofs[tex][col];
-    
-    if (lump > 0)
-	return (byte *)W_CacheLumpNum(lump,PU_CACHE)+ofs;
-
-    if (!texturecomposite[tex])
-	R_GenerateComposite (tex);
-
-    return texturecomposite[tex] + ofs;
+    return R_TextureColumns (tex)[col & texturewidthmask[tex]];
 }
 
 
@@ -618,7 +677,7 @@ void R_InitSpriteLumps (void)
 	if (!(i&63))
 	    printf (".");
 
-	patch = W_CacheLumpNum (firstspritelump+i, PU_CACHE);
+	patch = W_MapLumpNum (firstspritelump+i, PU_CACHE);
 	spritewidth[i] = SHORT(patch->width)<<FRACBITS;
 	spriteoffset[i] = SHORT(patch->leftoffset)<<FRACBITS;
 	spritetopoffset[i] = SHORT(patch->topoffset)<<FRACBITS;
@@ -627,6 +686,59 @@ void R_InitSpriteLumps (void)
 
 
 
+//
+// R_ReloadLump
+// Called by G_HotReload for a lump that changed on disk,
+//  after W_PollReload dropped the old data.
+// Textures using a patch are composed again when next
+//  drawn, sprites get their new size and offsets.
+// Flats need nothing, they are cached as they are drawn.
+//
+void R_ReloadLump (int lump)
+{
+    texture_t*	texture;
+    patch_t*	patch;
+    int		i;
+    int		j;
+
+    if (!strncasecmp (lumpinfo[lump].name, "TEXTURE1", 8)
+	|| !strncasecmp (lumpinfo[lump].name, "TEXTURE2", 8)
+	|| !strncasecmp (lumpinfo[lump].name, "PNAMES", 8))
+    {
+	printf ("R_ReloadLump: restart to see new %.8s\n",
+		lumpinfo[lump].name);
+	return;
+    }
+
+    if (lump >= firstspritelump && lump <= lastspritelump)
+    {
+	i = lump - firstspritelump;
+	patch = W_MapLumpNum (lump, PU_CACHE);
+	spritewidth[i] = SHORT(patch->width)<<FRACBITS;
+	spriteoffset[i] = SHORT(patch->leftoffset)<<FRACBITS;
+	spritetopoffset[i] = SHORT(patch->topoffset)<<FRACBITS;
+	return;
+    }
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	texture = textures[i];
+	for (j=0 ; j<texture->patchcount ; j++)
+	    if (texture->patches[j].patch == lump)
+		break;
+	if (j == texture->patchcount)
+	    continue;
+
+	if (texturecolumns[i])
+	    Z_Free (texturecolumns[i]);
+	if (texturecomposite[i])
+	    Z_Free (texturecomposite[i]);
+	R_GenerateLookup (i);
+    }
+}
+
+
+
 //
 // R_InitColormaps
 //
@@ -653,14 +765,33 @@ void R_InitColormaps (void)
 //
 void R_InitData (void)
 {
-    R_InitTextures ();
-    printf ("\nInitTextures");
+    int		start;
+    int		cached;
+
+    start = I_GetTimeUS ();
+    cached = R_LoadDataCache ();
+    if (cached)
+	printf ("\nR_LoadDataCache: %i ms", (I_GetTimeUS () - start)/1000);
+    else
+    {
+	R_InitTextures ();
+	printf ("\nInitTextures: %i ms", (I_GetTimeUS () - start)/1000);
+    }
+    texturecolumns = Z_Malloc (numtextures*sizeof(*texturecolumns),
+			       PU_STATIC, 0);
+    memset (texturecolumns, 0, numtextures*sizeof(*texturecolumns));
+    start = I_GetTimeUS ();
     R_InitFlats ();
-    printf ("\nInitFlats");
-    R_InitSpriteLumps ();
-    printf ("\nInitSprites");
+    printf ("\nInitFlats: %i ms", (I_GetTimeUS () - start)/1000);
+    if (!cached)
+    {
+	start = I_GetTimeUS ();
+	R_InitSpriteLumps ();
+	printf ("\nInitSprites: %i ms", (I_GetTimeUS () - start)/1000);
+    }
+    start = I_GetTimeUS ();
     R_InitColormaps ();
-    printf ("\nInitColormaps");
+    printf ("\nInitColormaps: %i ms", (I_GetTimeUS () - start)/1000);
 }
 
 
@@ -755,32 +886,8 @@ void R_PrecacheLevel (void)
     thinker_t*		th;
     spriteframe_t*	sf;
 
-    if (demoplayback)
-	return;
-    
-    // Precache flats.
-    flatpresent = alloca(numflats);
-    memset (flatpresent,0,numflats);	
-
-    for (i=0 ; i<numsectors ; i++)
-    {
-	flatpresent[sectors[i].floorpic] = 1;
-	flatpresent[sectors[i].ceilingpic] = 1;
-    }
-	
-    flatmemory = 0;
-
-    for (i=0 ; i<numflats ; i++)
-    {
-	if (flatpresent[i])
-	{
-	    lump = firstflat + i;
-	    flatmemory += lumpinfo[lump].size;
-	    W_CacheLumpNum(lump, PU_CACHE);
-	}
-    }
-    
-    // Precache textures.
+    // Resolve textures, even for demos,
+    //  so no composite is built mid-frame.
     texturepresent = alloca(numtextures);
     memset (texturepresent,0, numtextures);
 	
@@ -811,7 +918,32 @@ void R_PrecacheLevel (void)
 	{
 	    lump = texture->patches[j].patch;
 	    texturememory += lumpinfo[lump].size;
-	    W_CacheLumpNum(lump , PU_CACHE);
+	}
+	R_TextureColumns (i);
+    }
+    
+    if (demoplayback)
+	return;
+    
+    // Precache flats.
+    flatpresent = alloca(numflats);
+    memset (flatpresent,0,numflats);	
+
+    for (i=0 ; i<numsectors ; i++)
+    {
+	flatpresent[sectors[i].floorpic] = 1;
+	flatpresent[sectors[i].ceilingpic] = 1;
+    }
+	
+    flatmemory = 0;
+
+    for (i=0 ; i<numflats ; i++)
+    {
+	if (flatpresent[i])
+	{
+	    lump = firstflat + i;
+	    flatmemory += lumpinfo[lump].size;
+	    W_MapLumpNum(lump, PU_CACHE);
 	}
     }
     
@@ -838,7 +970,7 @@ void R_PrecacheLevel (void)
 	    {
 		lump = firstspritelump + sf->lump[k];
 		spritememory += lumpinfo[lump].size;
-		W_CacheLumpNum(lump , PU_CACHE);
+		W_MapLumpNum(lump , PU_CACHE);
 	    }
 	}
     }
@@ -31,17 +31,77 @@
 #pragma interface
 #endif
 
+// A single patch from a texture definition,
+//  basically a rectangular area within
+//  the texture rectangle.
+typedef struct
+{
+    // Block origin (allways UL),
+    // which has allready accounted
+    // for the internal origin of the patch.
+    int		originx;	
+    int		originy;
+    int		patch;
+} texpatch_t;
+
+
+// A maptexturedef_t describes a rectangular texture,
+//  which is composed of one or more mappatch_t structures
+//  that arrange graphic patches.
+typedef struct
+{
+    // Keep name for switch changing, etc.
+    char	name[8];		
+    short	width;
+    short	height;
+    
+    // All the patches[patchcount]
+    //  are drawn back to front into the cached texture.
+    short	patchcount;
+    texpatch_t	patches[1];		
+    
+} texture_t;
+
+
+// Composed textures, see R_InitTextures.
+extern int		numtextures;
+extern texture_t**	textures;
+
+extern int*		texturewidthmask;
+extern int*		texturecompositesize;
+extern short**		texturecolumnlump;
+extern unsigned short**	texturecolumnofs;
+extern byte**		texturecomposite;
+extern byte***		texturecolumns;
+
+
 // Retrieve column data for span blitting.
 byte*
 R_GetColumn
 ( int		tex,
   int		col );
 
+// A pointer to each column of the texture, good until
+//  the level ends. Index with texturewidthmask.
+byte** R_TextureColumns (int tex);
+
+// Lumps for drawing, safe on the threads of R_RenderViews.
+void*
+R_CacheLumpNum
+( int		lump,
+  int		tag );
+
 
 // I/O, setting up the stuff.
 void R_InitData (void);
+void R_InitTextures (void);
+void R_InitFlats (void);
+void R_InitSpriteLumps (void);
 void R_PrecacheLevel (void);
 
+// A lump changed on disk, see G_HotReload.
+void R_ReloadLump (int lump);
+
 
 // Retrieval.
 // Floor/ceiling opaque texture tiles,
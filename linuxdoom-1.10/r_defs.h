@@ -108,33 +108,45 @@ typedef	struct
     short	special;
     short	tag;
 
-    // 0 = untraversed, 1,2 = sndlines -1
-    int		soundtraversed;
-
-    // thing that made a sound (or null)
-    mobj_t*	soundtarget;
-
-    // mapblock bounding box for height changes
-    int		blockbox[4];
-
-    // origin for any sounds played by the sector
-    degenmobj_t	soundorg;
-
     // if == validcount, already checked
     int		validcount;
 
+    int		linecount;
+
     // list of mobjs in sector
     mobj_t*	thinglist;
 
     // thinker_t for reversable actions
     void*	specialdata;
 
-    int			linecount;
     struct line_s**	lines;	// [linecount] size
     
 } sector_t;
 
 
+//
+// The rest of a sector, kept out of sector_t
+//  so the heights and flats that the refresh
+//  and movement clipping read pack densely.
+// sectorinfo[i] goes with sectors[i].
+//
+typedef struct
+{
+    // 0 = untraversed, 1,2 = sndlines -1
+    int		soundtraversed;
+
+    // thing that made a sound (or null)
+    mobj_t*	soundtarget;
+
+    // mapblock bounding box for height changes
+    int		blockbox[4];
+
+    // origin for any sounds played by the sector
+    degenmobj_t	soundorg;
+
+} sectorinfo_t;
+
+
 
 
 //
@@ -215,6 +227,33 @@ typedef struct line_s
 } line_t;
 
 
+//
+// What move clipping needs of a line, in
+//  lineclips[] beside lines[]. Built by
+//  P_LoadLineDefs, never changed.
+//
+typedef struct
+{
+    fixed_t	bbox[4];
+
+    // v1, and v2 - v1
+    fixed_t	x;
+    fixed_t	y;
+    fixed_t	dx;
+    fixed_t	dy;
+
+    // -1 for none
+    short	frontsector;
+    short	backsector;
+
+    byte	slopetype;
+
+    // ML_BLOCKING and ML_BLOCKMONSTERS only
+    byte	flags;
+    
+} lineclip_t;
+
+
 
 
 //
@@ -258,6 +297,26 @@ typedef struct
 } seg_t;
 
 
+//
+// What R_AddLine needs of a seg, in segclips[]
+//  beside segs[]. Built by P_LoadSegs, never
+//  changed. Sectors and sides are by number.
+//
+typedef struct
+{
+    fixed_t	x1;
+    fixed_t	y1;
+    fixed_t	x2;
+    fixed_t	y2;
+    angle_t	angle;
+
+    // -1 for one sided lines
+    short	backsector;
+    short	sidedef;
+    
+} segclip_t;
+
+
 
 //
 // BSP node.
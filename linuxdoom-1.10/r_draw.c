@@ -60,14 +60,17 @@ rcsid[] = "$Id: r_draw.c,v 1.4 1997/02/03 16:47:55 b1 Exp $";
 //
 
 
-byte*		viewimage; 
-int		viewwidth;
-int		scaledviewwidth;
-int		viewheight;
-int		viewwindowx;
-int		viewwindowy; 
-byte*		ylookup[MAXHEIGHT]; 
-int		columnofs[MAXWIDTH]; 
+// where R_InitBuffer puts the view, screens[0] if not set
+VIEWLOCAL byte*		viewbuffer;
+
+VIEWLOCAL byte*		viewimage; 
+VIEWLOCAL int		viewwidth;
+VIEWLOCAL int		scaledviewwidth;
+VIEWLOCAL int		viewheight;
+VIEWLOCAL int		viewwindowx;
+VIEWLOCAL int		viewwindowy; 
+VIEWLOCAL byte*		ylookup[MAXHEIGHT]; 
+VIEWLOCAL int		columnofs[MAXWIDTH]; 
 
 // Color tables for different players,
 //  translate a limited part to another
@@ -82,18 +85,18 @@ byte		translations[3][256];
 // R_DrawColumn
 // Source is the top of the column to scale.
 //
-lighttable_t*		dc_colormap; 
-int			dc_x; 
-int			dc_yl; 
-int			dc_yh; 
-fixed_t			dc_iscale; 
-fixed_t			dc_texturemid;
+VIEWLOCAL lighttable_t*		dc_colormap; 
+VIEWLOCAL int			dc_x; 
+VIEWLOCAL int			dc_yl; 
+VIEWLOCAL int			dc_yh; 
+VIEWLOCAL fixed_t			dc_iscale; 
+VIEWLOCAL fixed_t			dc_texturemid;
 
 // first pixel in a column (possibly virtual) 
-byte*			dc_source;		
+VIEWLOCAL byte*			dc_source;		
 
 // just for profiling 
-int			dccount;
+VIEWLOCAL int			dccount;
 
 //
 // A column is a vertical slice/span from a wall texture that,
@@ -271,7 +274,7 @@ int	fuzzoffset[FUZZTABLE] =
     FUZZOFF,FUZZOFF,-FUZZOFF,FUZZOFF,FUZZOFF,-FUZZOFF,FUZZOFF 
 }; 
 
-int	fuzzpos = 0; 
+VIEWLOCAL int	fuzzpos = 0; 
 
 
 //
@@ -379,7 +382,7 @@ void R_DrawFuzzColumn (void)
 //  of the BaronOfHell, the HellKnight, uses
 //  identical sprites, kinda brightened up.
 //
-byte*	dc_translation;
+VIEWLOCAL byte*	dc_translation;
 byte*	translationtables;
 
 void R_DrawTranslatedColumn (void) 
@@ -497,22 +500,22 @@ void R_InitTranslationTables (void)
 // In consequence, flats are not stored by column (like walls),
 //  and the inner loop has to step in texture space u and v.
 //
-int			ds_y; 
-int			ds_x1; 
-int			ds_x2;
+VIEWLOCAL int			ds_y; 
+VIEWLOCAL int			ds_x1; 
+VIEWLOCAL int			ds_x2;
 
-lighttable_t*		ds_colormap; 
+VIEWLOCAL lighttable_t*		ds_colormap; 
 
-fixed_t			ds_xfrac; 
-fixed_t			ds_yfrac; 
-fixed_t			ds_xstep; 
-fixed_t			ds_ystep;
+VIEWLOCAL fixed_t			ds_xfrac; 
+VIEWLOCAL fixed_t			ds_yfrac; 
+VIEWLOCAL fixed_t			ds_xstep; 
+VIEWLOCAL fixed_t			ds_ystep;
 
 // start of a 64*64 tile image 
-byte*			ds_source;	
+VIEWLOCAL byte*			ds_source;	
 
 // just for profiling
-int			dscount;
+VIEWLOCAL int			dscount;
 
 
 //
@@ -697,6 +700,7 @@ R_InitBuffer
 ( int		width,
   int		height ) 
 { 
+    byte*	base;
     int		i; 
 
     // Handle resize,
@@ -715,8 +719,9 @@ R_InitBuffer
 	viewwindowy = (SCREENHEIGHT-SBARHEIGHT-height) >> 1; 
 
     // Preclaculate all row offsets.
+    base = viewbuffer ? viewbuffer : screens[0];
     for (i=0 ; i<height ; i++) 
-	ylookup[i] = screens[0] + (i+viewwindowy)*SCREENWIDTH; 
+	ylookup[i] = base + (i+viewwindowy)*SCREENWIDTH; 
 } 
  
  
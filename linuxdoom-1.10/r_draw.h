@@ -29,15 +29,15 @@
 #endif
 
 
-extern lighttable_t*	dc_colormap;
-extern int		dc_x;
-extern int		dc_yl;
-extern int		dc_yh;
-extern fixed_t		dc_iscale;
-extern fixed_t		dc_texturemid;
+extern VIEWLOCAL lighttable_t*	dc_colormap;
+extern VIEWLOCAL int		dc_x;
+extern VIEWLOCAL int		dc_yl;
+extern VIEWLOCAL int		dc_yh;
+extern VIEWLOCAL fixed_t		dc_iscale;
+extern VIEWLOCAL fixed_t		dc_texturemid;
 
 // first pixel in a column
-extern byte*		dc_source;		
+extern VIEWLOCAL byte*		dc_source;		
 
 
 // The span blitting interface.
@@ -61,22 +61,22 @@ R_VideoErase
 ( unsigned	ofs,
   int		count );
 
-extern int		ds_y;
-extern int		ds_x1;
-extern int		ds_x2;
+extern VIEWLOCAL int		ds_y;
+extern VIEWLOCAL int		ds_x1;
+extern VIEWLOCAL int		ds_x2;
 
-extern lighttable_t*	ds_colormap;
+extern VIEWLOCAL lighttable_t*	ds_colormap;
 
-extern fixed_t		ds_xfrac;
-extern fixed_t		ds_yfrac;
-extern fixed_t		ds_xstep;
-extern fixed_t		ds_ystep;
+extern VIEWLOCAL fixed_t		ds_xfrac;
+extern VIEWLOCAL fixed_t		ds_yfrac;
+extern VIEWLOCAL fixed_t		ds_xstep;
+extern VIEWLOCAL fixed_t		ds_ystep;
 
 // start of a 64*64 tile image
-extern byte*		ds_source;		
+extern VIEWLOCAL byte*		ds_source;		
 
 extern byte*		translationtables;
-extern byte*		dc_translation;
+extern VIEWLOCAL byte*		dc_translation;
 
 
 // Span blitting for rows, floor/ceiling.
@@ -87,6 +87,9 @@ void 	R_DrawSpan (void);
 void 	R_DrawSpanLow (void);
 
 
+// Screen sized buffer R_InitBuffer sets the view up in.
+extern VIEWLOCAL byte*	viewbuffer;
+
 void
 R_InitBuffer
 ( int		width,
@@ -34,6 +34,7 @@ static const char rcsid[] = "$Id: r_main.c,v 1.5 1997/02/03 22:45:12 b1 Exp $";
 
 #include "doomdef.h"
 #include "d_net.h"
+#include "i_system.h"
 
 #include "m_bbox.h"
 
@@ -55,52 +56,58 @@ int			viewangleoffset;
 int			validcount = 1;		
 
 
-lighttable_t*		fixedcolormap;
-extern lighttable_t**	walllights;
+VIEWLOCAL lighttable_t*		fixedcolormap;
+extern VIEWLOCAL lighttable_t**	walllights;
 
-int			centerx;
-int			centery;
+VIEWLOCAL int			centerx;
+VIEWLOCAL int			centery;
 
-fixed_t			centerxfrac;
-fixed_t			centeryfrac;
-fixed_t			projection;
+VIEWLOCAL fixed_t			centerxfrac;
+VIEWLOCAL fixed_t			centeryfrac;
+VIEWLOCAL fixed_t			projection;
 
 // just for profiling purposes
-int			framecount;	
+VIEWLOCAL int			framecount;	
+VIEWLOCAL int			wallpixels;
+VIEWLOCAL int			walltime;
+VIEWLOCAL int			visiblesprites;
+VIEWLOCAL int			culledsprites;
+VIEWLOCAL int			spritesegchecks;
+VIEWLOCAL int			maskedtime;
 
-int			sscount;
-int			linecount;
-int			loopcount;
+VIEWLOCAL int			sscount;
+VIEWLOCAL int			linecount;
+VIEWLOCAL int			loopcount;
 
-fixed_t			viewx;
-fixed_t			viewy;
-fixed_t			viewz;
+VIEWLOCAL fixed_t			viewx;
+VIEWLOCAL fixed_t			viewy;
+VIEWLOCAL fixed_t			viewz;
 
-angle_t			viewangle;
+VIEWLOCAL angle_t			viewangle;
 
-fixed_t			viewcos;
-fixed_t			viewsin;
+VIEWLOCAL fixed_t			viewcos;
+VIEWLOCAL fixed_t			viewsin;
 
-player_t*		viewplayer;
+VIEWLOCAL player_t*		viewplayer;
 
 // 0 = high, 1 = low
-int			detailshift;	
+VIEWLOCAL int			detailshift;	
 
 //
 // precalculated math tables
 //
-angle_t			clipangle;
+VIEWLOCAL angle_t			clipangle;
 
 // The viewangletox[viewangle + FINEANGLES/4] lookup
 // maps the visible view angles to screen X coordinates,
 // flattening the arc to a flat projection plane.
 // There will be many angles mapped to the same X. 
-int			viewangletox[FINEANGLES/2];
+VIEWLOCAL int			viewangletox[FINEANGLES/2];
 
 // The xtoviewangleangle[] table maps a screen pixel
 // to the lowest viewangle that maps back to x ranges
 // from clipangle to -clipangle.
-angle_t			xtoviewangle[SCREENWIDTH+1];
+VIEWLOCAL angle_t			xtoviewangle[SCREENWIDTH+1];
 
 
 // UNUSED.
@@ -113,20 +120,23 @@ angle_t			xtoviewangle[SCREENWIDTH+1];
 fixed_t*		finecosine = &finesine[FINEANGLES/4];
 
 
-lighttable_t*		scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
-lighttable_t*		scalelightfixed[MAXLIGHTSCALE];
+VIEWLOCAL lighttable_t*		scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
+VIEWLOCAL lighttable_t*		scalelightfixed[MAXLIGHTSCALE];
 lighttable_t*		zlight[LIGHTLEVELS][MAXLIGHTZ];
 
 // bumped light from gun blasts
-int			extralight;			
+VIEWLOCAL int			extralight;			
 
+// set on the threads of R_RenderViews
+VIEWLOCAL boolean		viewthread;
 
 
-void (*colfunc) (void);
-void (*basecolfunc) (void);
-void (*fuzzcolfunc) (void);
-void (*transcolfunc) (void);
-void (*spanfunc) (void);
+
+VIEWLOCAL void (*colfunc) (void);
+VIEWLOCAL void (*basecolfunc) (void);
+VIEWLOCAL void (*fuzzcolfunc) (void);
+VIEWLOCAL void (*transcolfunc) (void);
+VIEWLOCAL void (*spanfunc) (void);
 
 
 
@@ -669,6 +679,21 @@ R_SetViewSize
 // R_ExecuteSetViewSize
 //
 void R_ExecuteSetViewSize (void)
+{
+    setsizeneeded = false;
+    R_SetupViewSize (setblocks, setdetail);
+}
+
+
+//
+// R_SetupViewSize
+// Builds the tables for a view window,
+//  for the thread that calls it.
+//
+void
+R_SetupViewSize
+( int		blocks,
+  int		detail )
 {
     fixed_t	cosadj;
     fixed_t	dy;
@@ -677,20 +702,18 @@ void R_ExecuteSetViewSize (void)
     int		level;
     int		startmap; 	
 
-    setsizeneeded = false;
-
-    if (setblocks == 11)
+    if (blocks == 11)
     {
 	scaledviewwidth = SCREENWIDTH;
 	viewheight = SCREENHEIGHT;
     }
     else
     {
-	scaledviewwidth = setblocks*32;
-	viewheight = (setblocks*168/10)&~7;
+	scaledviewwidth = blocks*32;
+	viewheight = (blocks*168/10)&~7;
     }
     
-    detailshift = setdetail;
+    detailshift = detail;
     viewwidth = scaledviewwidth>>detailshift;
 	
     centery = viewheight/2;
@@ -859,7 +882,6 @@ void R_SetupFrame (player_t* player)
 	fixedcolormap = 0;
 		
     framecount++;
-    validcount++;
 }
 
 
@@ -869,6 +891,8 @@ void R_SetupFrame (player_t* player)
 //
 void R_RenderPlayerView (player_t* player)
 {	
+    int		start;
+
     R_SetupFrame (player);
 
     // Clear buffers.
@@ -878,21 +902,29 @@ void R_RenderPlayerView (player_t* player)
     R_ClearSprites ();
     
     // check for new console commands.
-    NetUpdate ();
+    if (!viewthread)
+	NetUpdate ();
 
     // The head node is the last node output.
+    start = I_GetTimeUS ();
     R_RenderBSPNode (numnodes-1);
+    walltime += I_GetTimeUS () - start;
     
     // Check for new console commands.
-    NetUpdate ();
+    if (!viewthread)
+	NetUpdate ();
     
     R_DrawPlanes ();
     
     // Check for new console commands.
-    NetUpdate ();
+    if (!viewthread)
+	NetUpdate ();
     
+    start = I_GetTimeUS ();
     R_DrawMasked ();
+    maskedtime += I_GetTimeUS () - start;
 
     // Check for new console commands.
-    NetUpdate ();				
+    if (!viewthread)
+	NetUpdate ();				
 }
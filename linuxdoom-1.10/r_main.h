@@ -35,27 +35,37 @@
 //
 // POV related.
 //
-extern fixed_t		viewcos;
-extern fixed_t		viewsin;
+extern VIEWLOCAL fixed_t		viewcos;
+extern VIEWLOCAL fixed_t		viewsin;
 
-extern int		viewwidth;
-extern int		viewheight;
-extern int		viewwindowx;
-extern int		viewwindowy;
+extern VIEWLOCAL int		viewwidth;
+extern VIEWLOCAL int		viewheight;
+extern VIEWLOCAL int		viewwindowx;
+extern VIEWLOCAL int		viewwindowy;
 
 
 
-extern int		centerx;
-extern int		centery;
+extern VIEWLOCAL int		centerx;
+extern VIEWLOCAL int		centery;
 
-extern fixed_t		centerxfrac;
-extern fixed_t		centeryfrac;
-extern fixed_t		projection;
+extern VIEWLOCAL fixed_t		centerxfrac;
+extern VIEWLOCAL fixed_t		centeryfrac;
+extern VIEWLOCAL fixed_t		projection;
 
 extern int		validcount;
 
-extern int		linecount;
-extern int		loopcount;
+extern VIEWLOCAL int		framecount;
+extern VIEWLOCAL int		wallpixels;	// drawn by R_RenderSegLoop
+extern VIEWLOCAL int		walltime;	// us in R_RenderBSPNode
+extern VIEWLOCAL int		visiblesprites;	// things made vissprites
+extern VIEWLOCAL int		culledsprites;	// and things rejected
+extern VIEWLOCAL int		spritesegchecks; // drawsegs R_DrawSprite tried
+extern VIEWLOCAL int		maskedtime;	// us in R_DrawMasked
+extern VIEWLOCAL int		linecount;
+extern VIEWLOCAL int		loopcount;
+
+// True on the threads of R_RenderViews.
+extern VIEWLOCAL boolean	viewthread;
 
 
 //
@@ -74,12 +84,12 @@ extern int		loopcount;
 #define MAXLIGHTZ	       128
 #define LIGHTZSHIFT		20
 
-extern lighttable_t*	scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
-extern lighttable_t*	scalelightfixed[MAXLIGHTSCALE];
+extern VIEWLOCAL lighttable_t*	scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
+extern VIEWLOCAL lighttable_t*	scalelightfixed[MAXLIGHTSCALE];
 extern lighttable_t*	zlight[LIGHTLEVELS][MAXLIGHTZ];
 
-extern int		extralight;
-extern lighttable_t*	fixedcolormap;
+extern VIEWLOCAL int		extralight;
+extern VIEWLOCAL lighttable_t*	fixedcolormap;
 
 
 // Number of diminishing brightness levels.
@@ -90,18 +100,18 @@ extern lighttable_t*	fixedcolormap;
 // Blocky/low detail mode.
 //B remove this?
 //  0 = high, 1 = low
-extern	int		detailshift;	
+extern VIEWLOCAL int		detailshift;	
 
 
 //
 // Function pointers to switch refresh/drawing functions.
 // Used to select shadow mode etc.
 //
-extern void		(*colfunc) (void);
-extern void		(*basecolfunc) (void);
-extern void		(*fuzzcolfunc) (void);
+extern VIEWLOCAL void		(*colfunc) (void);
+extern VIEWLOCAL void		(*basecolfunc) (void);
+extern VIEWLOCAL void		(*fuzzcolfunc) (void);
 // No shadow effects on floors.
-extern void		(*spanfunc) (void);
+extern VIEWLOCAL void		(*spanfunc) (void);
 
 
 //
@@ -164,6 +174,9 @@ void R_Init (void);
 // Called by M_Responder.
 void R_SetViewSize (int blocks, int detail);
 
+// Sets up the view window tables of this thread at once.
+void R_SetupViewSize (int blocks, int detail);
+
 #endif
 //-----------------------------------------------------------------------------
 //
@@ -50,15 +50,15 @@ planefunction_t		ceilingfunc;
 
 // Here comes the obnoxious "visplane".
 #define MAXVISPLANES	128
-visplane_t		visplanes[MAXVISPLANES];
-visplane_t*		lastvisplane;
-visplane_t*		floorplane;
-visplane_t*		ceilingplane;
+VIEWLOCAL visplane_t		visplanes[MAXVISPLANES];
+VIEWLOCAL visplane_t*		lastvisplane;
+VIEWLOCAL visplane_t*		floorplane;
+VIEWLOCAL visplane_t*		ceilingplane;
 
 // ?
 #define MAXOPENINGS	SCREENWIDTH*64
-short			openings[MAXOPENINGS];
-short*			lastopening;
+VIEWLOCAL short			openings[MAXOPENINGS];
+VIEWLOCAL short*			lastopening;
 
 
 //
@@ -66,31 +66,31 @@ short*			lastopening;
 //  floorclip starts out SCREENHEIGHT
 //  ceilingclip starts out -1
 //
-short			floorclip[SCREENWIDTH];
-short			ceilingclip[SCREENWIDTH];
+VIEWLOCAL short			floorclip[SCREENWIDTH];
+VIEWLOCAL short			ceilingclip[SCREENWIDTH];
 
 //
 // spanstart holds the start of a plane span
 // initialized to 0 at start
 //
-int			spanstart[SCREENHEIGHT];
-int			spanstop[SCREENHEIGHT];
+VIEWLOCAL int			spanstart[SCREENHEIGHT];
+VIEWLOCAL int			spanstop[SCREENHEIGHT];
 
 //
 // texture mapping
 //
-lighttable_t**		planezlight;
-fixed_t			planeheight;
+VIEWLOCAL lighttable_t**		planezlight;
+VIEWLOCAL fixed_t			planeheight;
 
-fixed_t			yslope[SCREENHEIGHT];
-fixed_t			distscale[SCREENWIDTH];
-fixed_t			basexscale;
-fixed_t			baseyscale;
+VIEWLOCAL fixed_t			yslope[SCREENHEIGHT];
+VIEWLOCAL fixed_t			distscale[SCREENWIDTH];
+VIEWLOCAL fixed_t			basexscale;
+VIEWLOCAL fixed_t			baseyscale;
 
-fixed_t			cachedheight[SCREENHEIGHT];
-fixed_t			cacheddistance[SCREENHEIGHT];
-fixed_t			cachedxstep[SCREENHEIGHT];
-fixed_t			cachedystep[SCREENHEIGHT];
+VIEWLOCAL fixed_t			cachedheight[SCREENHEIGHT];
+VIEWLOCAL fixed_t			cacheddistance[SCREENHEIGHT];
+VIEWLOCAL fixed_t			cachedxstep[SCREENHEIGHT];
+VIEWLOCAL fixed_t			cachedystep[SCREENHEIGHT];
 
 
 
@@ -371,6 +371,7 @@ void R_DrawPlanes (void)
     int			x;
     int			stop;
     int			angle;
+    int			lump;
 				
 #ifdef RANGECHECK
     if (ds_p - drawsegs > MAXDRAWSEGS)
@@ -420,9 +421,8 @@ void R_DrawPlanes (void)
 	}
 	
 	// regular flat
-	ds_source = W_CacheLumpNum(firstflat +
-				   flattranslation[pl->picnum],
-				   PU_STATIC);
+	lump = firstflat + flattranslation[pl->picnum];
+	ds_source = R_CacheLumpNum(lump, PU_STATIC);
 	
 	planeheight = abs(pl->height-viewz);
 	light = (pl->lightlevel >> LIGHTSEGSHIFT)+extralight;
@@ -448,6 +448,7 @@ void R_DrawPlanes (void)
 			pl->bottom[x]);
 	}
 	
-	Z_ChangeTag (ds_source, PU_CACHE);
+	if (!viewthread && !lumpinfo[lump].data)
+	    Z_ChangeTag (ds_source, PU_CACHE);
     }
 }
@@ -32,7 +32,7 @@
 
 
 // Visplane related.
-extern  short*		lastopening;
+extern VIEWLOCAL short*		lastopening;
 
 
 typedef void (*planefunction_t) (int top, int bottom);
@@ -40,11 +40,11 @@ typedef void (*planefunction_t) (int top, int bottom);
 extern planefunction_t	floorfunc;
 extern planefunction_t	ceilingfunc_t;
 
-extern short		floorclip[SCREENWIDTH];
-extern short		ceilingclip[SCREENWIDTH];
+extern VIEWLOCAL short		floorclip[SCREENWIDTH];
+extern VIEWLOCAL short		ceilingclip[SCREENWIDTH];
 
-extern fixed_t		yslope[SCREENHEIGHT];
-extern fixed_t		distscale[SCREENWIDTH];
+extern VIEWLOCAL fixed_t		yslope[SCREENHEIGHT];
+extern VIEWLOCAL fixed_t		distscale[SCREENWIDTH];
 
 void R_InitPlanes (void);
 void R_ClearPlanes (void);
@@ -43,56 +43,64 @@ rcsid[] = "$Id: r_segs.c,v 1.3 1997/01/29 20:10:19 b1 Exp $";
 // OPTIMIZE: closed two sided lines as single sided
 
 // True if any of the segs textures might be visible.
-boolean		segtextured;	
+VIEWLOCAL boolean		segtextured;	
 
 // False if the back side is the same plane.
-boolean		markfloor;	
-boolean		markceiling;
+VIEWLOCAL boolean		markfloor;	
+VIEWLOCAL boolean		markceiling;
 
-boolean		maskedtexture;
-int		toptexture;
-int		bottomtexture;
-int		midtexture;
+VIEWLOCAL boolean		maskedtexture;
+VIEWLOCAL int		toptexture;
+VIEWLOCAL int		bottomtexture;
+VIEWLOCAL int		midtexture;
 
+// column pointers of the textures above, see R_TextureColumns
+VIEWLOCAL byte**		topcolumns;
+VIEWLOCAL byte**		bottomcolumns;
+VIEWLOCAL byte**		midcolumns;
+VIEWLOCAL int		topmask;
+VIEWLOCAL int		bottommask;
+VIEWLOCAL int		midmask;
 
-angle_t		rw_normalangle;
+
+VIEWLOCAL angle_t		rw_normalangle;
 // angle to line origin
-int		rw_angle1;	
+VIEWLOCAL int		rw_angle1;	
 
 //
 // regular wall
 //
-int		rw_x;
-int		rw_stopx;
-angle_t		rw_centerangle;
-fixed_t		rw_offset;
-fixed_t		rw_distance;
-fixed_t		rw_scale;
-fixed_t		rw_scalestep;
-fixed_t		rw_midtexturemid;
-fixed_t		rw_toptexturemid;
-fixed_t		rw_bottomtexturemid;
+VIEWLOCAL int		rw_x;
+VIEWLOCAL int		rw_stopx;
+VIEWLOCAL angle_t		rw_centerangle;
+VIEWLOCAL fixed_t		rw_offset;
+VIEWLOCAL fixed_t		rw_distance;
+VIEWLOCAL fixed_t		rw_scale;
+VIEWLOCAL fixed_t		rw_scalestep;
+VIEWLOCAL fixed_t		rw_midtexturemid;
+VIEWLOCAL fixed_t		rw_toptexturemid;
+VIEWLOCAL fixed_t		rw_bottomtexturemid;
 
-int		worldtop;
-int		worldbottom;
-int		worldhigh;
-int		worldlow;
+VIEWLOCAL int		worldtop;
+VIEWLOCAL int		worldbottom;
+VIEWLOCAL int		worldhigh;
+VIEWLOCAL int		worldlow;
 
-fixed_t		pixhigh;
-fixed_t		pixlow;
-fixed_t		pixhighstep;
-fixed_t		pixlowstep;
+VIEWLOCAL fixed_t		pixhigh;
+VIEWLOCAL fixed_t		pixlow;
+VIEWLOCAL fixed_t		pixhighstep;
+VIEWLOCAL fixed_t		pixlowstep;
 
-fixed_t		topfrac;
-fixed_t		topstep;
+VIEWLOCAL fixed_t		topfrac;
+VIEWLOCAL fixed_t		topstep;
 
-fixed_t		bottomfrac;
-fixed_t		bottomstep;
+VIEWLOCAL fixed_t		bottomfrac;
+VIEWLOCAL fixed_t		bottomstep;
 
 
-lighttable_t**	walllights;
+VIEWLOCAL lighttable_t**	walllights;
 
-short*		maskedtexturecol;
+VIEWLOCAL short*		maskedtexturecol;
 
 
 
@@ -283,7 +291,8 @@ void R_RenderSegLoop (void)
 	    dc_yl = yl;
 	    dc_yh = yh;
 	    dc_texturemid = rw_midtexturemid;
-	    dc_source = R_GetColumn(midtexture,texturecolumn);
+	    dc_source = midcolumns[texturecolumn & midmask];
+	    wallpixels += dc_yh - dc_yl + 1;
 	    colfunc ();
 	    ceilingclip[rw_x] = viewheight;
 	    floorclip[rw_x] = -1;
@@ -305,7 +314,8 @@ void R_RenderSegLoop (void)
 		    dc_yl = yl;
 		    dc_yh = mid;
 		    dc_texturemid = rw_toptexturemid;
-		    dc_source = R_GetColumn(toptexture,texturecolumn);
+		    dc_source = topcolumns[texturecolumn & topmask];
+		    wallpixels += dc_yh - dc_yl + 1;
 		    colfunc ();
 		    ceilingclip[rw_x] = mid;
 		}
@@ -334,8 +344,8 @@ void R_RenderSegLoop (void)
 		    dc_yl = mid;
 		    dc_yh = yh;
 		    dc_texturemid = rw_bottomtexturemid;
-		    dc_source = R_GetColumn(bottomtexture,
-					    texturecolumn);
+		    dc_source = bottomcolumns[texturecolumn & bottommask];
+		    wallpixels += dc_yh - dc_yl + 1;
 		    colfunc ();
 		    floorclip[rw_x] = mid;
 		}
@@ -381,6 +391,7 @@ R_StoreWallRange
     angle_t		distangle, offsetangle;
     fixed_t		vtop;
     int			lightnum;
+    segclip_t*		clip;
 
     // don't overflow and crash
     if (ds_p == &drawsegs[MAXDRAWSEGS])
@@ -391,21 +402,24 @@ R_StoreWallRange
 	I_Error ("Bad R_RenderWallRange: %i to %i", start , stop);
 #endif
     
+    clip = &segclips[curline-segs];
     sidedef = curline->sidedef;
     linedef = curline->linedef;
 
-    // mark the segment as visible for auto map
-    linedef->flags |= ML_MAPPED;
+    // mark the segment as visible for auto map,
+    //  only the console view does
+    if (!viewthread)
+	linedef->flags |= ML_MAPPED;
     
     // calculate rw_distance for scale calculation
-    rw_normalangle = curline->angle + ANG90;
+    rw_normalangle = clip->angle + ANG90;
     offsetangle = abs(rw_normalangle-rw_angle1);
     
     if (offsetangle > ANG90)
 	offsetangle = ANG90;
 
     distangle = ANG90 - offsetangle;
-    hyp = R_PointToDist (curline->v1->x, curline->v1->y);
+    hyp = R_PointToDist (clip->x1, clip->y1);
     sineval = finesine[distangle>>ANGLETOFINESHIFT];
     rw_distance = FixedMul (hyp, sineval);
 		
@@ -457,6 +471,8 @@ R_StoreWallRange
     {
 	// single sided line
 	midtexture = texturetranslation[sidedef->midtexture];
+	midcolumns = R_TextureColumns (midtexture);
+	midmask = texturewidthmask[midtexture];
 	// a single sided line is terminal, so it must mark ends
 	markfloor = markceiling = true;
 	if (linedef->flags & ML_DONTPEGBOTTOM)
@@ -571,6 +587,8 @@ R_StoreWallRange
 	{
 	    // top texture
 	    toptexture = texturetranslation[sidedef->toptexture];
+	    topcolumns = R_TextureColumns (toptexture);
+	    topmask = texturewidthmask[toptexture];
 	    if (linedef->flags & ML_DONTPEGTOP)
 	    {
 		// top of texture at top
@@ -590,6 +608,8 @@ R_StoreWallRange
 	{
 	    // bottom texture
 	    bottomtexture = texturetranslation[sidedef->bottomtexture];
+	    bottomcolumns = R_TextureColumns (bottomtexture);
+	    bottommask = texturewidthmask[bottomtexture];
 
 	    if (linedef->flags & ML_DONTPEGBOTTOM )
 	    {
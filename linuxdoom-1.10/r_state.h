@@ -51,9 +51,9 @@ extern fixed_t*		spritetopoffset;
 
 extern lighttable_t*	colormaps;
 
-extern int		viewwidth;
-extern int		scaledviewwidth;
-extern int		viewheight;
+extern VIEWLOCAL int		viewwidth;
+extern VIEWLOCAL int		scaledviewwidth;
+extern VIEWLOCAL int		viewheight;
 
 extern int		firstflat;
 
@@ -80,9 +80,13 @@ extern vertex_t*	vertexes;
 
 extern int		numsegs;
 extern seg_t*		segs;
+extern segclip_t*	segclips;
 
 extern int		numsectors;
 extern sector_t*	sectors;
+extern sectorinfo_t*	sectorinfo;
+
+#define SECTORINFO(sec)	(&sectorinfo[(sec)-sectors])
 
 extern int		numsubsectors;
 extern subsector_t*	subsectors;
@@ -92,6 +96,7 @@ extern node_t*		nodes;
 
 extern int		numlines;
 extern line_t*		lines;
+extern lineclip_t*	lineclips;
 
 extern int		numsides;
 extern side_t*		sides;
@@ -100,34 +105,34 @@ extern side_t*		sides;
 //
 // POV data.
 //
-extern fixed_t		viewx;
-extern fixed_t		viewy;
-extern fixed_t		viewz;
+extern VIEWLOCAL fixed_t		viewx;
+extern VIEWLOCAL fixed_t		viewy;
+extern VIEWLOCAL fixed_t		viewz;
 
-extern angle_t		viewangle;
-extern player_t*	viewplayer;
+extern VIEWLOCAL angle_t		viewangle;
+extern VIEWLOCAL player_t*	viewplayer;
 
 
 // ?
-extern angle_t		clipangle;
+extern VIEWLOCAL angle_t		clipangle;
 
-extern int		viewangletox[FINEANGLES/2];
-extern angle_t		xtoviewangle[SCREENWIDTH+1];
+extern VIEWLOCAL int		viewangletox[FINEANGLES/2];
+extern VIEWLOCAL angle_t		xtoviewangle[SCREENWIDTH+1];
 //extern fixed_t		finetangent[FINEANGLES/2];
 
-extern fixed_t		rw_distance;
-extern angle_t		rw_normalangle;
+extern VIEWLOCAL fixed_t		rw_distance;
+extern VIEWLOCAL angle_t		rw_normalangle;
 
 
 
 // angle to line origin
-extern int		rw_angle1;
+extern VIEWLOCAL int		rw_angle1;
 
 // Segs count?
-extern int		sscount;
+extern VIEWLOCAL int		sscount;
 
-extern visplane_t*	floorplane;
-extern visplane_t*	ceilingplane;
+extern VIEWLOCAL visplane_t*	floorplane;
+extern VIEWLOCAL visplane_t*	ceilingplane;
 
 
 #endif
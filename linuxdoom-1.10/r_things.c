@@ -28,6 +28,7 @@ rcsid[] = "$Id: r_things.c,v 1.5 1997/02/03 16:47:56 b1 Exp $";
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 #include "doomdef.h"
@@ -38,6 +39,7 @@ rcsid[] = "$Id: r_things.c,v 1.5 1997/02/03 16:47:56 b1 Exp $";
 #include "w_wad.h"
 
 #include "r_local.h"
+#include "r_cache.h"
 
 #include "doomstat.h"
 
@@ -71,15 +73,15 @@ typedef struct
 //  which increases counter clockwise (protractor).
 // There was a lot of stuff grabbed wrong, so I changed it...
 //
-fixed_t		pspritescale;
-fixed_t		pspriteiscale;
+VIEWLOCAL fixed_t		pspritescale;
+VIEWLOCAL fixed_t		pspriteiscale;
 
-lighttable_t**	spritelights;
+VIEWLOCAL lighttable_t**	spritelights;
 
 // constant arrays
 //  used for psprite clipping and initializing clipping
 short		negonearray[SCREENWIDTH];
-short		screenheightarray[SCREENWIDTH];
+VIEWLOCAL short		screenheightarray[SCREENWIDTH];
 
 
 //
@@ -286,9 +288,17 @@ void R_InitSpriteDefs (char** namelist)
 //
 // GAME FUNCTIONS
 //
-vissprite_t	vissprites[MAXVISSPRITES];
-vissprite_t*	vissprite_p;
-int		newvissprite;
+#define MINVISSPRITES	128
+
+VIEWLOCAL vissprite_t*	vissprites;
+VIEWLOCAL vissprite_t*	vissprite_p;
+static VIEWLOCAL int	numvissprites;
+VIEWLOCAL int		newvissprite;
+
+// The framecount each sector last had its things added,
+//  per thread, so views never share sector validcount.
+static VIEWLOCAL int*	sectorframe;
+static VIEWLOCAL int	numsectorframes;
 
 
 
@@ -299,13 +309,19 @@ int		newvissprite;
 void R_InitSprites (char** namelist)
 {
     int		i;
+    int		start;
 	
     for (i=0 ; i<SCREENWIDTH ; i++)
     {
 	negonearray[i] = -1;
     }
-	
-    R_InitSpriteDefs (namelist);
+
+    start = I_GetTimeUS ();
+    if (!R_LoadCachedSpriteDefs (namelist))
+	R_InitSpriteDefs (namelist);
+    printf ("R_InitSprites: %i ms\n", (I_GetTimeUS () - start)/1000);
+
+    R_SaveDataCache (namelist);
 }
 
 
@@ -317,18 +333,40 @@ void R_InitSprites (char** namelist)
 void R_ClearSprites (void)
 {
     vissprite_p = vissprites;
+
+    if (numsectorframes < numsectors)
+    {
+	// older framecounts can never match again
+	sectorframe = realloc (sectorframe, numsectors*sizeof(int));
+	if (!sectorframe)
+	    I_Error ("R_ClearSprites: no memory for %i sectors", numsectors);
+	memset (sectorframe+numsectorframes, 0,
+		(numsectors-numsectorframes)*sizeof(int));
+	numsectorframes = numsectors;
+    }
 }
 
 
 //
 // R_NewVisSprite
+// The store doubles when full. Nothing links
+//  vissprites before R_SortVisSprites, so they
+//  may move until then.
 //
-vissprite_t	overflowsprite;
-
 vissprite_t* R_NewVisSprite (void)
 {
-    if (vissprite_p == &vissprites[MAXVISSPRITES])
-	return &overflowsprite;
+    int		count;
+
+    if (vissprite_p == vissprites+numvissprites)
+    {
+	count = vissprite_p - vissprites;
+	numvissprites = numvissprites ? numvissprites*2 : MINVISSPRITES;
+	vissprites = realloc (vissprites, numvissprites*sizeof(vissprite_t));
+	if (!vissprites)
+	    I_Error ("R_NewVisSprite: no memory for %i sprites",
+		     numvissprites);
+	vissprite_p = vissprites+count;
+    }
     
     vissprite_p++;
     return vissprite_p-1;
@@ -342,11 +380,11 @@ vissprite_t* R_NewVisSprite (void)
 // Masked means: partly transparent, i.e. stored
 //  in posts/runs of opaque pixels.
 //
-short*		mfloorclip;
-short*		mceilingclip;
+VIEWLOCAL short*		mfloorclip;
+VIEWLOCAL short*		mceilingclip;
 
-fixed_t		spryscale;
-fixed_t		sprtopscreen;
+VIEWLOCAL fixed_t		spryscale;
+VIEWLOCAL fixed_t		sprtopscreen;
 
 void R_DrawMaskedColumn (column_t* column)
 {
@@ -405,7 +443,7 @@ R_DrawVisSprite
     patch_t*		patch;
 	
 	
-    patch = W_CacheLumpNum (vis->patch+firstspritelump, PU_CACHE);
+    patch = R_CacheLumpNum (vis->patch+firstspritelump, PU_CACHE);
 
     dc_colormap = vis->colormap;
     
@@ -447,19 +485,15 @@ R_DrawVisSprite
 //
 // R_ProjectSprite
 // Generates a vissprite for a thing
-//  if it might be visible.
+//  that R_CullSprites let through.
+// tx and tz are the thing's origin in view space.
 //
-void R_ProjectSprite (mobj_t* thing)
+void
+R_ProjectSprite
+( mobj_t*	thing,
+  fixed_t	tx,
+  fixed_t	tz )
 {
-    fixed_t		tr_x;
-    fixed_t		tr_y;
-    
-    fixed_t		gxt;
-    fixed_t		gyt;
-    
-    fixed_t		tx;
-    fixed_t		tz;
-
     fixed_t		xscale;
     
     int			x1;
@@ -479,29 +513,8 @@ void R_ProjectSprite (mobj_t* thing)
     angle_t		ang;
     fixed_t		iscale;
     
-    // transform the origin point
-    tr_x = thing->x - viewx;
-    tr_y = thing->y - viewy;
-	
-    gxt = FixedMul(tr_x,viewcos); 
-    gyt = -FixedMul(tr_y,viewsin);
-    
-    tz = gxt-gyt; 
-
-    // thing is behind view plane?
-    if (tz < MINZ)
-	return;
-    
     xscale = FixedDiv(projection, tz);
 	
-    gxt = -FixedMul(tr_x,viewsin); 
-    gyt = FixedMul(tr_y,viewcos); 
-    tx = -(gyt+gxt); 
-
-    // too far off the side?
-    if (abs(tx)>(tz<<2))
-	return;
-    
     // decide which patch to use for sprite relative to player
 #ifdef RANGECHECK
     if ((unsigned)thing->sprite >= numsprites)
@@ -537,16 +550,23 @@ void R_ProjectSprite (mobj_t* thing)
 
     // off the right side?
     if (x1 > viewwidth)
+    {
+	culledsprites++;
 	return;
+    }
     
     tx +=  spritewidth[lump];
     x2 = ((centerxfrac + FixedMul (tx,xscale) ) >>FRACBITS) - 1;
 
     // off the left side
     if (x2 < 0)
+    {
+	culledsprites++;
 	return;
+    }
     
     // store information in a vissprite
+    visiblesprites++;
     vis = R_NewVisSprite ();
     vis->mobjflags = thing->flags;
     vis->scale = xscale<<detailshift;
@@ -606,6 +626,61 @@ void R_ProjectSprite (mobj_t* thing)
 
 
 
+//
+// R_CullSprites
+// Transforms a batch of thing origins, relative to the view
+//  point, into view space, and drops those behind the view
+//  plane or too far off the side. The transform is straight
+//  line code over arrays, so the compiler can run it on
+//  vector units; only the survivors get R_ProjectSprite.
+// Returns how many are left, with their batch index in
+//  visible and their tx and tz packed to the front.
+//
+#define SPRITEBATCH	64
+
+int
+R_CullSprites
+( int		count,
+  fixed_t*	tr_x,
+  fixed_t*	tr_y,
+  fixed_t*	tx,
+  fixed_t*	tz,
+  int*		visible )
+{
+    fixed_t	bx[SPRITEBATCH];
+    fixed_t	bz[SPRITEBATCH];
+    int		keep[SPRITEBATCH];
+    int		left;
+    int		i;
+
+    // FixedMul, spelled out so the loop stays simple
+    for (i=0 ; i<count ; i++)
+    {
+	bz[i] = (fixed_t)(((long long)tr_x[i]*viewcos) >> FRACBITS)
+	    + (fixed_t)(((long long)tr_y[i]*viewsin) >> FRACBITS);
+	bx[i] = (fixed_t)(((long long)tr_x[i]*viewsin) >> FRACBITS)
+	    - (fixed_t)(((long long)tr_y[i]*viewcos) >> FRACBITS);
+    }
+
+    for (i=0 ; i<count ; i++)
+	keep[i] = (bz[i] >= MINZ) & (abs(bx[i]) <= (bz[i]<<2));
+
+    left = 0;
+    for (i=0 ; i<count ; i++)
+    {
+	visible[left] = i;
+	tx[left] = bx[i];
+	tz[left] = bz[i];
+	left += keep[i];
+    }
+
+    culledsprites += count-left;
+    return left;
+}
+
+
+
+
 //
 // R_AddSprites
 // During BSP traversal, this adds sprites by sector.
@@ -614,16 +689,24 @@ void R_AddSprites (sector_t* sec)
 {
     mobj_t*		thing;
     int			lightnum;
+    mobj_t*		things[SPRITEBATCH];
+    fixed_t		tr_x[SPRITEBATCH];
+    fixed_t		tr_y[SPRITEBATCH];
+    fixed_t		tx[SPRITEBATCH];
+    fixed_t		tz[SPRITEBATCH];
+    int			visible[SPRITEBATCH];
+    int			count;
+    int			i;
 
     // BSP is traversed by subsector.
     // A sector might have been split into several
     //  subsectors during BSP building.
     // Thus we check whether its already added.
-    if (sec->validcount == validcount)
+    if (sectorframe[sec-sectors] == framecount)
 	return;		
 
     // Well, now it will be done.
-    sec->validcount = validcount;
+    sectorframe[sec-sectors] = framecount;
 	
     lightnum = (sec->lightlevel >> LIGHTSEGSHIFT)+extralight;
 
@@ -634,9 +717,23 @@ void R_AddSprites (sector_t* sec)
     else
 	spritelights = scalelight[lightnum];
 
-    // Handle all things in sector.
-    for (thing = sec->thinglist ; thing ; thing = thing->snext)
-	R_ProjectSprite (thing);
+    // Handle all things in sector, a batch at a time.
+    thing = sec->thinglist;
+    while (thing)
+    {
+	for (count=0 ; thing && count<SPRITEBATCH ; thing=thing->snext)
+	{
+	    things[count] = thing;
+	    tr_x[count] = thing->x - viewx;
+	    tr_y[count] = thing->y - viewy;
+	    count++;
+	}
+
+	count = R_CullSprites (count, tr_x, tr_y, tx, tz, visible);
+
+	for (i=0 ; i<count ; i++)
+	    R_ProjectSprite (things[visible[i]], tx[i], tz[i]);
+    }
 }
 
 
@@ -781,7 +878,7 @@ void R_DrawPlayerSprites (void)
 //
 // R_SortVisSprites
 //
-vissprite_t	vsprsortedhead;
+VIEWLOCAL vissprite_t	vsprsortedhead;
 
 
 void R_SortVisSprites (void)
@@ -836,6 +933,46 @@ void R_SortVisSprites (void)
 
 
 
+//
+// DRAWSEG INDEX
+// For each span of 1<<DSBUCKETSHIFT columns, a bit for
+//  every drawseg with a silhouette or masked texture
+//  that reaches into it. A sprite ORs the spans it
+//  covers and visits only those drawsegs.
+//
+#define DSBUCKETSHIFT	4
+#define DSBUCKETS	((SCREENWIDTH+(1<<DSBUCKETSHIFT)-1)>>DSBUCKETSHIFT)
+#define DSWORDS		((MAXDRAWSEGS+63)/64)
+
+static VIEWLOCAL unsigned long long	dsbuckets[DSBUCKETS][DSWORDS];
+
+
+//
+// R_IndexDrawSegs
+// Once per frame, after the BSP walk.
+//
+static void R_IndexDrawSegs (void)
+{
+    drawseg_t*		ds;
+    int			i;
+    int			b;
+    int			b2;
+
+    memset (dsbuckets, 0, sizeof(dsbuckets));
+
+    for (ds=drawsegs ; ds<ds_p ; ds++)
+    {
+	if (!ds->silhouette && !ds->maskedtexturecol)
+	    continue;
+
+	i = ds - drawsegs;
+	b2 = ds->x2 >> DSBUCKETSHIFT;
+	for (b = ds->x1 >> DSBUCKETSHIFT ; b<=b2 ; b++)
+	    dsbuckets[b][i>>6] |= 1ull << (i&63);
+    }
+}
+
+
 //
 // R_DrawSprite
 //
@@ -844,21 +981,38 @@ void R_DrawSprite (vissprite_t* spr)
     drawseg_t*		ds;
     short		clipbot[SCREENWIDTH];
     short		cliptop[SCREENWIDTH];
+    unsigned long long	segs[DSWORDS];
     int			x;
     int			r1;
     int			r2;
+    int			b;
+    int			w;
     fixed_t		scale;
     fixed_t		lowscale;
     int			silhouette;
 		
     for (x = spr->x1 ; x<=spr->x2 ; x++)
 	clipbot[x] = cliptop[x] = -2;
+
+    // drawsegs that may overlap the sprite
+    for (w=0 ; w<DSWORDS ; w++)
+	segs[w] = 0;
+    for (b = spr->x1>>DSBUCKETSHIFT ; b <= spr->x2>>DSBUCKETSHIFT ; b++)
+	for (w=0 ; w<DSWORDS ; w++)
+	    segs[w] |= dsbuckets[b][w];
     
     // Scan drawsegs from end to start for obscuring segs.
     // The first drawseg that has a greater scale
     //  is the clip seg.
-    for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
+    for (w=DSWORDS-1 ; w>=0 ; w--)
+    while (segs[w])
     {
+	// highest index first
+	b = 63 - __builtin_clzll (segs[w]);
+	segs[w] &= ~(1ull << b);
+	ds = &drawsegs[w*64+b];
+	spritesegchecks++;
+
 	// determine if the drawseg obscures the sprite
 	if (ds->x1 > spr->x2
 	    || ds->x2 < spr->x1
@@ -964,6 +1118,8 @@ void R_DrawMasked (void)
 
     if (vissprite_p > vissprites)
     {
+	R_IndexDrawSegs ();
+
 	// draw all vissprites back to front
 	for (spr = vsprsortedhead.next ;
 	     spr != &vsprsortedhead ;
@@ -28,25 +28,24 @@
 #pragma interface
 #endif
 
-#define MAXVISSPRITES  	128
-
-extern vissprite_t	vissprites[MAXVISSPRITES];
-extern vissprite_t*	vissprite_p;
-extern vissprite_t	vsprsortedhead;
+// grows as needed, see R_NewVisSprite
+extern VIEWLOCAL vissprite_t*	vissprites;
+extern VIEWLOCAL vissprite_t*	vissprite_p;
+extern VIEWLOCAL vissprite_t	vsprsortedhead;
 
 // Constant arrays used for psprite clipping
 //  and initializing clipping.
 extern short		negonearray[SCREENWIDTH];
-extern short		screenheightarray[SCREENWIDTH];
+extern VIEWLOCAL short		screenheightarray[SCREENWIDTH];
 
 // vars for R_DrawMaskedColumn
-extern short*		mfloorclip;
-extern short*		mceilingclip;
-extern fixed_t		spryscale;
-extern fixed_t		sprtopscreen;
+extern VIEWLOCAL short*		mfloorclip;
+extern VIEWLOCAL short*		mceilingclip;
+extern VIEWLOCAL fixed_t		spryscale;
+extern VIEWLOCAL fixed_t		sprtopscreen;
 
-extern fixed_t		pspritescale;
-extern fixed_t		pspriteiscale;
+extern VIEWLOCAL fixed_t		pspritescale;
+extern VIEWLOCAL fixed_t		pspriteiscale;
 
 
 void R_DrawMaskedColumn (column_t* column);
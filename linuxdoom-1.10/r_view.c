@@ -0,0 +1,326 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Several views rendered at once, on threads.
+//	All refresh state that belongs to a view (view position,
+//	window tables, clip arrays, visplanes, drawsegs, vissprites
+//	and the column and span drawer inputs) is VIEWLOCAL, so
+//	every thread renders with its own copy; the console view
+//	keeps using the main thread's. Shared data is read only
+//	while views render, except the zone, which R_CacheLumpNum
+//	and R_TextureColumns lock.
+//	  -viewthreads n	threads to render on, default one
+//				per processor
+//	  -viewbench n [-viewframes f]
+//				time n spectator views, and the wall fill rate
+//	  -viewcrowd n		with n barrels around the start, to time
+//				sprite clipping
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "m_argv.h"
+
+#include "r_local.h"
+#include "r_view.h"
+
+
+#define MAXVIEWTHREADS	16
+
+
+static pthread_t	viewthreads[MAXVIEWTHREADS];
+static int		numviewthreads;
+
+// view_threads in the config file, 0 for one per processor
+int			viewthreadcount;
+
+// views of the current R_RenderViews call;
+//  thread n renders views n, n+numviewthreads, ...
+static viewcontext_t*	viewlist;
+static int		viewcount;
+static int		viewgeneration;
+static int		viewsdone;
+
+static pthread_mutex_t	viewlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	viewstart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	viewdone = PTHREAD_COND_INITIALIZER;
+
+// the window this thread's tables are set up for
+static VIEWLOCAL byte*	setupscreen;
+static VIEWLOCAL int	setupblocks;
+static VIEWLOCAL int	setupdetail;
+
+
+
+//
+// R_RenderView
+//
+static void R_RenderView (viewcontext_t* view)
+{
+    int		start;
+
+    if (view->screen != setupscreen
+	|| view->blocks != setupblocks
+	|| view->detail != setupdetail)
+    {
+	viewbuffer = view->screen;
+	R_SetupViewSize (view->blocks, view->detail);
+	setupscreen = view->screen;
+	setupblocks = view->blocks;
+	setupdetail = view->detail;
+    }
+
+    wallpixels = walltime = 0;
+    visiblesprites = culledsprites = 0;
+    maskedtime = spritesegchecks = 0;
+    start = I_GetTimeUS ();
+    R_RenderPlayerView (view->player);
+    view->time = I_GetTimeUS () - start;
+    view->wallpixels = wallpixels;
+    view->walltime = walltime;
+    view->visiblesprites = visiblesprites;
+    view->culledsprites = culledsprites;
+    view->maskedtime = maskedtime;
+    view->spritesegchecks = spritesegchecks;
+
+    view->windowx = viewwindowx;
+    view->windowy = viewwindowy;
+    view->windowwidth = scaledviewwidth;
+    view->windowheight = viewheight;
+}
+
+
+//
+// R_ViewThread
+//
+static void* R_ViewThread (void* arg)
+{
+    int		n;
+    int		generation;
+    int		i;
+
+    n = (int)(long)arg;
+    viewthread = true;
+
+    pthread_mutex_lock (&viewlock);
+    generation = viewgeneration;
+    while (1)
+    {
+	while (generation == viewgeneration)
+	    pthread_cond_wait (&viewstart, &viewlock);
+	generation = viewgeneration;
+	pthread_mutex_unlock (&viewlock);
+
+	for (i=n ; i<viewcount ; i+=numviewthreads)
+	    R_RenderView (&viewlist[i]);
+
+	pthread_mutex_lock (&viewlock);
+	if (++viewsdone == numviewthreads)
+	    pthread_cond_signal (&viewdone);
+    }
+    return NULL;
+}
+
+
+//
+// R_InitViewThreads
+//
+static void R_InitViewThreads (void)
+{
+    int		count;
+    int		p;
+
+    count = viewthreadcount;
+    if (count < 1)
+	count = sysconf (_SC_NPROCESSORS_ONLN);
+    p = M_CheckParm ("-viewthreads");
+    if (p && p < myargc-1)
+	count = atoi (myargv[p+1]);
+    if (count < 1)
+	count = 1;
+    if (count > MAXVIEWTHREADS)
+	count = MAXVIEWTHREADS;
+
+    for (numviewthreads=0 ; numviewthreads<count ; numviewthreads++)
+	if (pthread_create (&viewthreads[numviewthreads], NULL,
+			    R_ViewThread, (void *)(long)numviewthreads))
+	    I_Error ("R_InitViewThreads: can't start a thread");
+}
+
+
+//
+// R_RenderViews
+//
+void
+R_RenderViews
+( viewcontext_t*	views,
+  int			count )
+{
+    if (!numviewthreads)
+	R_InitViewThreads ();
+
+    pthread_mutex_lock (&viewlock);
+    viewlist = views;
+    viewcount = count;
+    viewsdone = 0;
+    viewgeneration++;
+    pthread_cond_broadcast (&viewstart);
+    while (viewsdone < numviewthreads)
+	pthread_cond_wait (&viewdone, &viewlock);
+    pthread_mutex_unlock (&viewlock);
+}
+
+
+
+//
+// R_ViewCrowd
+// A square of things centred on the console player.
+//
+mobj_t* P_SpawnMobj (fixed_t x, fixed_t y, fixed_t z, mobjtype_t type);
+
+static void R_ViewCrowd (int count)
+{
+    mobj_t*	mo;
+    int		side;
+    int		i;
+
+    mo = players[consoleplayer].mo;
+    for (side=1 ; side*side<count ; side++)
+	;
+    for (i=0 ; i<count ; i++)
+	P_SpawnMobj (mo->x + (i%side - side/2)*32*FRACUNIT,
+		     mo->y + (i/side - side/2)*32*FRACUNIT,
+		     MININT, MT_BARREL);	// ONFLOORZ
+}
+
+
+//
+// R_ViewBenchmark
+// Spectators stand on the console player's start,
+//  each looking another way.
+//
+void G_InitNew (skill_t skill, int episode, int map);
+
+void R_ViewBenchmark (int arg)
+{
+    viewcontext_t*	views;
+    player_t*		spectators;
+    mobj_t*		cameras;
+    int			count;
+    int			frames;
+    int			start;
+    int			serial;
+    int			parallel;
+    double		pixels;
+    double		time;
+    double		visible;
+    double		culled;
+    double		masked;
+    double		checks;
+    int			i;
+    int			f;
+    int			p;
+
+    count = atoi (myargv[arg+1]);
+    if (count < 1)
+	count = 1;
+    frames = 100;
+    p = M_CheckParm ("-viewframes");
+    if (p && p < myargc-1)
+	frames = atoi (myargv[p+1]);
+    if (frames < 1)
+	frames = 1;
+
+    G_InitNew (startskill, startepisode, startmap);
+    p = M_CheckParm ("-viewcrowd");
+    if (p && p < myargc-1)
+	R_ViewCrowd (atoi (myargv[p+1]));
+
+    views = malloc (count*sizeof(*views));
+    spectators = malloc (count*sizeof(*spectators));
+    cameras = malloc (count*sizeof(*cameras));
+    if (!views || !spectators || !cameras)
+	I_Error ("R_ViewBenchmark: no memory for %i views", count);
+
+    for (i=0 ; i<count ; i++)
+    {
+	cameras[i] = *players[consoleplayer].mo;
+	cameras[i].angle += (ANG180/count)*2*i;
+	spectators[i] = players[consoleplayer];
+	spectators[i].mo = &cameras[i];
+
+	views[i].player = &spectators[i];
+	views[i].screen = malloc (SCREENWIDTH*SCREENHEIGHT);
+	views[i].blocks = 11;
+	views[i].detail = 0;
+	if (!views[i].screen)
+	    I_Error ("R_ViewBenchmark: no memory for %i views", count);
+    }
+
+    // load everything once
+    R_RenderViews (views, count);
+
+    pixels = time = visible = culled = masked = checks = 0;
+    start = I_GetTimeUS ();
+    for (f=0 ; f<frames ; f++)
+	for (i=0 ; i<count ; i++)
+	{
+	    R_RenderViews (&views[i], 1);
+	    pixels += views[i].wallpixels;
+	    time += views[i].walltime;
+	    visible += views[i].visiblesprites;
+	    culled += views[i].culledsprites;
+	    masked += views[i].maskedtime;
+	    checks += views[i].spritesegchecks;
+	}
+    serial = I_GetTimeUS () - start;
+
+    start = I_GetTimeUS ();
+    for (f=0 ; f<frames ; f++)
+	R_RenderViews (views, count);
+    parallel = I_GetTimeUS () - start;
+
+    if (!parallel)
+	parallel = 1;
+    printf ("R_ViewBenchmark: %i views of %ix%i, %i frames, %i threads\n"
+	    "  one at a time %i us per frame, all at once %i us, %.2fx\n",
+	    count, SCREENWIDTH, SCREENHEIGHT, frames, numviewthreads,
+	    serial/frames, parallel/frames, (double)serial/parallel);
+    if (time)
+	printf ("  walls %i pixels per view, %.1f Mpixels/s one at a time\n",
+		(int)(pixels/(frames*count)), pixels/time);
+    printf ("  sprites %.1f visible, %.1f culled per view\n",
+	    visible/(frames*count), culled/(frames*count));
+    if (visible)
+	printf ("  masked pass %.1f us per view, %.1f drawsegs "
+		"checked per sprite\n",
+		masked/(frames*count), checks/visible);
+    exit (0);
+}
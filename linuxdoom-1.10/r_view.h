@@ -0,0 +1,89 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Several views rendered at once, on threads.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __R_VIEW__
+#define __R_VIEW__
+
+#include "d_player.h"
+
+
+//
+// One view, for split screen, spectators or thumbnails.
+// The player only needs mo, viewz, extralight,
+//  fixedcolormap and psprites filled in.
+//
+typedef struct
+{
+    player_t*	player;
+
+    // SCREENWIDTH*SCREENHEIGHT, laid out like screens[0]
+    byte*	screen;
+
+    // view window as screenblocks (3-11) and detailLevel
+    int		blocks;
+    int		detail;
+
+    // microseconds the last R_RenderViews took for it
+    int		time;
+
+    // of that, wall pixels drawn and microseconds
+    //  spent in the BSP walk that draws them
+    int		wallpixels;
+    int		walltime;
+
+    // things that became vissprites, and things culled
+    int		visiblesprites;
+    int		culledsprites;
+
+    // microseconds in R_DrawMasked, and drawsegs
+    //  R_DrawSprite looked at for clipping
+    int		maskedtime;
+    int		spritesegchecks;
+
+    // where in screen it was drawn, set by R_RenderViews
+    int		windowx;
+    int		windowy;
+    int		windowwidth;
+    int		windowheight;
+
+} viewcontext_t;
+
+
+// Renders all the views, returns when all are done.
+// The playsim must not run meanwhile.
+void
+R_RenderViews
+( viewcontext_t*	views,
+  int			count );
+
+// Called by startup code when -viewbench is given.
+// Times the views of -viewbench spectators
+//  rendered one after another and at once, and exits.
+void R_ViewBenchmark (int arg);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
@@ -115,6 +115,9 @@ int 		snd_SfxVolume = 15;
 // Maximum volume of music. Useless so far.
 int 		snd_MusicVolume = 15; 
 
+// Set for headless runs, no sound effects are started.
+boolean		nosfxparm;
+
 
 
 // whether songs are mus_paused
@@ -267,6 +270,8 @@ S_StartSoundAtVolume
   
   mobj_t*	origin = (mobj_t *) origin_p;
   
+  if (nosfxparm)
+    return;
   
   // Debug.
   /*fprintf( stderr,
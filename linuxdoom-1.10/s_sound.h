@@ -23,6 +23,7 @@
 #ifndef __S_SOUND__
 #define __S_SOUND__
 
+#include "doomtype.h"
 
 #ifdef __GNUG__
 #pragma interface
@@ -43,6 +44,10 @@ S_Init
 
 
 
+// Set for headless runs, no sound effects are started.
+extern boolean	nosfxparm;
+
+
 //
 // Per level startup code.
 // Kills playing sounds at start of level,
@@ -35,13 +35,20 @@ rcsid[] = "$Id: w_wad.c,v 1.5 1997/02/03 16:47:57 b1 Exp $";
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <alloca.h>
+#include <sys/mman.h>
+#include <sys/inotify.h>
+#include <stdio.h>
+#include <stdlib.h>
 #define O_BINARY		0
 #endif
 
+#include <zlib.h>
+
 #include "doomtype.h"
 #include "m_swap.h"
 #include "i_system.h"
 #include "z_zone.h"
+#include "m_argv.h"
 
 #ifdef __GNUG__
 #pragma implementation "w_wad.h"
@@ -63,6 +70,20 @@ int			numlumps;
 
 void**			lumpcache;
 
+// lumps read at least once, to tell purged ones
+//  read again from new ones
+static byte*		lumpread;
+
+// for W_ReadReport
+static int		lumpsread;
+static long long	diskbytes;
+static long long	unpackedbytes;
+static long long	readtime;
+
+// compressed bytes read at a time; a small lump is
+//  one read, a large one is unpacked as it streams in
+#define PACKEDCHUNK	16384
+
 
 #define strcmpi	strcasecmp
 
@@ -137,18 +158,200 @@ ExtractFileBase
 int			reloadlump;
 char*			reloadname;
 
+// lumps of the reloadable file
+static int		reloadcount;
 
-void W_AddFile (char *filename)
+
+//
+// W_MapFile
+// With -wadmap or wad_map set, the whole file is mapped
+//  read only and shared, so every process running on the
+//  same WADs uses one copy of the lumps in the page cache.
+// Returns NULL if not mapping.
+//
+boolean	wadmap;
+
+byte* W_MapFile (int handle)
+{
+    byte*	base;
+    int		length;
+
+    if (!wadmap && !M_CheckParm ("-wadmap"))
+	return NULL;
+
+    length = filelength (handle);
+    if (!length)
+	return NULL;
+
+    base = mmap (NULL, length, PROT_READ, MAP_SHARED, handle, 0);
+    if (base == MAP_FAILED)
+	return NULL;
+    return base;
+}
+
+
+//
+// W_ReadDirectory
+// Reads and checks the directory of a WAD file,
+//  so a damaged one fails here instead of in the
+//  level or texture setup.
+// Returns a malloced directory.
+//
+filelump_t*
+W_ReadDirectory
+( char*		filename,
+  int		handle,
+  int*		count )
 {
     wadinfo_t		header;
+    filelump_t*		lumps;
+    int			filesize;
+    int			length;
+    int			pos;
+    int			size;
+    int			i;
+
+    filesize = filelength (handle);
+    if (read (handle, &header, sizeof(header)) != sizeof(header))
+	I_Error ("W_AddFile: %s is too short for a WAD", filename);
+
+    if (strncmp(header.identification,"IWAD",4))
+    {
+	// Homebrew levels?
+	if (strncmp(header.identification,"PWAD",4))
+	{
+	    I_Error ("Wad file %s doesn't have IWAD "
+		     "or PWAD id\n", filename);
+	}
+	    
+	// ???modifiedgame = true;		
+    }
+    header.numlumps = LONG(header.numlumps);
+    header.infotableofs = LONG(header.infotableofs);
+
+    if (header.numlumps < 0
+	|| header.numlumps > filesize/sizeof(filelump_t)
+	|| header.infotableofs < sizeof(header)
+	|| header.infotableofs > filesize
+	                         - header.numlumps*sizeof(filelump_t))
+    {
+	I_Error ("W_AddFile: %s has a directory of %i lumps at %i, "
+		 "outside the file", filename,
+		 header.numlumps, header.infotableofs);
+    }
+
+    length = header.numlumps*sizeof(filelump_t);
+    lumps = malloc (length ? length : 1);
+    if (!lumps)
+	I_Error ("W_AddFile: no memory for the directory of %s",
+		 filename);
+
+    lseek (handle, header.infotableofs, SEEK_SET);
+    if (read (handle, lumps, length) != length)
+	I_Error ("W_AddFile: couldn't read the directory of %s",
+		 filename);
+
+    for (i=0 ; i<header.numlumps ; i++)
+    {
+	pos = LONG(lumps[i].filepos);
+	size = LONG(lumps[i].size);
+	if (pos < 0 || size < 0 || pos > filesize - size)
+	    I_Error ("W_AddFile: lump %i (%.8s) of %s is outside the file",
+		     i, lumps[i].name, filename);
+    }
+
+    *count = header.numlumps;
+    return lumps;
+}
+
+
+//
+// W_IsPacked
+//
+boolean W_IsPacked (int handle)
+{
+    char	id[4];
+
+    return pread (handle, id, 4, 0) == 4
+	&& !strncmp (id, PACKEDID, 4);
+}
+
+
+//
+// W_ReadPackedDirectory
+// As W_ReadDirectory, for a packed WAD.
+//
+packedlump_t*
+W_ReadPackedDirectory
+( char*		filename,
+  int		handle,
+  int*		count )
+{
+    wadinfo_t		header;
+    packedlump_t*	lumps;
+    int			filesize;
+    int			length;
+    int			pos;
+    int			size;
+    int			i;
+
+    filesize = filelength (handle);
+    if (pread (handle, &header, sizeof(header), 0) != sizeof(header))
+	I_Error ("W_AddFile: %s is too short for a WAD", filename);
+    header.numlumps = LONG(header.numlumps);
+    header.infotableofs = LONG(header.infotableofs);
+
+    if (header.numlumps < 0
+	|| header.numlumps > filesize/sizeof(packedlump_t)
+	|| header.infotableofs < sizeof(header)
+	|| header.infotableofs > filesize
+	                         - header.numlumps*sizeof(packedlump_t))
+    {
+	I_Error ("W_AddFile: %s has a directory of %i lumps at %i, "
+		 "outside the file", filename,
+		 header.numlumps, header.infotableofs);
+    }
+
+    length = header.numlumps*sizeof(packedlump_t);
+    lumps = malloc (length ? length : 1);
+    if (!lumps)
+	I_Error ("W_AddFile: no memory for the directory of %s",
+		 filename);
+
+    if (pread (handle, lumps, length, header.infotableofs) != length)
+	I_Error ("W_AddFile: couldn't read the directory of %s",
+		 filename);
+
+    for (i=0 ; i<header.numlumps ; i++)
+    {
+	pos = LONG(lumps[i].filepos);
+	size = LONG(lumps[i].packedsize);
+	if (!size)
+	    size = LONG(lumps[i].size);
+	if (pos < 0 || size < 0 || LONG(lumps[i].size) < 0
+	    || pos > filesize - size)
+	    I_Error ("W_AddFile: lump %i (%.8s) of %s is outside the file",
+		     i, lumps[i].name, filename);
+    }
+
+    *count = header.numlumps;
+    return lumps;
+}
+
+
+void W_AddFile (char *filename)
+{
     lumpinfo_t*		lump_p;
     unsigned		i;
     int			handle;
-    int			length;
     int			startlump;
+    int			count;
     filelump_t*		fileinfo;
+    filelump_t*		directory;
     filelump_t		singleinfo;
+    packedlump_t*	packed;
     int			storehandle;
+    byte*		mapped;
     
     // open the file and add to directory
 
@@ -168,6 +371,8 @@ void W_AddFile (char *filename)
 
     printf (" adding %s\n",filename);
     startlump = numlumps;
+    directory = NULL;
+    packed = NULL;
 	
     if (strcmpi (filename+strlen(filename)-3 , "wad" ) )
     {
@@ -178,28 +383,19 @@ void W_AddFile (char *filename)
 	ExtractFileBase (filename, singleinfo.name);
 	numlumps++;
     }
+    else if (W_IsPacked (handle))
+    {
+	// packed WAD, lumps are unpacked as they are read
+	packed = W_ReadPackedDirectory (filename, handle, &count);
+	fileinfo = NULL;
+	numlumps += count;
+    }
     else 
     {
 	// WAD file
-	read (handle, &header, sizeof(header));
-	if (strncmp(header.identification,"IWAD",4))
-	{
-	    // Homebrew levels?
-	    if (strncmp(header.identification,"PWAD",4))
-	    {
-		I_Error ("Wad file %s doesn't have IWAD "
-			 "or PWAD id\n", filename);
-	    }
-	    
-	    // ???modifiedgame = true;		
-	}
-	header.numlumps = LONG(header.numlumps);
-	header.infotableofs = LONG(header.infotableofs);
-	length = header.numlumps*sizeof(filelump_t);
-	fileinfo = alloca (length);
-	lseek (handle, header.infotableofs, SEEK_SET);
-	read (handle, fileinfo, length);
-	numlumps += header.numlumps;
+	directory = W_ReadDirectory (filename, handle, &count);
+	fileinfo = directory;
+	numlumps += count;
     }
 
     
@@ -212,14 +408,36 @@ void W_AddFile (char *filename)
     lump_p = &lumpinfo[startlump];
 	
     storehandle = reloadname ? -1 : handle;
+
+    // the reloadable file changes under us,
+    //  and packed lumps are no use mapped
+    mapped = reloadname || packed ? NULL : W_MapFile (handle);
 	
-    for (i=startlump ; i<numlumps ; i++,lump_p++, fileinfo++)
+    for (i=startlump ; i<numlumps ; i++,lump_p++)
     {
 	lump_p->handle = storehandle;
+	if (packed)
+	{
+	    lump_p->position = LONG(packed[i-startlump].filepos);
+	    lump_p->size = LONG(packed[i-startlump].size);
+	    lump_p->packedsize = LONG(packed[i-startlump].packedsize);
+	    lump_p->data = NULL;
+	    strncpy (lump_p->name, packed[i-startlump].name, 8);
+	    continue;
+	}
 	lump_p->position = LONG(fileinfo->filepos);
 	lump_p->size = LONG(fileinfo->size);
+	lump_p->packedsize = 0;
+	lump_p->data = mapped ? mapped + lump_p->position : NULL;
 	strncpy (lump_p->name, fileinfo->name, 8);
+	fileinfo++;
     }
+
+    if (reloadname && startlump == reloadlump)
+	reloadcount = numlumps - startlump;
+
+    free (directory);
+    free (packed);
 	
     if (reloadname)
 	close (handle);
@@ -250,6 +468,8 @@ void W_Reload (void)
 	I_Error ("W_Reload: couldn't open %s",reloadname);
 
     read (handle, &header, sizeof(header));
+    if (!strncmp (header.identification, PACKEDID, 4))
+	I_Error ("W_Reload: %s is packed", reloadname);
     lumpcount = LONG(header.numlumps);
     header.infotableofs = LONG(header.infotableofs);
     length = lumpcount*sizeof(filelump_t);
@@ -266,6 +486,7 @@ void W_Reload (void)
     {
 	if (lumpcache[i])
 	    Z_Free (lumpcache[i]);
+	lumpread[i] = 0;
 
 	lump_p->position = LONG(fileinfo->filepos);
 	lump_p->size = LONG(fileinfo->size);
@@ -276,6 +497,245 @@ void W_Reload (void)
 
 
 
+//
+// HOT RELOAD
+// The directory holding the reloadable file is watched
+//  with inotify. When the file is written, W_PollReload
+//  finds the lumps whose data differs from what was last
+//  read, by CRC, and replaces only those.
+//
+static int		reloadwatch = -1;
+static char*		reloadbase;	// file name inside the directory
+static unsigned*	reloadcrcs;
+static int*		reloadchanged;
+
+
+//
+// W_ReadReloadFile
+// Reads all of the reloadable file and checks its
+//  directory. Returns the malloced file, or NULL.
+//
+byte*
+W_ReadReloadFile
+( filelump_t**	directory,
+  int*		count )
+{
+    wadinfo_t*		header;
+    filelump_t*		lumps;
+    byte*		data;
+    int			handle;
+    int			length;
+    int			numfilelumps;
+    int			ofs;
+    int			i;
+
+    if ( (handle = open (reloadname,O_RDONLY | O_BINARY)) == -1)
+	return NULL;
+    length = filelength (handle);
+    data = malloc (length ? length : 1);
+    if (!data || read (handle, data, length) != length)
+    {
+	free (data);
+	close (handle);
+	return NULL;
+    }
+    close (handle);
+
+    // a save may be half written, so check all in signed ints
+    header = (wadinfo_t *)data;
+    if (length < (int)sizeof(*header)
+	|| (strncmp (header->identification, "IWAD", 4)
+	    && strncmp (header->identification, "PWAD", 4)))
+    {
+	free (data);
+	return NULL;
+    }
+
+    numfilelumps = LONG(header->numlumps);
+    ofs = LONG(header->infotableofs);
+    if (numfilelumps < 0
+	|| ofs < (int)sizeof(*header)
+	|| ofs > length
+	|| numfilelumps > (length - ofs)/(int)sizeof(filelump_t))
+    {
+	free (data);
+	return NULL;
+    }
+
+    lumps = (filelump_t *)(data + ofs);
+    for (i=0 ; i<numfilelumps ; i++)
+	if (LONG(lumps[i].filepos) < 0
+	    || LONG(lumps[i].size) < 0
+	    || LONG(lumps[i].filepos) > length - LONG(lumps[i].size))
+	{
+	    free (data);
+	    return NULL;
+	}
+
+    *directory = lumps;
+    *count = numfilelumps;
+    return data;
+}
+
+
+//
+// W_WatchReload
+//
+void W_WatchReload (void)
+{
+    filelump_t*		lumps;
+    byte*		data;
+    char*		dir;
+    char*		slash;
+    int			count;
+    int			i;
+
+    if (!reloadname || !reloadcount)
+	return;
+
+    data = W_ReadReloadFile (&lumps, &count);
+    if (!data || count != reloadcount)
+    {
+	free (data);
+	return;
+    }
+
+    reloadcrcs = malloc (count*sizeof(*reloadcrcs));
+    reloadchanged = malloc (count*sizeof(*reloadchanged));
+    if (!reloadcrcs || !reloadchanged)
+	I_Error ("W_WatchReload: no memory for %i lumps", count);
+    for (i=0 ; i<count ; i++)
+	reloadcrcs[i] = crc32 (0, data + LONG(lumps[i].filepos),
+			       LONG(lumps[i].size));
+    free (data);
+
+    dir = strdup (reloadname);
+    slash = strrchr (dir, '/');
+    if (slash)
+    {
+	*slash = 0;
+	reloadbase = slash+1;
+    }
+    else
+    {
+	reloadbase = dir;
+	dir = ".";
+    }
+
+    // editors save in place or write a new file and rename it
+    reloadwatch = inotify_init1 (IN_NONBLOCK);
+    if (reloadwatch == -1
+	|| inotify_add_watch (reloadwatch, *dir ? dir : "/",
+			      IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+    {
+	printf ("W_WatchReload: can't watch %s\n", reloadname);
+	if (reloadwatch != -1)
+	    close (reloadwatch);
+	reloadwatch = -1;
+	return;
+    }
+
+    printf ("W_WatchReload: watching %s\n", reloadname);
+}
+
+
+//
+// W_PollReload
+// Returns the number of lumps that changed, and sets
+//  *changed to a list of them. Data of theirs in the
+//  lump cache is freed, or read again in place where
+//  the block is held and the size did not change.
+//
+int W_PollReload (int** changed)
+{
+    union
+    {
+	struct inotify_event	event;
+	char			bytes[4096];
+    } buffer;
+    struct inotify_event*	event;
+    filelump_t*		lumps;
+    lumpinfo_t*		l;
+    memblock_t*		block;
+    byte*		data;
+    boolean		written;
+    unsigned		crc;
+    int			length;
+    int			count;
+    int			numchanged;
+    int			oldsize;
+    int			i;
+
+    if (reloadwatch == -1)
+	return 0;
+
+    written = false;
+    while ( (length = read (reloadwatch, &buffer, sizeof(buffer))) > 0)
+    {
+	for (i=0 ; i<length ; i += sizeof(*event) + event->len)
+	{
+	    event = (struct inotify_event *)(buffer.bytes + i);
+	    if (event->len && !strcmp (event->name, reloadbase))
+		written = true;
+	}
+    }
+    if (!written)
+	return 0;
+
+    data = W_ReadReloadFile (&lumps, &count);
+    if (!data)
+    {
+	printf ("W_PollReload: couldn't read %s\n", reloadname);
+	return 0;
+    }
+
+    for (i=0 ; i<count && i<reloadcount ; i++)
+	if (strncasecmp (lumpinfo[reloadlump+i].name, lumps[i].name, 8))
+	    break;
+    if (count != reloadcount || i < count)
+    {
+	printf ("W_PollReload: lumps of %s were added, removed or renamed, "
+		"restart to see it\n", reloadname);
+	free (data);
+	return 0;
+    }
+
+    numchanged = 0;
+    for (i=0 ; i<count ; i++)
+    {
+	l = &lumpinfo[reloadlump+i];
+	oldsize = l->size;
+	l->position = LONG(lumps[i].filepos);
+	l->size = LONG(lumps[i].size);
+
+	crc = crc32 (0, data + l->position, l->size);
+	if (crc == reloadcrcs[i] && l->size == oldsize)
+	    continue;
+	reloadcrcs[i] = crc;
+	reloadchanged[numchanged++] = reloadlump+i;
+	lumpread[reloadlump+i] = 0;
+
+	if (!lumpcache[reloadlump+i])
+	    continue;
+
+	block = (memblock_t *)((byte *)lumpcache[reloadlump+i]
+			       - sizeof(memblock_t));
+	if (block->tag >= PU_LEVEL)
+	    Z_Free (lumpcache[reloadlump+i]);
+	else if (l->size == oldsize)
+	    memcpy (lumpcache[reloadlump+i], data + l->position, l->size);
+	else
+	    printf ("W_PollReload: %.8s is in use and changed size, "
+		    "restart to see it\n", l->name);
+    }
+
+    free (data);
+    *changed = reloadchanged;
+    return numchanged;
+}
+
+
+
 //
 // W_InitMultipleFiles
 // Pass a null terminated list of files to use.
@@ -313,6 +773,12 @@ void W_InitMultipleFiles (char** filenames)
 	I_Error ("Couldn't allocate lumpcache");
 
     memset (lumpcache,0, size);
+
+    lumpread = calloc (numlumps, 1);
+    if (!lumpread)
+	I_Error ("Couldn't allocate lumpcache");
+
+    W_WatchReload ();
 }
 
 
@@ -423,6 +889,54 @@ int W_LumpLength (int lump)
 
 
 
+//
+// W_UnpackLump
+// Inflates a packed lump into dest, PACKEDCHUNK
+//  compressed bytes at a time.
+//
+void
+W_UnpackLump
+( lumpinfo_t*	l,
+  int		handle,
+  byte*		dest )
+{
+    byte	chunk[PACKEDCHUNK];
+    z_stream	zs;
+    int		position;
+    int		left;
+    int		c;
+    int		err;
+
+    memset (&zs, 0, sizeof(zs));
+    if (inflateInit (&zs) != Z_OK)
+	I_Error ("W_UnpackLump: inflateInit failed on %.8s", l->name);
+
+    zs.next_out = dest;
+    zs.avail_out = l->size;
+    position = l->position;
+    left = l->packedsize;
+    err = Z_OK;
+
+    while (left && err == Z_OK)
+    {
+	c = left < PACKEDCHUNK ? left : PACKEDCHUNK;
+	if (pread (handle, chunk, c, position) != c)
+	    I_Error ("W_UnpackLump: couldn't read %.8s", l->name);
+	position += c;
+	left -= c;
+
+	zs.next_in = chunk;
+	zs.avail_in = c;
+	err = inflate (&zs, Z_NO_FLUSH);
+    }
+
+    if (err != Z_STREAM_END || zs.total_out != l->size)
+	I_Error ("W_UnpackLump: %.8s is damaged", l->name);
+    inflateEnd (&zs);
+}
+
+
+
 //
 // W_ReadLump
 // Loads the lump into the given buffer,
@@ -436,6 +950,7 @@ W_ReadLump
     int		c;
     lumpinfo_t*	l;
     int		handle;
+    int		start;
 	
     if (lump >= numlumps)
 	I_Error ("W_ReadLump: %i >= numlumps",lump);
@@ -443,6 +958,7 @@ W_ReadLump
     l = lumpinfo+lump;
 	
     // ??? I_BeginRead ();
+    start = I_GetTimeUS ();
 	
     if (l->handle == -1)
     {
@@ -452,16 +968,30 @@ W_ReadLump
     }
     else
 	handle = l->handle;
-		
-    lseek (handle, l->position, SEEK_SET);
-    c = read (handle, dest, l->size);
 
-    if (c < l->size)
-	I_Error ("W_ReadLump: only read %i of %i on lump %i",
-		 c,l->size,lump);	
+    if (l->packedsize)
+    {
+	W_UnpackLump (l, handle, dest);
+	diskbytes += l->packedsize;
+    }
+    else
+    {
+	// pread leaves the shared file offset alone, as forked
+	//  G_AnalyzeDemos jobs read through the same handles
+	c = pread (handle, dest, l->size, l->position);
+
+	if (c < l->size)
+	    I_Error ("W_ReadLump: only read %i of %i on lump %i",
+		     c,l->size,lump);	
+	diskbytes += l->size;
+    }
 
     if (l->handle == -1)
 	close (handle);
+
+    lumpsread++;
+    unpackedbytes += l->size;
+    readtime += I_GetTimeUS () - start;
 		
     // ??? I_EndRead ();
 }
@@ -478,6 +1008,8 @@ W_CacheLumpNum
   int		tag )
 {
     byte*	ptr;
+    int		start;
+    memblock_t*	block;
 
     if ((unsigned)lump >= numlumps)
 	I_Error ("W_CacheLumpNum: %i >= numlumps",lump);
@@ -487,13 +1019,26 @@ W_CacheLumpNum
 	// read the lump in
 	
 	//printf ("cache miss on lump %i\n",lump);
+	start = I_GetTimeUS ();
 	ptr = Z_Malloc (W_LumpLength (lump), tag, &lumpcache[lump]);
 	W_ReadLump (lump, lumpcache[lump]);
+
+	if (lumpread[lump])
+	    Z_CountReread (lumpinfo[lump].size, I_GetTimeUS () - start);
+	lumpread[lump] = 1;
     }
     else
     {
 	//printf ("cache hit on lump %i\n",lump);
-	Z_ChangeTag (lumpcache[lump],tag);
+
+	// a patch the level took stays until it ends, as
+	//  column tables point into it; a PU_CACHE look
+	//  at its header, as R_GenerateLookup does on a
+	//  reload, must not make it purgable
+	block = (memblock_t *)((byte *)lumpcache[lump] - sizeof(memblock_t));
+	if (block->tag != PU_LEVEL || tag < PU_PURGELEVEL)
+	    Z_ChangeTag (lumpcache[lump],tag);
+	Z_Touch (lumpcache[lump]);
     }
 	
     return lumpcache[lump];
@@ -501,6 +1046,24 @@ W_CacheLumpNum
 
 
 
+//
+// W_MapLumpNum
+//
+void*
+W_MapLumpNum
+( int		lump,
+  int		tag )
+{
+    if ((unsigned)lump >= numlumps)
+	I_Error ("W_MapLumpNum: %i >= numlumps",lump);
+
+    if (lumpinfo[lump].data)
+	return lumpinfo[lump].data;
+    return W_CacheLumpNum (lump, tag);
+}
+
+
+
 //
 // W_CacheLumpName
 //
@@ -513,6 +1076,27 @@ W_CacheLumpName
 }
 
 
+//
+// W_ReadReport
+//
+void W_ReadReport (void)
+{
+    zonestats_t	stats;
+
+    if (!M_CheckParm ("-wadstats"))
+	return;
+
+    Z_GetStats (&stats);
+    printf ("W_ReadReport: %i lumps, %lli kB from disk, %lli kB unpacked, "
+	    "%lli ms\n"
+	    "  %i purged lumps read again (%i kB), %i hitches, "
+	    "%i purges\n",
+	    lumpsread, diskbytes/1024, unpackedbytes/1024, readtime/1000,
+	    stats.rereads, stats.rereadbytes/1024, stats.hitches,
+	    stats.purges);
+}
+
+
 //
 // W_Profile
 //
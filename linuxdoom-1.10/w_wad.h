@@ -23,6 +23,7 @@
 #ifndef __W_WAD__
 #define __W_WAD__
 
+#include "doomtype.h"
 
 #ifdef __GNUG__
 #pragma interface
@@ -50,6 +51,23 @@ typedef struct
     
 } filelump_t;
 
+//
+// Packed WAD the wadzip tool writes: a wadinfo_t with
+//  PACKEDID, lumps deflated with zlib where that saves
+//  space, and a directory of these.
+//
+#define PACKEDID		"ZWAD"
+
+typedef struct
+{
+    int			filepos;
+    int			size;		// unpacked
+    int			packedsize;	// on disk, 0 if stored
+    char		name[8];
+    
+} packedlump_t;
+
+
 //
 // WADFILE I/O related stuff.
 //
@@ -59,6 +77,10 @@ typedef struct
     int		handle;
     int		position;
     int		size;
+    int		packedsize;	// deflated bytes on disk, 0 if stored
+
+    // in the shared mapping of the file with -wadmap, else NULL
+    byte*	data;
 } lumpinfo_t;
 
 
@@ -69,6 +91,10 @@ extern	int		numlumps;
 void    W_InitMultipleFiles (char** filenames);
 void    W_Reload (void);
 
+// Lumps of the reloadable file that changed since last
+//  read, see G_HotReload.
+int	W_PollReload (int** changed);
+
 int	W_CheckNumForName (char* name);
 int	W_GetNumForName (char* name);
 
@@ -78,6 +104,17 @@ void    W_ReadLump (int lump, void *dest);
 void*	W_CacheLumpNum (int lump, int tag);
 void*	W_CacheLumpName (char* name, int tag);
 
+// W_CacheLumpNum for data that is only read.
+// With -wadmap, returns the file mapping all processes
+//  share, which must not be written, Z_ChangeTag'd or
+//  Z_Free'd.
+void*	W_MapLumpNum (int lump, int tag);
+
+// With -wadstats, prints the lumps read, the bytes read
+//  from disk and unpacked, and the time it took.
+// Called by I_Quit and at the end of a -timedemo.
+void	W_ReadReport (void);
+
 
 
 
@@ -0,0 +1,809 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	WAD validator, a standalone tool.
+//	  wadcheck [-j threads] file.wad|directory ...
+//	Checks the directory bounds, the lumps of every map and
+//	their cross references, TEXTURE1/TEXTURE2 against PNAMES,
+//	and that every sprite has complete frames, the same way
+//	P_SetupLevel, R_InitTextures and R_InitSpriteDefs would
+//	use them. WADs are checked in parallel, one per thread.
+//	Exits with 1 if any WAD has errors.
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "doomtype.h"
+#include "m_swap.h"
+#include "doomdata.h"
+#include "w_wad.h"
+
+
+#define MAXWADS		1024
+#define MAXTHREADS	64
+
+#define MAXSPRITES	1024
+#define MAXSPRFRAMES	29
+
+
+// On disk texture definitions, see r_data.c.
+// Sizes are spelled out, the structs there are not packed.
+#define MAPTEXTURESIZE	22	// name, masked, w, h, coldir, count
+#define MAPPATCHSIZE	10
+
+
+typedef struct
+{
+    char		name[8];
+    int			rotations[MAXSPRFRAMES];	// bit per rotation
+    int			maxframe;
+
+} checksprite_t;
+
+
+typedef struct
+{
+    char*		path;
+
+    byte*		data;
+    int			size;
+
+    filelump_t*		lumps;
+    int			numlumps;
+    boolean		iwad;
+
+    // texture names from TEXTURE1/TEXTURE2
+    char*		texnames;
+    int			numtextures;
+
+    // report, printed in order once every WAD is done
+    char*		report;
+    int			reportlength;
+    int			errors;
+    int			warnings;
+
+} wadcheck_t;
+
+
+static wadcheck_t	wads[MAXWADS];
+static int		numwads;
+static int		nextwad;
+static pthread_mutex_t	nextwadlock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+//
+// REPORTS
+//
+static void
+Report
+( wadcheck_t*	wad,
+  char*		kind,
+  char*		fmt,
+  ... )
+{
+    char	line[512];
+    int		length;
+    va_list	argptr;
+
+    length = sprintf (line, "%s: %s: ", wad->path, kind);
+    va_start (argptr, fmt);
+    length += vsnprintf (line+length, sizeof(line)-length-1, fmt, argptr);
+    va_end (argptr);
+    if (length > sizeof(line)-2)
+	length = sizeof(line)-2;
+    line[length++] = '\n';
+    line[length] = 0;
+
+    wad->report = realloc (wad->report, wad->reportlength+length+1);
+    memcpy (wad->report+wad->reportlength, line, length+1);
+    wad->reportlength += length;
+}
+
+#define Error(wad,...)	((wad)->errors++, Report(wad,"error",__VA_ARGS__))
+#define Warn(wad,...)	((wad)->warnings++, Report(wad,"warning",__VA_ARGS__))
+
+
+
+//
+// LUMP ACCESS
+//
+static int
+FindLump
+( wadcheck_t*	wad,
+  char*		name,
+  int		start,
+  int		stop )
+{
+    int		i;
+
+    for (i=start ; i<stop ; i++)
+	if (!strncasecmp (wad->lumps[i].name, name, 8))
+	    return i;
+    return -1;
+}
+
+static byte* LumpData (wadcheck_t* wad, int lump)
+{
+    return wad->data + LONG(wad->lumps[lump].filepos);
+}
+
+static int LumpSize (wadcheck_t* wad, int lump)
+{
+    return LONG(wad->lumps[lump].size);
+}
+
+
+
+//
+// DIRECTORY
+//
+static boolean CheckDirectory (wadcheck_t* wad)
+{
+    wadinfo_t*	header;
+    int		ofs;
+    int		pos;
+    int		size;
+    int		i;
+
+    if (wad->size < sizeof(wadinfo_t))
+    {
+	Error (wad, "too short for a WAD");
+	return false;
+    }
+
+    header = (wadinfo_t *)wad->data;
+    if (!strncmp (header->identification, "IWAD", 4))
+	wad->iwad = true;
+    else if (strncmp (header->identification, "PWAD", 4))
+    {
+	Error (wad, "no IWAD or PWAD id");
+	return false;
+    }
+
+    wad->numlumps = LONG(header->numlumps);
+    ofs = LONG(header->infotableofs);
+    if (wad->numlumps < 0
+	|| wad->numlumps > wad->size/sizeof(filelump_t)
+	|| ofs < sizeof(wadinfo_t)
+	|| ofs > wad->size - wad->numlumps*sizeof(filelump_t))
+    {
+	Error (wad, "directory of %i lumps at %i is outside the file",
+	       wad->numlumps, ofs);
+	return false;
+    }
+
+    wad->lumps = (filelump_t *)(wad->data + ofs);
+    for (i=0 ; i<wad->numlumps ; i++)
+    {
+	pos = LONG(wad->lumps[i].filepos);
+	size = LONG(wad->lumps[i].size);
+	if (pos < 0 || size < 0 || pos > wad->size - size)
+	{
+	    Error (wad, "lump %i (%.8s) at %i size %i is outside the file",
+		   i, wad->lumps[i].name, pos, size);
+	}
+    }
+
+    return !wad->errors;
+}
+
+
+
+//
+// TEXTURES
+//
+static void CheckTextureLump (wadcheck_t* wad, char* name, int numpnames)
+{
+    byte*	data;
+    byte*	tex;
+    int		lump;
+    int		size;
+    int		count;
+    int		ofs;
+    int		patches;
+    int		patch;
+    int		i;
+    int		j;
+
+    lump = FindLump (wad, name, 0, wad->numlumps);
+    if (lump == -1)
+	return;
+
+    data = LumpData (wad, lump);
+    size = LumpSize (wad, lump);
+    if (size < 4)
+    {
+	Error (wad, "%s is too short", name);
+	return;
+    }
+
+    count = LONG(*(int *)data);
+    if (count < 0 || count > (size-4)/4)
+    {
+	Error (wad, "%s has %i textures, too many for its size", name, count);
+	return;
+    }
+
+    wad->texnames = realloc (wad->texnames, (wad->numtextures+count)*8);
+    for (i=0 ; i<count ; i++)
+    {
+	ofs = LONG(((int *)data)[i+1]);
+	if (ofs < 0 || ofs > size - MAPTEXTURESIZE)
+	{
+	    Error (wad, "%s texture %i is outside the lump", name, i);
+	    continue;
+	}
+
+	tex = data + ofs;
+	memcpy (wad->texnames + wad->numtextures*8, tex, 8);
+	wad->numtextures++;
+
+	patches = SHORT(*(short *)(tex+20));
+	if (patches <= 0 || ofs + MAPTEXTURESIZE + patches*MAPPATCHSIZE > size)
+	{
+	    Error (wad, "%s texture %.8s has %i patches, outside the lump",
+		   name, tex, patches);
+	    continue;
+	}
+
+	for (j=0 ; j<patches ; j++)
+	{
+	    patch = SHORT(*(short *)(tex + MAPTEXTURESIZE
+				     + j*MAPPATCHSIZE + 4));
+	    if (patch < 0 || patch >= numpnames)
+		Error (wad, "%s texture %.8s uses patch %i of %i in PNAMES",
+		       name, tex, patch, numpnames);
+	}
+    }
+}
+
+
+static void CheckTextures (wadcheck_t* wad)
+{
+    byte*	names;
+    char	name[9];
+    int		lump;
+    int		numpnames;
+    int		i;
+
+    numpnames = 0;
+    lump = FindLump (wad, "PNAMES", 0, wad->numlumps);
+    if (lump != -1)
+    {
+	names = LumpData (wad, lump);
+	numpnames = LumpSize (wad, lump) >= 4 ? LONG(*(int *)names) : -1;
+	if (numpnames < 0 || numpnames > (LumpSize (wad, lump)-4)/8)
+	{
+	    Error (wad, "PNAMES has %i names, too many for its size",
+		   numpnames);
+	    numpnames = 0;
+	}
+
+	// patches may come from the IWAD when this is a PWAD
+	for (i=0 ; i<numpnames ; i++)
+	{
+	    memcpy (name, names+4+i*8, 8);
+	    name[8] = 0;
+	    if (FindLump (wad, name, 0, wad->numlumps) != -1)
+		continue;
+	    if (wad->iwad)
+		Error (wad, "PNAMES entry %i (%s) has no lump", i, name);
+	    else
+		Warn (wad, "PNAMES entry %i (%s) is not in this WAD", i, name);
+	}
+    }
+    else if (wad->iwad)
+	Error (wad, "no PNAMES");
+
+    CheckTextureLump (wad, "TEXTURE1", numpnames);
+    CheckTextureLump (wad, "TEXTURE2", numpnames);
+}
+
+
+static boolean IsTexture (wadcheck_t* wad, char* name)
+{
+    int		i;
+
+    if (name[0] == '-')
+	return true;
+
+    for (i=0 ; i<wad->numtextures ; i++)
+	if (!strncasecmp (wad->texnames+i*8, name, 8))
+	    return true;
+    return false;
+}
+
+
+
+//
+// MAPS
+//
+static char*	maplumpnames[] =
+{
+    NULL, "THINGS", "LINEDEFS", "SIDEDEFS", "VERTEXES", "SEGS",
+    "SSECTORS", "NODES", "SECTORS", "REJECT", "BLOCKMAP"
+};
+
+static int	maplumpsizes[] =
+{
+    0, sizeof(mapthing_t), sizeof(maplinedef_t), sizeof(mapsidedef_t),
+    sizeof(mapvertex_t), sizeof(mapseg_t), sizeof(mapsubsector_t),
+    sizeof(mapnode_t), sizeof(mapsector_t), 1, 2
+};
+
+
+static boolean IsMapName (char* name)
+{
+    if (name[0] == 'E' && name[2] == 'M'
+	&& isdigit (name[1]) && isdigit (name[3]) && !name[4])
+	return true;
+
+    if (!strncmp (name, "MAP", 3)
+	&& isdigit (name[3]) && isdigit (name[4]) && !name[5])
+	return true;
+
+    return false;
+}
+
+
+static void CheckMap (wadcheck_t* wad, int label)
+{
+    char		map[9];
+    int			count[ML_BLOCKMAP+1];
+    maplinedef_t*	ld;
+    mapsidedef_t*	sd;
+    mapseg_t*		seg;
+    mapsubsector_t*	ss;
+    mapnode_t*		node;
+    short*		bmap;
+    int			side;
+    int			child;
+    int			i;
+    int			j;
+
+    memcpy (map, wad->lumps[label].name, 8);
+    map[8] = 0;
+
+    if (label + ML_BLOCKMAP >= wad->numlumps)
+    {
+	Error (wad, "%s is missing map lumps", map);
+	return;
+    }
+
+    for (i=ML_THINGS ; i<=ML_BLOCKMAP ; i++)
+    {
+	if (strncasecmp (wad->lumps[label+i].name, maplumpnames[i], 8))
+	{
+	    Error (wad, "%s lump %i is %.8s, not %s", map, i,
+		   wad->lumps[label+i].name, maplumpnames[i]);
+	    return;
+	}
+	if (LumpSize (wad, label+i) % maplumpsizes[i])
+	    Error (wad, "%s %s size %i is not a multiple of %i", map,
+		   maplumpnames[i], LumpSize (wad, label+i), maplumpsizes[i]);
+	count[i] = LumpSize (wad, label+i) / maplumpsizes[i];
+    }
+
+    ld = (maplinedef_t *)LumpData (wad, label+ML_LINEDEFS);
+    for (i=0 ; i<count[ML_LINEDEFS] ; i++, ld++)
+    {
+	if ((unsigned short)SHORT(ld->v1) >= count[ML_VERTEXES]
+	    || (unsigned short)SHORT(ld->v2) >= count[ML_VERTEXES])
+	    Error (wad, "%s linedef %i has a bad vertex", map, i);
+
+	for (j=0 ; j<2 ; j++)
+	{
+	    side = SHORT(ld->sidenum[j]);
+	    if (side == -1 && j == 1)
+		continue;
+	    if (side < 0 || side >= count[ML_SIDEDEFS])
+		Error (wad, "%s linedef %i has bad sidedef %i", map, i, side);
+	}
+    }
+
+    sd = (mapsidedef_t *)LumpData (wad, label+ML_SIDEDEFS);
+    for (i=0 ; i<count[ML_SIDEDEFS] ; i++, sd++)
+    {
+	if ((unsigned short)SHORT(sd->sector) >= count[ML_SECTORS])
+	    Error (wad, "%s sidedef %i has bad sector %i", map, i,
+		   SHORT(sd->sector));
+
+	// textures may come from the IWAD when this is a PWAD
+	if (!IsTexture (wad, sd->toptexture)
+	    || !IsTexture (wad, sd->bottomtexture)
+	    || !IsTexture (wad, sd->midtexture))
+	{
+	    if (wad->iwad)
+		Error (wad, "%s sidedef %i has an unknown texture", map, i);
+	    else if (!wad->numtextures)
+		continue;
+	    else
+		Warn (wad, "%s sidedef %i has a texture not in this WAD",
+		      map, i);
+	}
+    }
+
+    seg = (mapseg_t *)LumpData (wad, label+ML_SEGS);
+    for (i=0 ; i<count[ML_SEGS] ; i++, seg++)
+    {
+	if ((unsigned short)SHORT(seg->v1) >= count[ML_VERTEXES]
+	    || (unsigned short)SHORT(seg->v2) >= count[ML_VERTEXES])
+	    Error (wad, "%s seg %i has a bad vertex", map, i);
+	if ((unsigned short)SHORT(seg->linedef) >= count[ML_LINEDEFS])
+	    Error (wad, "%s seg %i has bad linedef %i", map, i,
+		   SHORT(seg->linedef));
+	else
+	{
+	    ld = (maplinedef_t *)LumpData (wad, label+ML_LINEDEFS);
+	    ld += SHORT(seg->linedef);
+	    side = SHORT(seg->side);
+	    if ((side != 0 && side != 1) || SHORT(ld->sidenum[side]) == -1)
+		Error (wad, "%s seg %i uses a missing side", map, i);
+	}
+    }
+
+    ss = (mapsubsector_t *)LumpData (wad, label+ML_SSECTORS);
+    for (i=0 ; i<count[ML_SSECTORS] ; i++, ss++)
+    {
+	if (SHORT(ss->numsegs) <= 0
+	    || (unsigned short)SHORT(ss->firstseg) + SHORT(ss->numsegs)
+	       > count[ML_SEGS])
+	    Error (wad, "%s subsector %i has bad segs", map, i);
+    }
+
+    node = (mapnode_t *)LumpData (wad, label+ML_NODES);
+    for (i=0 ; i<count[ML_NODES] ; i++, node++)
+    {
+	for (j=0 ; j<2 ; j++)
+	{
+	    child = (unsigned short)SHORT(node->children[j]);
+	    if (child & NF_SUBSECTOR
+		? (child & ~NF_SUBSECTOR) >= count[ML_SSECTORS]
+		: child >= count[ML_NODES])
+		Error (wad, "%s node %i has bad child %i", map, i, child);
+	}
+    }
+
+    if (!count[ML_NODES] && count[ML_SSECTORS] != 1)
+	Error (wad, "%s has no nodes", map);
+
+    if (count[ML_REJECT]
+	< (count[ML_SECTORS]*count[ML_SECTORS]+7)/8)
+	Warn (wad, "%s REJECT is short", map);
+
+    bmap = (short *)LumpData (wad, label+ML_BLOCKMAP);
+    if (count[ML_BLOCKMAP] < 4
+	|| count[ML_BLOCKMAP] < 4 + SHORT(bmap[2])*SHORT(bmap[3]))
+	Error (wad, "%s BLOCKMAP is short", map);
+    else
+    {
+	j = SHORT(bmap[2])*SHORT(bmap[3]);
+	for (i=0 ; i<j ; i++)
+	    if ((unsigned short)SHORT(bmap[4+i]) >= count[ML_BLOCKMAP])
+	    {
+		Error (wad, "%s BLOCKMAP cell %i is outside the lump", map, i);
+		break;
+	    }
+    }
+
+    if (!count[ML_THINGS])
+	Warn (wad, "%s has no things", map);
+}
+
+
+static void CheckMaps (wadcheck_t* wad)
+{
+    char	name[9];
+    int		i;
+
+    for (i=0 ; i<wad->numlumps ; i++)
+    {
+	memcpy (name, wad->lumps[i].name, 8);
+	name[8] = 0;
+	if (IsMapName (name))
+	    CheckMap (wad, i);
+    }
+}
+
+
+
+//
+// SPRITES
+// Same rules as R_InstallSpriteLump/R_InitSpriteDefs.
+// A PWAD may replace only some frames of an IWAD sprite,
+//  so there gaps are only warnings.
+//
+static void
+AddSpriteFrame
+( wadcheck_t*	wad,
+  checksprite_t* spr,
+  char*		lumpname,
+  int		frame,
+  int		rotation )
+{
+    if (frame < 0 || frame >= MAXSPRFRAMES || rotation < 0 || rotation > 8)
+    {
+	Error (wad, "sprite lump %.8s has a bad frame or rotation", lumpname);
+	return;
+    }
+
+    if (frame > spr->maxframe)
+	spr->maxframe = frame;
+
+    if (rotation == 0)
+    {
+	if (spr->rotations[frame] & 0x1fe)
+	    Error (wad, "sprite %.4s frame %c has rotations and a rot=0 lump",
+		   spr->name, 'A'+frame);
+	else if (spr->rotations[frame] & 1)
+	    Error (wad, "sprite %.4s frame %c has multiple rot=0 lumps",
+		   spr->name, 'A'+frame);
+	spr->rotations[frame] |= 1;
+	return;
+    }
+
+    if (spr->rotations[frame] & 1)
+	Error (wad, "sprite %.4s frame %c has rotations and a rot=0 lump",
+	       spr->name, 'A'+frame);
+    spr->rotations[frame] |= 1<<rotation;
+}
+
+
+static void CheckSprites (wadcheck_t* wad)
+{
+    checksprite_t*	sprites;
+    checksprite_t*	spr;
+    char*		name;
+    int			numsprites;
+    int			start;
+    int			end;
+    int			frame;
+    int			i;
+    int			j;
+
+    start = FindLump (wad, "S_START", 0, wad->numlumps);
+    if (start == -1)
+	start = FindLump (wad, "SS_START", 0, wad->numlumps);
+    if (start == -1)
+	return;
+
+    end = FindLump (wad, "S_END", start, wad->numlumps);
+    if (end == -1)
+	end = FindLump (wad, "SS_END", start, wad->numlumps);
+    if (end == -1)
+    {
+	Error (wad, "sprites have no S_END");
+	return;
+    }
+
+    sprites = calloc (MAXSPRITES, sizeof(*sprites));
+    numsprites = 0;
+    for (i=start+1 ; i<end ; i++)
+    {
+	name = wad->lumps[i].name;
+	if (!LumpSize (wad, i))
+	    continue;	// nested markers
+
+	for (j=0 ; j<numsprites ; j++)
+	    if (!strncasecmp (sprites[j].name, name, 4))
+		break;
+	if (j == numsprites)
+	{
+	    if (numsprites == MAXSPRITES)
+	    {
+		Error (wad, "more than %i sprites", MAXSPRITES);
+		break;
+	    }
+	    memcpy (sprites[numsprites].name, name, 4);
+	    sprites[numsprites].maxframe = -1;
+	    numsprites++;
+	}
+	spr = &sprites[j];
+
+	AddSpriteFrame (wad, spr, name,
+			toupper (name[4]) - 'A', name[5] - '0');
+	if (name[6])
+	    AddSpriteFrame (wad, spr, name,
+			    toupper (name[6]) - 'A', name[7] - '0');
+    }
+
+    for (i=0, spr = sprites ; i<numsprites ; i++, spr++)
+    {
+	for (frame=0 ; frame<=spr->maxframe ; frame++)
+	{
+	    if (spr->rotations[frame] == 1
+		|| spr->rotations[frame] == 0x1fe)
+		continue;
+
+	    if (wad->iwad)
+		Error (wad, "sprite %.4s frame %c is incomplete",
+		       spr->name, 'A'+frame);
+	    else
+		Warn (wad, "sprite %.4s frame %c is incomplete in this WAD",
+		      spr->name, 'A'+frame);
+	}
+    }
+
+    free (sprites);
+}
+
+
+
+//
+// CheckWad
+//
+static void CheckWad (wadcheck_t* wad)
+{
+    struct stat	fileinfo;
+    int		handle;
+
+    handle = open (wad->path, O_RDONLY);
+    if (handle == -1 || fstat (handle, &fileinfo) == -1)
+    {
+	Error (wad, "couldn't open");
+	return;
+    }
+
+    wad->size = fileinfo.st_size;
+    wad->data = malloc (wad->size ? wad->size : 1);
+    if (!wad->data || read (handle, wad->data, wad->size) != wad->size)
+    {
+	Error (wad, "couldn't read");
+	close (handle);
+	return;
+    }
+    close (handle);
+
+    if (CheckDirectory (wad))
+    {
+	CheckTextures (wad);
+	CheckMaps (wad);
+	CheckSprites (wad);
+    }
+
+    free (wad->data);
+    free (wad->texnames);
+    wad->data = NULL;
+    wad->texnames = NULL;
+}
+
+
+static void* CheckThread (void* unused)
+{
+    int		i;
+
+    while (1)
+    {
+	pthread_mutex_lock (&nextwadlock);
+	i = nextwad++;
+	pthread_mutex_unlock (&nextwadlock);
+
+	if (i >= numwads)
+	    return NULL;
+	CheckWad (&wads[i]);
+    }
+}
+
+
+
+//
+// AddPath
+// A directory adds every .wad in it.
+//
+static void AddPath (char* path)
+{
+    struct stat		fileinfo;
+    struct dirent*	entry;
+    DIR*		dir;
+    char*		name;
+    int			length;
+
+    if (!stat (path, &fileinfo) && S_ISDIR (fileinfo.st_mode))
+    {
+	dir = opendir (path);
+	if (!dir)
+	    return;
+
+	while ( (entry = readdir (dir)) )
+	{
+	    length = strlen (entry->d_name);
+	    if (length < 4
+		|| strcasecmp (entry->d_name+length-4, ".wad"))
+		continue;
+
+	    name = malloc (strlen (path) + length + 2);
+	    sprintf (name, "%s/%s", path, entry->d_name);
+	    AddPath (name);
+	}
+	closedir (dir);
+	return;
+    }
+
+    if (numwads == MAXWADS)
+    {
+	fprintf (stderr, "wadcheck: more than %i WADs\n", MAXWADS);
+	exit (1);
+    }
+    wads[numwads++].path = path;
+}
+
+
+int main (int argc, char** argv)
+{
+    pthread_t	threads[MAXTHREADS];
+    int		numthreads;
+    int		errors;
+    int		i;
+
+    numthreads = sysconf (_SC_NPROCESSORS_ONLN);
+
+    for (i=1 ; i<argc ; i++)
+    {
+	if (!strcmp (argv[i], "-j") && i < argc-1)
+	    numthreads = atoi (argv[++i]);
+	else
+	    AddPath (argv[i]);
+    }
+
+    if (!numwads)
+    {
+	fprintf (stderr,
+		 "usage: wadcheck [-j threads] file.wad|dir ...\n");
+	return 1;
+    }
+
+    if (numthreads < 1)
+	numthreads = 1;
+    if (numthreads > MAXTHREADS)
+	numthreads = MAXTHREADS;
+    if (numthreads > numwads)
+	numthreads = numwads;
+
+    for (i=0 ; i<numthreads ; i++)
+	pthread_create (&threads[i], NULL, CheckThread, NULL);
+    for (i=0 ; i<numthreads ; i++)
+	pthread_join (threads[i], NULL);
+
+    errors = 0;
+    for (i=0 ; i<numwads ; i++)
+    {
+	if (wads[i].report)
+	    fputs (wads[i].report, stdout);
+	printf ("%s: %i errors, %i warnings\n",
+		wads[i].path, wads[i].errors, wads[i].warnings);
+	errors += wads[i].errors;
+    }
+
+    return errors != 0;
+}
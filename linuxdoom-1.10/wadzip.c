@@ -0,0 +1,407 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	WAD packer, a standalone tool.
+//	  wadzip [-level n] in.wad out.wad
+//	Writes a packed WAD (PACKEDID) that W_AddFile reads like
+//	any other: every lump that gets smaller is deflated on
+//	its own, so the game unpacks only the lumps it loads.
+//	  wadzip -bench file.wad ...
+//	Drops each file from the page cache, reads every lump
+//	the way W_ReadLump would and prints the time and the
+//	bytes read, to compare a packed WAD with the raw one.
+//
+//-----------------------------------------------------------------------------
+
+static const char
+rcsid[] = "$Id:$";
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "doomtype.h"
+#include "m_swap.h"
+#include "w_wad.h"
+
+
+// as W_UnpackLump
+#define PACKEDCHUNK	16384
+
+// not worth a zlib stream
+#define MINPACKED	64
+
+
+typedef struct
+{
+    char*		path;
+    byte*		data;
+    int			size;
+
+    int			numlumps;
+    packedlump_t*	lumps;	// native byte order
+    boolean		packed;
+
+} wadfile_t;
+
+
+static int Microseconds (void)
+{
+    struct timeval	tp;
+
+    gettimeofday (&tp, NULL);
+    return (int)((unsigned)tp.tv_sec*1000000u + (unsigned)tp.tv_usec);
+}
+
+
+//
+// ReadWad
+// Reads the whole file and its directory, raw or packed.
+//
+static boolean ReadWad (wadfile_t* wad)
+{
+    struct stat		fileinfo;
+    wadinfo_t*		header;
+    filelump_t*		raw;
+    packedlump_t*	packed;
+    int			entry;
+    int			handle;
+    int			i;
+
+    handle = open (wad->path, O_RDONLY);
+    if (handle == -1 || fstat (handle, &fileinfo) == -1)
+    {
+	fprintf (stderr, "wadzip: couldn't open %s\n", wad->path);
+	return false;
+    }
+
+    wad->size = fileinfo.st_size;
+    wad->data = malloc (wad->size ? wad->size : 1);
+    if (!wad->data || read (handle, wad->data, wad->size) != wad->size)
+    {
+	fprintf (stderr, "wadzip: couldn't read %s\n", wad->path);
+	close (handle);
+	return false;
+    }
+    close (handle);
+
+    header = (wadinfo_t *)wad->data;
+    if (wad->size < sizeof(*header)
+	|| (strncmp (header->identification, "IWAD", 4)
+	    && strncmp (header->identification, "PWAD", 4)
+	    && strncmp (header->identification, PACKEDID, 4)))
+    {
+	fprintf (stderr, "wadzip: %s is not a WAD\n", wad->path);
+	return false;
+    }
+
+    wad->packed = !strncmp (header->identification, PACKEDID, 4);
+    entry = wad->packed ? sizeof(packedlump_t) : sizeof(filelump_t);
+    wad->numlumps = LONG(header->numlumps);
+    if (wad->numlumps < 0
+	|| LONG(header->infotableofs) < sizeof(*header)
+	|| wad->numlumps > (wad->size - LONG(header->infotableofs))/entry)
+    {
+	fprintf (stderr, "wadzip: %s has a bad directory\n", wad->path);
+	return false;
+    }
+
+    wad->lumps = malloc (wad->numlumps*sizeof(packedlump_t) + 1);
+    raw = (filelump_t *)(wad->data + LONG(header->infotableofs));
+    packed = (packedlump_t *)raw;
+
+    for (i=0 ; i<wad->numlumps ; i++)
+    {
+	if (wad->packed)
+	{
+	    wad->lumps[i].filepos = LONG(packed[i].filepos);
+	    wad->lumps[i].size = LONG(packed[i].size);
+	    wad->lumps[i].packedsize = LONG(packed[i].packedsize);
+	    memcpy (wad->lumps[i].name, packed[i].name, 8);
+	}
+	else
+	{
+	    wad->lumps[i].filepos = LONG(raw[i].filepos);
+	    wad->lumps[i].size = LONG(raw[i].size);
+	    wad->lumps[i].packedsize = 0;
+	    memcpy (wad->lumps[i].name, raw[i].name, 8);
+	}
+
+	if (wad->lumps[i].filepos < 0
+	    || wad->lumps[i].size < 0
+	    || wad->lumps[i].packedsize < 0
+	    || wad->lumps[i].filepos > wad->size
+	    - (wad->lumps[i].packedsize ? wad->lumps[i].packedsize
+	       : wad->lumps[i].size))
+	{
+	    fprintf (stderr, "wadzip: lump %i (%.8s) of %s is outside "
+		     "the file\n", i, wad->lumps[i].name, wad->path);
+	    return false;
+	}
+    }
+
+    return true;
+}
+
+
+//
+// Pack
+//
+static int
+Pack
+( char*		inname,
+  char*		outname,
+  int		level )
+{
+    wadfile_t		wad;
+    wadinfo_t		header;
+    packedlump_t*	out;
+    byte*		buffer;
+    uLongf		length;
+    FILE*		f;
+    int			position;
+    int			packedcount;
+    int			i;
+
+    memset (&wad, 0, sizeof(wad));
+    wad.path = inname;
+    if (!ReadWad (&wad))
+	return 1;
+    if (wad.packed)
+    {
+	fprintf (stderr, "wadzip: %s is packed already\n", inname);
+	return 1;
+    }
+
+    f = fopen (outname, "wb");
+    if (!f)
+    {
+	fprintf (stderr, "wadzip: couldn't write %s\n", outname);
+	return 1;
+    }
+
+    out = malloc (wad.numlumps*sizeof(*out) + 1);
+    buffer = malloc (compressBound (wad.size) + 1);
+    if (!out || !buffer)
+    {
+	fprintf (stderr, "wadzip: no memory for %s\n", inname);
+	return 1;
+    }
+
+    // header is written again once the directory is placed
+    memset (&header, 0, sizeof(header));
+    fwrite (&header, sizeof(header), 1, f);
+    position = sizeof(header);
+    packedcount = 0;
+
+    for (i=0 ; i<wad.numlumps ; i++)
+    {
+	memcpy (out[i].name, wad.lumps[i].name, 8);
+	out[i].filepos = LONG(position);
+	out[i].size = LONG(wad.lumps[i].size);
+	out[i].packedsize = 0;
+
+	length = compressBound (wad.lumps[i].size);
+	if (wad.lumps[i].size >= MINPACKED
+	    && compress2 (buffer, &length,
+			  wad.data + wad.lumps[i].filepos,
+			  wad.lumps[i].size, level) == Z_OK
+	    && length < wad.lumps[i].size)
+	{
+	    fwrite (buffer, length, 1, f);
+	    out[i].packedsize = LONG((int)length);
+	    position += length;
+	    packedcount++;
+	}
+	else
+	{
+	    fwrite (wad.data + wad.lumps[i].filepos,
+		    wad.lumps[i].size, 1, f);
+	    position += wad.lumps[i].size;
+	}
+    }
+
+    fwrite (out, sizeof(*out), wad.numlumps, f);
+
+    memcpy (header.identification, PACKEDID, 4);
+    header.numlumps = LONG(wad.numlumps);
+    header.infotableofs = LONG(position);
+    fseek (f, 0, SEEK_SET);
+    fwrite (&header, sizeof(header), 1, f);
+
+    if (ferror (f) | fclose (f))
+    {
+	fprintf (stderr, "wadzip: couldn't write %s\n", outname);
+	return 1;
+    }
+
+    position += wad.numlumps*sizeof(*out);
+    printf ("%s: %i lumps, %i packed, %i kB to %i kB (%.1f%%)\n",
+	    outname, wad.numlumps, packedcount,
+	    wad.size/1024, position/1024,
+	    wad.size ? 100.0*position/wad.size : 100.0);
+    return 0;
+}
+
+
+//
+// Bench
+// Cold read of every lump of a WAD, as the game does it:
+//  one read per stored lump, packed ones unpacked
+//  PACKEDCHUNK bytes at a time.
+//
+static int Bench (char* path)
+{
+    wadfile_t	wad;
+    z_stream	zs;
+    byte	chunk[PACKEDCHUNK];
+    byte*	dest;
+    long long	diskbytes;
+    long long	lumpbytes;
+    int		handle;
+    int		start;
+    int		time;
+    int		position;
+    int		left;
+    int		c;
+    int		i;
+
+    memset (&wad, 0, sizeof(wad));
+    wad.path = path;
+    if (!ReadWad (&wad))
+	return 1;
+    free (wad.data);
+
+    handle = open (path, O_RDONLY);
+    if (handle == -1)
+	return 1;
+
+    // cold start, as far as this file goes
+    fdatasync (handle);
+    posix_fadvise (handle, 0, 0, POSIX_FADV_DONTNEED);
+
+    c = 0;
+    for (i=0 ; i<wad.numlumps ; i++)
+	if (wad.lumps[i].size > c)
+	    c = wad.lumps[i].size;
+    dest = malloc (c + 1);
+    if (!dest)
+    {
+	fprintf (stderr, "wadzip: no memory for %s\n", path);
+	return 1;
+    }
+
+    diskbytes = lumpbytes = 0;
+    start = Microseconds ();
+
+    for (i=0 ; i<wad.numlumps ; i++)
+    {
+	if (!wad.lumps[i].packedsize)
+	{
+	    if (pread (handle, dest, wad.lumps[i].size,
+		       wad.lumps[i].filepos) != wad.lumps[i].size)
+	    {
+		fprintf (stderr, "wadzip: couldn't read %.8s\n",
+			 wad.lumps[i].name);
+		return 1;
+	    }
+	    diskbytes += wad.lumps[i].size;
+	    lumpbytes += wad.lumps[i].size;
+	    continue;
+	}
+
+	memset (&zs, 0, sizeof(zs));
+	inflateInit (&zs);
+	zs.next_out = dest;
+	zs.avail_out = wad.lumps[i].size;
+	position = wad.lumps[i].filepos;
+	left = wad.lumps[i].packedsize;
+	c = Z_OK;
+
+	while (left && c == Z_OK)
+	{
+	    zs.avail_in = left < PACKEDCHUNK ? left : PACKEDCHUNK;
+	    zs.next_in = chunk;
+	    if (pread (handle, chunk, zs.avail_in, position) != zs.avail_in)
+		break;
+	    position += zs.avail_in;
+	    left -= zs.avail_in;
+	    c = inflate (&zs, Z_NO_FLUSH);
+	}
+	inflateEnd (&zs);
+
+	if (c != Z_STREAM_END || zs.total_out != wad.lumps[i].size)
+	{
+	    fprintf (stderr, "wadzip: %.8s is damaged\n", wad.lumps[i].name);
+	    return 1;
+	}
+	diskbytes += wad.lumps[i].packedsize;
+	lumpbytes += wad.lumps[i].size;
+    }
+
+    time = Microseconds () - start;
+    close (handle);
+    free (dest);
+
+    printf ("%s: %s, %i lumps, %lli kB read, %lli kB of lumps, "
+	    "%i ms, %.1f MB/s of lumps\n",
+	    path, wad.packed ? "packed" : "raw", wad.numlumps,
+	    diskbytes/1024, lumpbytes/1024, time/1000,
+	    time ? (double)lumpbytes/time : 0.0);
+    return 0;
+}
+
+
+int main (int argc, char** argv)
+{
+    int		level;
+    int		errors;
+    int		i;
+
+    if (argc > 2 && !strcmp (argv[1], "-bench"))
+    {
+	errors = 0;
+	for (i=2 ; i<argc ; i++)
+	    errors |= Bench (argv[i]);
+	return errors;
+    }
+
+    level = Z_BEST_COMPRESSION;
+    i = 1;
+    if (argc > 2 && !strcmp (argv[1], "-level"))
+    {
+	level = atoi (argv[2]);
+	i = 3;
+    }
+
+    if (argc - i != 2)
+    {
+	fprintf (stderr,
+		 "usage: wadzip [-level n] in.wad out.wad\n"
+		 "       wadzip -bench file.wad ...\n");
+	return 1;
+    }
+
+    return Pack (argv[i], argv[i+1], level);
+}
@@ -24,8 +24,12 @@
 static const char
 rcsid[] = "$Id: z_zone.c,v 1.4 1997/02/03 16:47:58 b1 Exp $";
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "z_zone.h"
 #include "i_system.h"
+#include "m_argv.h"
 #include "doomdef.h"
 
 
@@ -38,9 +42,23 @@ rcsid[] = "$Id: z_zone.c,v 1.4 1997/02/03 16:47:58 b1 Exp $";
 //
 // It is of no value to free a cachable block,
 //  because it will get overwritten automatically if needed.
+// Cachable blocks are purged roughly least recently used
+//  first: Z_Malloc first looks for room past only blocks
+//  that have not been touched for a while, then past ones
+//  not touched this frame, then in a new region, and only
+//  then purges what the frame is using.
+//
+// The zone is one or more regions, each a list as above.
+// When no region has room, a new one is asked from the system
+//  with I_ZoneGrow, up to its cap; only then does Z_Malloc fail.
+//
+// PU_LEVEL and PU_LEVSPEC blocks come from the level arena
+//  instead, see below, and only go in the zone when the
+//  arena can't grow.
 // 
  
 #define ZONEID	0x1d4a11
+#define MAXZONES	64
 
 
 typedef struct
@@ -57,8 +75,285 @@ typedef struct
 
 
 
+// region tried first, the last one that had room
 memzone_t*	mainzone;
 
+memzone_t*	zones[MAXZONES];
+int		numzones;
+
+// statistics
+static int	zonepurges;
+static int	zonepurgedbytes;
+static int	zonegrows;
+static int	zonestatstics;
+static int	zonestatslast;
+static int	levelfreetime;
+
+int		zoneclock;
+
+// purge passes, by frames a block has gone unused;
+//  the zone grows before the last one
+static int	purgeages[] = { TICRATE*8, TICRATE, 1, 0 };
+#define NUMPURGEAGES	(sizeof(purgeages)/sizeof(*purgeages))
+
+// reading purged lumps again; not counted in the frame
+//  a level is loaded in
+#define HITCHUS		2000
+
+static int	rereads;
+static int	rereadbytes;
+static int	hitches;
+static int	framereadtime;
+static boolean	levelframe;
+
+#define LEVELTAG(tag)	((tag) == PU_LEVEL || (tag) == PU_LEVSPEC)
+
+// level blocks that are in the zone, not the arena:
+//  those the full arena turned away, and cached lumps
+//  a level took over. Unordered, a block knows its slot.
+static memblock_t**	zonelevel;
+static int		numzonelevel;
+static int		maxzonelevel;
+
+
+static void Z_AddZoneLevel (memblock_t* block)
+{
+    if (numzonelevel == maxzonelevel)
+    {
+	maxzonelevel = maxzonelevel ? maxzonelevel*2 : 256;
+	zonelevel = realloc (zonelevel, maxzonelevel*sizeof(*zonelevel));
+	if (!zonelevel)
+	    I_Error ("Z_AddZoneLevel: no memory for %i blocks",
+		     maxzonelevel);
+    }
+    block->levelslot = numzonelevel;
+    zonelevel[numzonelevel++] = block;
+}
+
+
+static void Z_RemoveZoneLevel (memblock_t* block)
+{
+    memblock_t*	last;
+
+    last = zonelevel[--numzonelevel];
+    zonelevel[block->levelslot] = last;
+    last->levelslot = block->levelslot;
+}
+
+
+
+//
+// LEVEL ARENA
+// Level blocks are cut off the front of a few large chunks,
+//  one after another, with the same header as zone blocks,
+//  so Z_Free, Z_ChangeTag and owners work as they do there.
+// Freed blocks are kept on lists by size and handed out
+//  again, as mobjs and specials come and go all level long.
+// Owned blocks are also linked through next and prev, so
+//  freeing both level tags only has to tell the owners;
+//  the rest goes at once, and the chunks stay for the next
+//  level.
+//
+#define MAXARENACHUNKS	32
+
+// freed blocks up to this size, header included,
+//  are kept by exact size, larger ones on one list
+#define ARENABINMAX	2048
+#define ARENABINS	(ARENABINMAX/8+1)
+
+typedef struct
+{
+    int		size;		// including this header
+    int		used;
+
+} arenachunk_t;
+
+
+static arenachunk_t*	arenachunks[MAXARENACHUNKS];
+static int		numarenachunks;
+static int		arenachunk;	// the one being cut
+
+static memblock_t*	arenafree[ARENABINS];
+static memblock_t*	arenabigfree;
+
+static memblock_t	arenaowned = { 0, NULL, 0, 0, &arenaowned, &arenaowned };
+
+#define ARENAFIRST	((sizeof(arenachunk_t)+7) & ~7)
+
+
+
+//
+// Z_InArena
+//
+static boolean Z_InArena (memblock_t* block)
+{
+    int		i;
+
+    for (i=0 ; i<numarenachunks ; i++)
+	if ((byte *)block >= (byte *)arenachunks[i]
+	    && (byte *)block < (byte *)arenachunks[i] + arenachunks[i]->size)
+	    return true;
+    return false;
+}
+
+
+//
+// Z_ArenaBlock
+// A block of size bytes, header included, or NULL.
+//
+static memblock_t* Z_ArenaBlock (int size)
+{
+    memblock_t*		block;
+    memblock_t**	link;
+    arenachunk_t*	chunk;
+    int			chunksize;
+
+    // one freed before
+    if (size <= ARENABINMAX)
+    {
+	block = arenafree[size>>3];
+	if (block)
+	{
+	    arenafree[size>>3] = block->next;
+	    return block;
+	}
+    }
+    else
+    {
+	for (link = &arenabigfree ; *link ; link = &(*link)->next)
+	    if ((*link)->size >= size)
+	    {
+		block = *link;
+		*link = block->next;
+		return block;
+	    }
+    }
+
+    // off the end of a chunk, the ones after the current
+    //  one are empty
+    for ( ; arenachunk<numarenachunks ; arenachunk++)
+    {
+	chunk = arenachunks[arenachunk];
+	if (chunk->size - chunk->used >= size)
+	{
+	    block = (memblock_t *)((byte *)chunk + chunk->used);
+	    block->size = size;
+	    chunk->used += size;
+	    return block;
+	}
+    }
+
+    // a new chunk, counted against the zone's cap
+    if (numarenachunks == MAXARENACHUNKS)
+	return NULL;
+
+    chunksize = size + ARENAFIRST;
+    chunk = (arenachunk_t *)I_ZoneGrow (&chunksize);
+    if (!chunk)
+	return NULL;
+
+    chunk->size = chunksize;
+    chunk->used = ARENAFIRST;
+    arenachunks[numarenachunks++] = chunk;
+    arenachunk = numarenachunks-1;
+
+    block = (memblock_t *)((byte *)chunk + chunk->used);
+    block->size = size;
+    chunk->used += size;
+    return block;
+}
+
+
+//
+// Z_ArenaFree
+//
+static void Z_ArenaFree (memblock_t* block)
+{
+    if (block->user > (void **)0x100)
+    {
+	// clear the user's mark
+	*block->user = 0;
+
+	block->prev->next = block->next;
+	block->next->prev = block->prev;
+    }
+
+    block->user = NULL;
+    block->tag = 0;
+    block->id = 0;
+
+    if (block->size <= ARENABINMAX)
+    {
+	block->next = arenafree[block->size>>3];
+	arenafree[block->size>>3] = block;
+    }
+    else
+    {
+	block->next = arenabigfree;
+	arenabigfree = block;
+    }
+}
+
+
+//
+// Z_ArenaFreeTags
+// Both level tags go at once. Owned blocks a Z_ChangeTag
+//  took out of the range move to the zone.
+//
+static void
+Z_ArenaFreeTags
+( int		lowtag,
+  int		hightag )
+{
+    memblock_t*		block;
+    memblock_t*		next;
+    arenachunk_t*	chunk;
+    byte*		end;
+    int			i;
+
+    if (!numarenachunks)
+	return;
+
+    if (lowtag > PU_LEVEL || hightag < PU_LEVSPEC)
+    {
+	// only some of them, so one by one
+	for (i=0 ; i<numarenachunks ; i++)
+	{
+	    chunk = arenachunks[i];
+	    end = (byte *)chunk + chunk->used;
+	    block = (memblock_t *)((byte *)chunk + ARENAFIRST);
+	    for ( ; (byte *)block < end ;
+		  block = (memblock_t *)((byte *)block + block->size))
+	    {
+		if (block->user
+		    && block->tag >= lowtag && block->tag <= hightag)
+		    Z_ArenaFree (block);
+	    }
+	}
+	return;
+    }
+
+    for (block = arenaowned.next ; block != &arenaowned ; block = next)
+    {
+	next = block->next;
+	if (block->tag >= lowtag && block->tag <= hightag)
+	    *block->user = 0;
+	else
+	    memcpy (Z_Malloc (block->size - sizeof(memblock_t),
+			      block->tag, block->user),
+		    (byte *)block + sizeof(memblock_t),
+		    block->size - sizeof(memblock_t));
+    }
+    arenaowned.next = arenaowned.prev = &arenaowned;
+
+    memset (arenafree, 0, sizeof(arenafree));
+    arenabigfree = NULL;
+
+    for (i=0 ; i<numarenachunks ; i++)
+	arenachunks[i]->used = ARENAFIRST;
+    arenachunk = 0;
+}
+
 
 
 //
@@ -92,27 +387,50 @@ void Z_ClearZone (memzone_t* zone)
 //
 void Z_Init (void)
 {
-    memblock_t*	block;
     int		size;
+    int		p;
 
     mainzone = (memzone_t *)I_ZoneBase (&size);
     mainzone->size = size;
+    Z_ClearZone (mainzone);
 
-    // set the entire zone to one free block
-    mainzone->blocklist.next =
-	mainzone->blocklist.prev =
-	block = (memblock_t *)( (byte *)mainzone + sizeof(memzone_t) );
+    zones[0] = mainzone;
+    numzones = 1;
 
-    mainzone->blocklist.user = (void *)mainzone;
-    mainzone->blocklist.tag = PU_STATIC;
-    mainzone->rover = block;
-	
-    block->prev = block->next = &mainzone->blocklist;
+    // -zonestats [seconds] prints a line now and then
+    p = M_CheckParm ("-zonestats");
+    if (p)
+    {
+	zonestatstics = TICRATE*10;
+	if (p < myargc-1 && atoi (myargv[p+1]) > 0)
+	    zonestatstics = TICRATE*atoi (myargv[p+1]);
+    }
+}
 
-    // NULL indicates a free block.
-    block->user = NULL;
-    
-    block->size = mainzone->size - sizeof(memzone_t);
+
+//
+// Z_AddZone
+// Another region with room for at least size bytes.
+//
+memzone_t* Z_AddZone (int size)
+{
+    memzone_t*	zone;
+
+    if (numzones == MAXZONES)
+	return NULL;
+
+    size += sizeof(memzone_t);
+    zone = (memzone_t *)I_ZoneGrow (&size);
+    if (!zone)
+	return NULL;
+
+    zone->size = size;
+    Z_ClearZone (zone);
+    zones[numzones++] = zone;
+    zonegrows++;
+
+    printf ("Z_Malloc: added %i KB, %i regions\n", size>>10, numzones);
+    return zone;
 }
 
 
@@ -123,11 +441,21 @@ void Z_Free (void* ptr)
 {
     memblock_t*		block;
     memblock_t*		other;
+    int			i;
 	
     block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
 
     if (block->id != ZONEID)
 	I_Error ("Z_Free: freed a pointer without ZONEID");
+
+    if (Z_InArena (block))
+    {
+	Z_ArenaFree (block);
+	return;
+    }
+
+    if (LEVELTAG(block->tag))
+	Z_RemoveZoneLevel (block);
 		
     if (block->user > (void **)0x100)
     {
@@ -152,8 +480,9 @@ void Z_Free (void* ptr)
 	other->next = block->next;
 	other->next->prev = other;
 
-	if (block == mainzone->rover)
-	    mainzone->rover = other;
+	for (i=0 ; i<numzones ; i++)
+	    if (block == zones[i]->rover)
+		zones[i]->rover = other;
 
 	block = other;
     }
@@ -166,45 +495,37 @@ void Z_Free (void* ptr)
 	block->next = other->next;
 	block->next->prev = block;
 
-	if (other == mainzone->rover)
-	    mainzone->rover = block;
+	for (i=0 ; i<numzones ; i++)
+	    if (other == zones[i]->rover)
+		zones[i]->rover = block;
     }
 }
 
 
 
 //
-// Z_Malloc
-// You can pass a NULL user if the tag is < PU_PURGELEVEL.
+// Z_FindBlock
+// A free block of size bytes, header included, in one region,
+//  or NULL. Only purges blocks unused for minage frames.
 //
-#define MINFRAGMENT		64
-
-
-void*
-Z_Malloc
-( int		size,
-  int		tag,
-  void*		user )
+memblock_t*
+Z_FindBlock
+( memzone_t*	zone,
+  int		size,
+  int		minage )
 {
-    int		extra;
     memblock_t*	start;
     memblock_t* rover;
-    memblock_t* newblock;
     memblock_t*	base;
 
-    size = (size + 3) & ~3;
-    
     // scan through the block list,
     // looking for the first free block
     // of sufficient size,
     // throwing out any purgable blocks along the way.
 
-    // account for size of block header
-    size += sizeof(memblock_t);
-    
     // if there is a free block behind the rover,
     //  back up over them
-    base = mainzone->rover;
+    base = zone->rover;
     
     if (!base->prev->user)
 	base = base->prev;
@@ -217,12 +538,13 @@ Z_Malloc
 	if (rover == start)
 	{
 	    // scanned all the way around the list
-	    I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+	    return NULL;
 	}
 	
 	if (rover->user)
 	{
-	    if (rover->tag < PU_PURGELEVEL)
+	    if (rover->tag < PU_PURGELEVEL
+		|| zoneclock - rover->lastuse < minage)
 	    {
 		// hit a block that can't be purged,
 		//  so move base past it
@@ -231,6 +553,8 @@ Z_Malloc
 	    else
 	    {
 		// free the rover block (adding the size to base)
+		zonepurges++;
+		zonepurgedbytes += rover->size;
 
 		// the rover can be the base block
 		base = base->prev;
@@ -243,7 +567,92 @@ Z_Malloc
 	    rover = rover->next;
     } while (base->user || base->size < size);
 
+    return base;
+}
+
+
+//
+// Z_Malloc
+// You can pass a NULL user if the tag is < PU_PURGELEVEL.
+//
+#define MINFRAGMENT		64
+
+
+void*
+Z_Malloc
+( int		size,
+  int		tag,
+  void*		user )
+{
+    int		extra;
+    int		pass;
+    int		i;
+    memzone_t*	zone;
+    memblock_t* newblock;
+    memblock_t*	base;
+
+    size = (size + 3) & ~3;
     
+    // account for size of block header
+    size += sizeof(memblock_t);
+
+    if (LEVELTAG(tag))
+    {
+	base = Z_ArenaBlock ((size + 7) & ~7);
+	if (base)
+	{
+	    if (user)
+	    {
+		base->user = user;
+		*(void **)user = (void *) ((byte *)base + sizeof(memblock_t));
+
+		base->next = arenaowned.next;
+		base->prev = &arenaowned;
+		base->next->prev = base;
+		arenaowned.next = base;
+	    }
+	    else
+		base->user = (void *)2;
+	    base->tag = tag;
+	    base->id = ZONEID;
+	    base->lastuse = zoneclock;
+	    return (void *) ((byte *)base + sizeof(memblock_t));
+	}
+
+	// no room for more chunks, the zone keeps it
+    }
+
+    // the region that had room last time, then the others,
+    //  purging older blocks first, with a new region
+    //  before the last pass
+    base = NULL;
+    for (pass=0 ; !base && pass<NUMPURGEAGES ; pass++)
+    {
+	if (pass == NUMPURGEAGES-1)
+	{
+	    zone = Z_AddZone (size);
+	    if (zone)
+	    {
+		base = Z_FindBlock (zone, size, 0);
+		break;
+	    }
+	}
+
+	zone = mainzone;
+	base = Z_FindBlock (zone, size, purgeages[pass]);
+
+	for (i=0 ; !base && i<numzones ; i++)
+	{
+	    zone = zones[i];
+	    if (zone != mainzone)
+		base = Z_FindBlock (zone, size, purgeages[pass]);
+	}
+    }
+
+    if (!base)
+	I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+    mainzone = zone;
+
     // found a block big enough
     extra = base->size - size;
     
@@ -279,9 +688,12 @@ Z_Malloc
 	base->user = (void *)2;		
     }
     base->tag = tag;
+    base->lastuse = zoneclock;
+    if (LEVELTAG(tag))
+	Z_AddZoneLevel (base);
 
     // next allocation will start looking here
-    mainzone->rover = base->next;	
+    zone->rover = base->next;	
 	
     base->id = ZONEID;
     
@@ -298,23 +710,55 @@ Z_FreeTags
 ( int		lowtag,
   int		hightag )
 {
+    memzone_t*	zone;
     memblock_t*	block;
     memblock_t*	next;
+    int		start;
+    int		i;
+
+    start = I_GetTimeUS ();
+    if (lowtag <= PU_LEVSPEC && hightag >= PU_LEVEL)
+    {
+	Z_ArenaFreeTags (lowtag, hightag);
+	levelframe = true;
+    }
+
+    // no other tags lie between PU_DAVE and PU_PURGELEVEL,
+    //  so the zone's level blocks are all there is to free;
+    //  from the end, as Z_Free moves the last into the slot
+    if (lowtag > PU_DAVE && hightag < PU_PURGELEVEL)
+    {
+	for (i=numzonelevel-1 ; i>=0 ; i--)
+	{
+	    block = zonelevel[i];
+	    if (block->tag >= lowtag && block->tag <= hightag)
+		Z_Free ( (byte *)block+sizeof(memblock_t));
+	}
+	levelfreetime = I_GetTimeUS () - start;
+	return;
+    }
 	
-    for (block = mainzone->blocklist.next ;
-	 block != &mainzone->blocklist ;
-	 block = next)
+    for (i=0 ; i<numzones ; i++)
     {
-	// get link before freeing
-	next = block->next;
+	zone = zones[i];
+	for (block = zone->blocklist.next ;
+	     block != &zone->blocklist ;
+	     block = next)
+	{
+	    // get link before freeing
+	    next = block->next;
 
-	// free block?
-	if (!block->user)
-	    continue;
+	    // free block?
+	    if (!block->user)
+		continue;
 	
-	if (block->tag >= lowtag && block->tag <= hightag)
-	    Z_Free ( (byte *)block+sizeof(memblock_t));
+	    if (block->tag >= lowtag && block->tag <= hightag)
+		Z_Free ( (byte *)block+sizeof(memblock_t));
+	}
     }
+
+    if (lowtag <= PU_LEVSPEC && hightag >= PU_LEVEL)
+	levelfreetime = I_GetTimeUS () - start;
 }
 
 
@@ -328,34 +772,40 @@ Z_DumpHeap
 ( int		lowtag,
   int		hightag )
 {
+    memzone_t*	zone;
     memblock_t*	block;
+    int		i;
 	
-    printf ("zone size: %i  location: %p\n",
-	    mainzone->size,mainzone);
-    
     printf ("tag range: %i to %i\n",
 	    lowtag, hightag);
-	
-    for (block = mainzone->blocklist.next ; ; block = block->next)
+
+    for (i=0 ; i<numzones ; i++)
     {
-	if (block->tag >= lowtag && block->tag <= hightag)
-	    printf ("block:%p    size:%7i    user:%p    tag:%3i\n",
-		    block, block->size, block->user, block->tag);
-		
-	if (block->next == &mainzone->blocklist)
+	zone = zones[i];
+	printf ("zone size: %i  location: %p\n",
+		zone->size,zone);
+	
+	for (block = zone->blocklist.next ; ; block = block->next)
 	{
-	    // all blocks have been hit
-	    break;
-	}
+	    if (block->tag >= lowtag && block->tag <= hightag)
+		printf ("block:%p    size:%7i    user:%p    tag:%3i\n",
+			block, block->size, block->user, block->tag);
+		
+	    if (block->next == &zone->blocklist)
+	    {
+		// all blocks have been hit
+		break;
+	    }
 	
-	if ( (byte *)block + block->size != (byte *)block->next)
-	    printf ("ERROR: block size does not touch the next block\n");
+	    if ( (byte *)block + block->size != (byte *)block->next)
+		printf ("ERROR: block size does not touch the next block\n");
 
-	if ( block->next->prev != block)
-	    printf ("ERROR: next block doesn't have proper back link\n");
+	    if ( block->next->prev != block)
+		printf ("ERROR: next block doesn't have proper back link\n");
 
-	if (!block->user && !block->next->user)
-	    printf ("ERROR: two consecutive free blocks\n");
+	    if (!block->user && !block->next->user)
+		printf ("ERROR: two consecutive free blocks\n");
+	}
     }
 }
 
@@ -365,29 +815,35 @@ Z_DumpHeap
 //
 void Z_FileDumpHeap (FILE* f)
 {
+    memzone_t*	zone;
     memblock_t*	block;
-	
-    fprintf (f,"zone size: %i  location: %p\n",mainzone->size,mainzone);
-	
-    for (block = mainzone->blocklist.next ; ; block = block->next)
+    int		i;
+
+    for (i=0 ; i<numzones ; i++)
     {
-	fprintf (f,"block:%p    size:%7i    user:%p    tag:%3i\n",
-		 block, block->size, block->user, block->tag);
-		
-	if (block->next == &mainzone->blocklist)
+	zone = zones[i];
+	fprintf (f,"zone size: %i  location: %p\n",zone->size,zone);
+	
+	for (block = zone->blocklist.next ; ; block = block->next)
 	{
-	    // all blocks have been hit
-	    break;
-	}
+	    fprintf (f,"block:%p    size:%7i    user:%p    tag:%3i\n",
+		     block, block->size, block->user, block->tag);
+		
+	    if (block->next == &zone->blocklist)
+	    {
+		// all blocks have been hit
+		break;
+	    }
 	
-	if ( (byte *)block + block->size != (byte *)block->next)
-	    fprintf (f,"ERROR: block size does not touch the next block\n");
+	    if ( (byte *)block + block->size != (byte *)block->next)
+		fprintf (f,"ERROR: block size does not touch the next block\n");
 
-	if ( block->next->prev != block)
-	    fprintf (f,"ERROR: next block doesn't have proper back link\n");
+	    if ( block->next->prev != block)
+		fprintf (f,"ERROR: next block doesn't have proper back link\n");
 
-	if (!block->user && !block->next->user)
-	    fprintf (f,"ERROR: two consecutive free blocks\n");
+	    if (!block->user && !block->next->user)
+		fprintf (f,"ERROR: two consecutive free blocks\n");
+	}
     }
 }
 
@@ -398,25 +854,51 @@ void Z_FileDumpHeap (FILE* f)
 //
 void Z_CheckHeap (void)
 {
+    memzone_t*	zone;
     memblock_t*	block;
-	
-    for (block = mainzone->blocklist.next ; ; block = block->next)
+    byte*	end;
+    int		i;
+
+    for (i=0 ; i<numzones ; i++)
     {
-	if (block->next == &mainzone->blocklist)
+	zone = zones[i];
+	for (block = zone->blocklist.next ; ; block = block->next)
 	{
-	    // all blocks have been hit
-	    break;
-	}
+	    if (block->next == &zone->blocklist)
+	    {
+		// all blocks have been hit
+		break;
+	    }
 	
-	if ( (byte *)block + block->size != (byte *)block->next)
-	    I_Error ("Z_CheckHeap: block size does not touch the next block\n");
+	    if ( (byte *)block + block->size != (byte *)block->next)
+		I_Error ("Z_CheckHeap: block size does not touch the next block\n");
+
+	    if ( block->next->prev != block)
+		I_Error ("Z_CheckHeap: next block doesn't have proper back link\n");
+
+	    if (!block->user && !block->next->user)
+		I_Error ("Z_CheckHeap: two consecutive free blocks\n");
+	}
+    }
 
-	if ( block->next->prev != block)
-	    I_Error ("Z_CheckHeap: next block doesn't have proper back link\n");
+    for (i=0 ; i<numarenachunks ; i++)
+    {
+	end = (byte *)arenachunks[i] + arenachunks[i]->used;
+	for (block = (memblock_t *)((byte *)arenachunks[i] + ARENAFIRST) ;
+	     (byte *)block < end ;
+	     block = (memblock_t *)((byte *)block + block->size))
+	{
+	    if (block->size <= 0)
+		I_Error ("Z_CheckHeap: arena block of size %i\n", block->size);
+	}
 
-	if (!block->user && !block->next->user)
-	    I_Error ("Z_CheckHeap: two consecutive free blocks\n");
+	if ((byte *)block != end)
+	    I_Error ("Z_CheckHeap: arena blocks overrun their chunk\n");
     }
+
+    for (i=0 ; i<numzonelevel ; i++)
+	if (zonelevel[i]->levelslot != i || !LEVELTAG(zonelevel[i]->tag))
+	    I_Error ("Z_CheckHeap: zone level block %i is not listed\n", i);
 }
 
 
@@ -440,28 +922,198 @@ Z_ChangeTag2
     if (tag >= PU_PURGELEVEL && (unsigned)block->user < 0x100)
 	I_Error ("Z_ChangeTag: an owner is required for purgable blocks");
 
+    if (!Z_InArena (block))
+    {
+	if (LEVELTAG(tag) && !LEVELTAG(block->tag))
+	    Z_AddZoneLevel (block);
+	else if (!LEVELTAG(tag) && LEVELTAG(block->tag))
+	    Z_RemoveZoneLevel (block);
+    }
+    else if (tag < PU_LEVEL && block->user < (void **)0x100)
+	I_Error ("Z_ChangeTag: an owner is required for level blocks "
+		 "that outlive the level");
+
     block->tag = tag;
 }
 
 
 
+//
+// Z_ChangeUser
+// Hands a block to another owner. Neither owner is
+//  written; the caller points the new one at the block.
+//
+void
+Z_ChangeUser
+( void*		ptr,
+  void**	user )
+{
+    memblock_t*	block;
+	
+    block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+	I_Error ("Z_ChangeUser: changed a pointer without ZONEID");
+
+    if (block->tag >= PU_PURGELEVEL && (unsigned)user < 0x100)
+	I_Error ("Z_ChangeUser: an owner is required for purgable blocks");
+
+    if (Z_InArena (block))
+    {
+	// owned arena blocks are listed
+	if (block->user > (void **)0x100)
+	{
+	    block->prev->next = block->next;
+	    block->next->prev = block->prev;
+	}
+	if (user > (void **)0x100)
+	{
+	    block->next = arenaowned.next;
+	    block->prev = &arenaowned;
+	    block->next->prev = block;
+	    arenaowned.next = block;
+	}
+    }
+
+    block->user = user;
+}
+
+
+
 //
 // Z_FreeMemory
 //
 int Z_FreeMemory (void)
 {
+    zonestats_t		stats;
+
+    Z_GetStats (&stats);
+    return stats.free + stats.purgable;
+}
+
+
+
+//
+// Z_GetStats
+// Walks every region, so not for every tic.
+//
+void Z_GetStats (zonestats_t* stats)
+{
+    memzone_t*		zone;
     memblock_t*		block;
-    int			free;
-	
-    free = 0;
-    
-    for (block = mainzone->blocklist.next ;
-	 block != &mainzone->blocklist;
-	 block = block->next)
+    byte*		end;
+    int			i;
+
+    memset (stats, 0, sizeof(*stats));
+
+    for (i=0 ; i<numzones ; i++)
     {
-	if (!block->user || block->tag >= PU_PURGELEVEL)
-	    free += block->size;
+	zone = zones[i];
+	stats->size += zone->size;
+
+	for (block = zone->blocklist.next ;
+	     block != &zone->blocklist;
+	     block = block->next)
+	{
+	    if (!block->user)
+	    {
+		stats->free += block->size;
+		stats->freeblocks++;
+		if (block->size > stats->largestfree)
+		    stats->largestfree = block->size;
+		continue;
+	    }
+
+	    stats->blocks++;
+	    if (block->tag >= PU_PURGELEVEL)
+		stats->purgable += block->size;
+	    if (block->tag >= 0 && block->tag < NUMZONETAGS)
+		stats->tagsize[block->tag] += block->size;
+	}
     }
-    return free;
+
+    for (i=0 ; i<numarenachunks ; i++)
+    {
+	stats->arenasize += arenachunks[i]->size;
+	stats->arenaused += arenachunks[i]->used - ARENAFIRST;
+
+	end = (byte *)arenachunks[i] + arenachunks[i]->used;
+	for (block = (memblock_t *)((byte *)arenachunks[i] + ARENAFIRST) ;
+	     (byte *)block < end ;
+	     block = (memblock_t *)((byte *)block + block->size))
+	{
+	    if (block->user && block->tag >= 0 && block->tag < NUMZONETAGS)
+		stats->tagsize[block->tag] += block->size;
+	}
+    }
+
+    stats->regions = numzones;
+    stats->levelfreetime = levelfreetime;
+    stats->rereads = rereads;
+    stats->rereadbytes = rereadbytes;
+    stats->hitches = hitches;
+    stats->purges = zonepurges;
+    stats->purgedbytes = zonepurgedbytes;
+    stats->grows = zonegrows;
+
+    // how much of the free space is not in the largest block
+    if (stats->free)
+	stats->fragmentation =
+	    100 - (int)((long long)stats->largestfree*100/stats->free);
 }
 
+
+
+//
+// Z_CountReread
+//
+void Z_CountReread (int bytes, int us)
+{
+    if (levelframe)
+	return;
+
+    rereads++;
+    rereadbytes += bytes;
+    framereadtime += us;
+}
+
+
+//
+// Z_LogStats
+// Called once a frame. Advances zoneclock, counts a hitch
+//  if the frame read purged lumps for too long, and
+//  prints a line every -zonestats seconds.
+//
+void Z_LogStats (void)
+{
+    zonestats_t		stats;
+    int			now;
+
+    zoneclock++;
+    if (framereadtime > HITCHUS)
+	hitches++;
+    framereadtime = 0;
+    levelframe = false;
+
+    if (!zonestatstics)
+	return;
+
+    now = I_GetTime ();
+    if (now - zonestatslast < zonestatstics)
+	return;
+    zonestatslast = now;
+
+    Z_GetStats (&stats);
+    printf ("zone: %i KB in %i regions, %i KB free, largest %i KB, "
+	    "%i%% fragmented, static %i KB, level %i KB, cache %i KB, "
+	    "%i purges (%i KB), arena %i of %i KB, "
+	    "%i rereads (%i KB), %i hitches\n",
+	    stats.size>>10, stats.regions, stats.free>>10,
+	    stats.largestfree>>10, stats.fragmentation,
+	    stats.tagsize[PU_STATIC]>>10,
+	    (stats.tagsize[PU_LEVEL]+stats.tagsize[PU_LEVSPEC])>>10,
+	    stats.tagsize[PU_CACHE]>>10,
+	    stats.purges, stats.purgedbytes>>10,
+	    stats.arenaused>>10, stats.arenasize>>10,
+	    stats.rereads, stats.rereadbytes>>10, stats.hitches);
+}
@@ -52,9 +52,55 @@ void    Z_DumpHeap (int lowtag, int hightag);
 void    Z_FileDumpHeap (FILE *f);
 void    Z_CheckHeap (void);
 void    Z_ChangeTag2 (void *ptr, int tag);
+void    Z_ChangeUser (void *ptr, void **user);
 int     Z_FreeMemory (void);
 
 
+//
+// ZONE STATISTICS
+// Live numbers for all regions, in bytes with headers.
+//
+#define NUMZONETAGS		(PU_CACHE+1)
+
+typedef struct
+{
+    int		size;			// all regions
+    int		regions;
+    int		blocks;			// in use, purgable included
+    int		free;
+    int		freeblocks;
+    int		largestfree;
+    int		fragmentation;		// percent of free not in largest
+    int		purgable;
+    int		tagsize[NUMZONETAGS];	// in use, by purge tag
+
+    // the level arena, not counted above but in tagsize
+    int		arenasize;
+    int		arenaused;		// in use or on its free lists
+
+    // since startup
+    int		purges;
+    int		purgedbytes;
+    int		grows;
+
+    // microseconds the last Z_FreeTags of the level took
+    int		levelfreetime;
+
+    // purged lumps read again while playing, and frames
+    //  that spent over HITCHUS doing it
+    int		rereads;
+    int		rereadbytes;
+    int		hitches;
+
+} zonestats_t;
+
+void	Z_GetStats (zonestats_t* stats);
+void	Z_LogStats (void);
+
+// A purged lump was read again, taking us microseconds.
+void	Z_CountReread (int bytes, int us);
+
+
 typedef struct memblock_s
 {
     int			size;	// including the header and possibly tiny fragments
@@ -63,8 +109,17 @@ typedef struct memblock_s
     int			id;	// should be ZONEID
     struct memblock_s*	next;
     struct memblock_s*	prev;
+    int			lastuse;	// zoneclock, for purging
+    int			levelslot;	// in the zone's level block list
 } memblock_t;
 
+// Frames since startup. Purgable blocks not used
+//  for longest go first.
+extern int	zoneclock;
+
+#define Z_Touch(p) \
+    (((memblock_t *)((byte *)(p) - sizeof(memblock_t)))->lastuse = zoneclock)
+
 //
 // This is used to get the local FILE:LINE info from CPP
 // prior to really call the function in question.